@@ -0,0 +1,196 @@
+/*
+ File: Arena.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+/** \class Arena
+ * \brief Allocates objects of the same type from large blocks and identifies them by 32-bit
+ *        indexes, half the size of a pointer. Objects never move and index 0 is never used, so
+ *        it can stand for none. Runs of consecutive indexes can be reserved from any thread,
+ *        the rest isn't thread-safe. The arena only manages memory: objects are constructed
+ *        with construct() or create() and must be destroyed with destroy() or have their
+ *        destructors called before clear().
+ *
+ */
+template<class T, int BlockBits = 16>
+class Arena
+{
+  public:
+    /** \brief Arena class constructor.
+     *
+     */
+    Arena()
+    : m_blocks{new std::atomic<Slot *>[BLOCKS]()}
+    , m_size  {1}
+    , m_free  {0}
+    {}
+
+    /** \brief Arena class destructor. Frees the memory, the destructors of the objects aren't called.
+     *
+     */
+    ~Arena()
+    { clear(); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /** \brief Reserves the given number of consecutive indexes and returns the first one. Can be
+     *        called from any thread, the objects are constructed later with construct().
+     * \param[in] count Number of indexes.
+     *
+     */
+    std::uint32_t reserve(const std::uint32_t count)
+    {
+      const auto first = m_size.fetch_add(count);
+      if(count == 0) return first;
+      if(first + count < first) throw std::bad_alloc();
+
+      for(auto block = first >> BlockBits; block <= (first + count - 1) >> BlockBits; ++block)
+      {
+        if(!m_blocks[block].load(std::memory_order_acquire)) allocate(block);
+      }
+
+      return first;
+    }
+
+    /** \brief Constructs an object with the given arguments at the given reserved index and returns it.
+     * \param[in] index Reserved index.
+     * \param[in] args Constructor arguments.
+     *
+     */
+    template<class... Args>
+    T *construct(const std::uint32_t index, Args&&... args)
+    {
+      return new (slot(index)) T(std::forward<Args>(args)...);
+    }
+
+    /** \brief Constructs an object with the given arguments, reusing the index of a destroyed
+     *        one if there is any, and returns its index.
+     * \param[in] args Constructor arguments.
+     *
+     */
+    template<class... Args>
+    std::uint32_t create(Args&&... args)
+    {
+      auto index = m_free;
+      if(index != 0) m_free = slot(index)->next;
+      else           index  = reserve(1);
+
+      construct(index, std::forward<Args>(args)...);
+
+      return index;
+    }
+
+    /** \brief Destroys the object at the given index and keeps the index for the next one.
+     * \param[in] index Object index.
+     *
+     */
+    void destroy(const std::uint32_t index)
+    {
+      at(index)->~T();
+
+      slot(index)->next = m_free;
+      m_free = index;
+    }
+
+    /** \brief Returns the object at the given index.
+     * \param[in] index Object index.
+     *
+     */
+    T *at(const std::uint32_t index) const
+    {
+      return reinterpret_cast<T *>(slot(index));
+    }
+
+    /** \brief Returns the number of indexes reserved so far, the destroyed ones included.
+     *
+     */
+    std::uint32_t size() const
+    { return m_size.load() - 1; }
+
+    /** \brief Frees all the memory of the arena.
+     *
+     */
+    void clear()
+    {
+      for(std::uint32_t block = 0; block < BLOCKS; ++block)
+      {
+        std::free(m_blocks[block].exchange(nullptr));
+      }
+
+      m_size = 1;
+      m_free = 0;
+    }
+
+  private:
+    static const std::uint32_t BLOCK_SIZE = 1u << BlockBits;          /** objects of a block.    */
+    static const std::uint32_t BLOCKS     = 1u << (32 - BlockBits);   /** blocks of the indexes. */
+
+    /** \union Slot
+     * \brief Memory of an object, or index of the next free slot once destroyed.
+     *
+     */
+    union Slot
+    {
+      std::uint32_t next;
+      alignas(T) char object[sizeof(T)];
+    };
+
+    /** \brief Returns the slot of the given index.
+     * \param[in] index Object index.
+     *
+     */
+    Slot *slot(const std::uint32_t index) const
+    {
+      return m_blocks[index >> BlockBits].load(std::memory_order_acquire) + (index & (BLOCK_SIZE - 1));
+    }
+
+    /** \brief Allocates the given block unless another thread already did.
+     * \param[in] block Block index.
+     *
+     */
+    void allocate(const std::uint32_t block)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if(m_blocks[block].load()) return;
+
+      // the pages of the block are only backed by memory once they're used.
+      auto memory = static_cast<Slot *>(std::malloc(sizeof(Slot) * BLOCK_SIZE));
+      if(!memory) throw std::bad_alloc();
+
+      m_blocks[block].store(memory, std::memory_order_release);
+    }
+
+    std::unique_ptr<std::atomic<Slot *>[]> m_blocks; /** blocks by index, nullptr until used.     */
+    std::atomic<std::uint32_t>             m_size;   /** next index to reserve.                   */
+    std::uint32_t                          m_free;   /** first index of the list of free slots, 0 if none. */
+    std::mutex                             m_mutex;  /** serializes the block allocations.        */
+};
+
+#endif // ARENA_H_
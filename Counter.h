@@ -0,0 +1,68 @@
+/*
+ File: Counter.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COUNTER_H_
+#define COUNTER_H_
+
+// Qt
+#include <QtGlobal>
+
+// C++
+#include <atomic>
+
+/** \class Counter
+ * \brief Statistics counter with a single writer thread that can be read from any thread.
+ *        Increments are a plain load and store, without the locked instructions of an
+ *        atomic read-modify-write.
+ *
+ */
+class Counter
+{
+  public:
+    /** \brief Counter class constructor.
+     *
+     */
+    Counter()
+    : m_value{0}
+    {}
+
+    /** \brief Adds the given amount to the counter. Only called from the owner thread.
+     * \param[in] amount Amount to add.
+     *
+     */
+    void add(const qint64 amount = 1)
+    { m_value.store(m_value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed); }
+
+    /** \brief Returns the counter value.
+     *
+     */
+    qint64 value() const
+    { return m_value.load(std::memory_order_relaxed); }
+
+    /** \brief Sets the counter to zero.
+     *
+     */
+    void reset()
+    { m_value.store(0, std::memory_order_relaxed); }
+
+  private:
+    std::atomic<qint64> m_value; /** counter value. */
+};
+
+#endif // COUNTER_H_
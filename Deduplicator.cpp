@@ -0,0 +1,398 @@
+/*
+ File: Deduplicator.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "Deduplicator.h"
+#include "DirectoryEnumerator.h"
+
+// Qt
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+
+// C++
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+namespace
+{
+  /** \struct Descriptor
+   * \brief Closes a file descriptor when it goes out of scope.
+   *
+   */
+  struct Descriptor
+  {
+    int fd; /** file descriptor, -1 if none. */
+
+    explicit Descriptor(const int descriptor): fd{descriptor} {};
+    ~Descriptor() { if(fd >= 0) ::close(fd); }
+  };
+
+  //-----------------------------------------------------------------
+  QString systemError()
+  {
+    return QString::fromLocal8Bit(std::strerror(errno));
+  }
+
+  //-----------------------------------------------------------------
+  bool sameTime(const struct timespec &lhs, const struct timespec &rhs)
+  {
+    return lhs.tv_sec == rhs.tv_sec && lhs.tv_nsec == rhs.tv_nsec;
+  }
+
+  //-----------------------------------------------------------------
+  bool unchanged(const struct stat &before, const struct stat &after, const bool linked)
+  {
+    // a new link changes the status time of the file but not its contents.
+    return before.st_size == after.st_size && sameTime(before.st_mtim, after.st_mtim) && (linked || sameTime(before.st_ctim, after.st_ctim));
+  }
+
+  //-----------------------------------------------------------------
+  bool identicalContents(const int lhs, const int rhs, const qint64 size, const int blockSize)
+  {
+    // each worker compares one pair of files at a time.
+    thread_local std::vector<char> lhsBuffer, rhsBuffer;
+    lhsBuffer.resize(blockSize);
+    rhsBuffer.resize(blockSize);
+
+    for(qint64 offset = 0; offset < size;)
+    {
+      const auto length = static_cast<size_t>(std::min<qint64>(blockSize, size - offset));
+      if(::pread(lhs, lhsBuffer.data(), length, offset) != static_cast<ssize_t>(length)) return false;
+      if(::pread(rhs, rhsBuffer.data(), length, offset) != static_cast<ssize_t>(length)) return false;
+      if(std::memcmp(lhsBuffer.data(), rhsBuffer.data(), length) != 0) return false;
+
+      offset += length;
+    }
+
+    return true;
+  }
+
+  //-----------------------------------------------------------------
+  bool readAttributes(const int fd, std::map<std::string, std::string> &attributes)
+  {
+    auto size = ::flistxattr(fd, nullptr, 0);
+    if(size < 0) return errno == ENOTSUP;
+    if(size == 0) return true;
+
+    std::vector<char> names(size);
+    size = ::flistxattr(fd, names.data(), names.size());
+    if(size < 0) return false;
+
+    for(const char *name = names.data(); name < names.data() + size; name += std::strlen(name) + 1)
+    {
+      auto length = ::fgetxattr(fd, name, nullptr, 0);
+      if(length < 0) return false;
+
+      std::vector<char> value(std::max<ssize_t>(length, 1));
+      length = ::fgetxattr(fd, name, value.data(), value.size());
+      if(length < 0) return false;
+
+      attributes[name] = std::string(value.data(), length);
+    }
+
+    return true;
+  }
+
+  //-----------------------------------------------------------------
+  bool sameAttributes(const int lhs, const int rhs)
+  {
+    std::map<std::string, std::string> lhsAttributes, rhsAttributes;
+
+    return readAttributes(lhs, lhsAttributes) && readAttributes(rhs, rhsAttributes) && lhsAttributes == rhsAttributes;
+  }
+
+  //-----------------------------------------------------------------
+  bool copyAttributes(const int source, const int destination)
+  {
+    std::map<std::string, std::string> attributes;
+    if(!readAttributes(source, attributes)) return false;
+
+    for(const auto &attribute: attributes)
+    {
+      if(::fsetxattr(destination, attribute.first.c_str(), attribute.second.data(), attribute.second.size(), 0) != 0) return false;
+    }
+
+    return true;
+  }
+}
+#endif
+
+//--------------------------------------------------------------------
+Deduplicator::Deduplicator(const DeduplicationOptions& options, QObject* parent)
+: QThread    (parent)
+, m_options  (options)
+, m_total    {0}
+, m_processed{0}
+, m_cancelled{false}
+, m_sequence {0}
+{
+}
+
+//--------------------------------------------------------------------
+void Deduplicator::add(const QString& original, const QString& duplicate)
+{
+  // the scan reports paths with native separators and the parents with a trailing one.
+  const auto originalPath  = QDir::cleanPath(QDir::fromNativeSeparators(original));
+  const auto duplicatePath = QDir::cleanPath(QDir::fromNativeSeparators(duplicate));
+
+  if(originalPath != duplicatePath) m_pairs << qMakePair(originalPath, duplicatePath);
+}
+
+//--------------------------------------------------------------------
+bool Deduplicator::isAvailable()
+{
+#ifdef Q_OS_LINUX
+  return true;
+#else
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------
+void Deduplicator::run()
+{
+  m_report = DeduplicationReport();
+  m_tasks.clear();
+
+  for(const auto &pair: m_pairs)
+  {
+    if(m_cancelled) break;
+
+    collect(pair.first, pair.second);
+  }
+
+  std::atomic<int> next{0};
+  std::atomic<qint64> identical{0}, replaced{0}, bytes{0}, shared{0}, skipped{0}, failed{0};
+
+  auto work = [&]()
+  {
+    int index;
+    while(!m_cancelled && (index = next++) < m_tasks.size())
+    {
+      qint64 reclaimed = 0;
+      bool same = false;
+      QString error;
+
+      switch(process(m_tasks.at(index), reclaimed, same, error))
+      {
+        case Outcome::REPLACED: ++replaced; bytes += reclaimed; break;
+        case Outcome::SHARED:   ++shared;  break;
+        case Outcome::SKIPPED:  ++skipped; break;
+        case Outcome::FAILED:
+          ++failed;
+          {
+            QMutexLocker lock(&m_mutex);
+            if(m_report.errors.size() < MAX_ERRORS) m_report.errors << QFile::decodeName(m_tasks.at(index).duplicate) + ": " + error;
+          }
+          break;
+      }
+
+      if(same) ++identical;
+      ++m_processed;
+    }
+  };
+
+  const auto threads = m_options.threads > 0 ? m_options.threads : QThread::idealThreadCount();
+
+  std::vector<std::thread> workers;
+  const auto count = std::min(threads, m_tasks.size());
+  for(int i = 1; i < count; ++i)
+  {
+    workers.emplace_back(work);
+  }
+
+  work();
+
+  for(auto &worker: workers) worker.join();
+
+  m_report.files     = m_processed.load();
+  m_report.identical = identical.load();
+  m_report.replaced  = replaced.load();
+  m_report.bytes     = bytes.load();
+  m_report.shared    = shared.load();
+  m_report.skipped   = skipped.load();
+  m_report.failed    = failed.load();
+
+  m_tasks.clear();
+}
+
+//--------------------------------------------------------------------
+void Deduplicator::collect(const QString& original, const QString& duplicate)
+{
+  // symbolic links are left out, a link replaced by a file wouldn't be the same tree.
+  std::unique_ptr<DirectoryEnumerator> enumerator(DirectoryEnumerator::create(DirectoryEnumerator::Backend::NATIVE));
+  enumerator->setFollowLinks(false);
+
+  QList<QPair<QString, QString>> stack;
+  stack << qMakePair(original, duplicate);
+
+  while(!stack.isEmpty() && !m_cancelled)
+  {
+    const auto directories = stack.takeLast();
+
+    DirectoryEnumerator::Listing listing(true);
+    if(!enumerator->list(directories.second, listing)) continue;
+
+    const auto originalPath  = QFile::encodeName(directories.first) + '/';
+    const auto duplicatePath = QFile::encodeName(directories.second) + '/';
+    for(const auto &name: listing.fileNames)
+    {
+      m_tasks << Task{originalPath + name, duplicatePath + name};
+    }
+
+    for(const auto &name: listing.directories)
+    {
+      stack << qMakePair(directories.first + '/' + name, directories.second + '/' + name);
+    }
+
+    m_total += listing.fileNames.size();
+  }
+}
+
+//--------------------------------------------------------------------
+Deduplicator::Outcome Deduplicator::process(const Task& task, qint64& bytes, bool& identical, QString& error) const
+{
+#ifdef Q_OS_LINUX
+  const Descriptor original{::open(task.original.constData(), O_RDONLY|O_NOFOLLOW|O_CLOEXEC)};
+  const Descriptor duplicate{::open(task.duplicate.constData(), O_RDONLY|O_NOFOLLOW|O_CLOEXEC)};
+  if(original.fd < 0 || duplicate.fd < 0) return Outcome::SKIPPED;
+
+  struct stat originalStat, duplicateStat;
+  if(::fstat(original.fd, &originalStat) != 0 || ::fstat(duplicate.fd, &duplicateStat) != 0) return Outcome::SKIPPED;
+  if(!S_ISREG(originalStat.st_mode) || !S_ISREG(duplicateStat.st_mode)) return Outcome::SKIPPED;
+
+  if(originalStat.st_dev == duplicateStat.st_dev && originalStat.st_ino == duplicateStat.st_ino) return Outcome::SHARED;
+
+  // the other names of a hard linked duplicate would keep its data, nothing would be reclaimed.
+  if(originalStat.st_size != duplicateStat.st_size || originalStat.st_dev != duplicateStat.st_dev || duplicateStat.st_nlink > 1) return Outcome::SKIPPED;
+
+  // a hard link can't keep metadata of its own, so it needs the same one. The access time isn't
+  // compared, reading the files changes it.
+  const auto hardlink = m_options.method == DeduplicationOptions::Method::HARDLINK;
+  if(hardlink && (originalStat.st_mode != duplicateStat.st_mode || originalStat.st_uid != duplicateStat.st_uid || originalStat.st_gid != duplicateStat.st_gid ||
+                  !sameTime(originalStat.st_mtim, duplicateStat.st_mtim) || !sameAttributes(original.fd, duplicate.fd)))
+  {
+    return Outcome::SKIPPED;
+  }
+
+  if(!identicalContents(original.fd, duplicate.fd, duplicateStat.st_size, BLOCK_SIZE)) return Outcome::SKIPPED;
+
+  identical = true;
+
+  if(m_options.dryRun)
+  {
+    bytes = duplicateStat.st_size;
+    return Outcome::REPLACED;
+  }
+
+  // the replacement is made next to the duplicate and renamed over it, never in place.
+  const auto separator = task.duplicate.lastIndexOf('/');
+  const auto directory = task.duplicate.left(separator + 1);
+  const auto temporary = directory + '.' + task.duplicate.mid(separator + 1) + '.' + QByteArray::number(::getpid()) + '-' + QByteArray::number(m_sequence++) + ".dedup";
+
+  auto fail = [&error, &temporary](const QString &message)
+  {
+    error = message;
+    ::unlink(temporary.constData());
+    return Outcome::FAILED;
+  };
+
+  if(hardlink)
+  {
+    if(::link(task.original.constData(), temporary.constData()) != 0)
+    {
+      error = QObject::tr("Unable to create the hard link: %1").arg(systemError());
+      return Outcome::FAILED;
+    }
+
+    struct stat linkStat;
+    if(::lstat(temporary.constData(), &linkStat) != 0 || linkStat.st_ino != originalStat.st_ino) return fail(QObject::tr("The original file was replaced."));
+  }
+  else
+  {
+    const Descriptor clone{::open(temporary.constData(), O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0600)};
+    if(clone.fd < 0)
+    {
+      error = QObject::tr("Unable to create the clone: %1").arg(systemError());
+      return Outcome::FAILED;
+    }
+
+    if(::ioctl(clone.fd, FICLONE, original.fd) != 0) return fail(QObject::tr("Unable to clone the original, the file system may not support reflinks: %1").arg(systemError()));
+
+    // the owner goes first, changing it clears the set-user-ID and set-group-ID bits.
+    const struct timespec times[2] = { duplicateStat.st_atim, duplicateStat.st_mtim };
+    if(::fchown(clone.fd, duplicateStat.st_uid, duplicateStat.st_gid) != 0 ||
+       ::fchmod(clone.fd, duplicateStat.st_mode & 07777) != 0 ||
+       !copyAttributes(duplicate.fd, clone.fd) ||
+       ::futimens(clone.fd, times) != 0)
+    {
+      return fail(QObject::tr("Unable to keep the metadata of the file: %1").arg(systemError()));
+    }
+
+    if(::fsync(clone.fd) != 0) return fail(QObject::tr("Unable to write the clone: %1").arg(systemError()));
+  }
+
+  // both files must still be the ones compared, and the duplicate still under its name.
+  struct stat originalNow, duplicateNow, nameNow;
+  if(::fstat(original.fd, &originalNow) != 0 || ::fstat(duplicate.fd, &duplicateNow) != 0 || ::lstat(task.duplicate.constData(), &nameNow) != 0 ||
+     !unchanged(originalStat, originalNow, hardlink) || !unchanged(duplicateStat, duplicateNow, false) || nameNow.st_ino != duplicateStat.st_ino || nameNow.st_dev != duplicateStat.st_dev)
+  {
+    return fail(QObject::tr("The files changed during the deduplication."));
+  }
+
+  if(::rename(temporary.constData(), task.duplicate.constData()) != 0) return fail(QObject::tr("Unable to replace the file: %1").arg(systemError()));
+
+  // the rename can't be undone, but it isn't durable until the directory is written.
+  const Descriptor parent{::open(directory.constData(), O_RDONLY|O_DIRECTORY|O_CLOEXEC)};
+  if(parent.fd < 0 || ::fsync(parent.fd) != 0)
+  {
+    error = QObject::tr("The file was replaced but its folder couldn't be written to disk: %1").arg(systemError());
+    return Outcome::FAILED;
+  }
+
+  bytes = duplicateStat.st_size;
+  return Outcome::REPLACED;
+#else
+  Q_UNUSED(task);
+  Q_UNUSED(bytes);
+  Q_UNUSED(identical);
+
+  error = QObject::tr("Deduplication is only available on Linux.");
+  return Outcome::FAILED;
+#endif
+}
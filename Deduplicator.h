@@ -0,0 +1,204 @@
+/*
+ File: Deduplicator.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEDUPLICATOR_H_
+#define DEDUPLICATOR_H_
+
+// Qt
+#include <QByteArray>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+// C++
+#include <atomic>
+
+/** \struct DeduplicationOptions
+ * \brief Deduplication configuration.
+ *
+ */
+struct DeduplicationOptions
+{
+  /** \brief How a duplicated file is replaced.
+   *
+   */
+  enum class Method: char
+  {
+    REFLINK  = 0, /** a copy-on-write clone of the original, keeps the file independent. */
+    HARDLINK = 1  /** a hard link to the original, both names become the same file.      */
+  };
+
+  Method method;  /** replacement of the duplicated files.                            */
+  bool   dryRun;  /** true to only compare the files and report what would be reclaimed. */
+  int    threads; /** files compared at the same time, 0 to use the number of cores.  */
+
+  DeduplicationOptions(): method{Method::REFLINK}, dryRun{true}, threads{0} {};
+};
+
+/** \struct DeduplicationReport
+ * \brief Outcome of a deduplication, the replaced files and bytes are the ones that would be
+ *        replaced in a dry run.
+ *
+ */
+struct DeduplicationReport
+{
+  qint64      files;     /** duplicated files compared with their originals.                  */
+  qint64      identical; /** files with the same contents as their originals.                  */
+  qint64      replaced;  /** identical files replaced by links to their originals.             */
+  qint64      bytes;     /** bytes reclaimed by the replaced files.                            */
+  qint64      shared;    /** files that were already the same file as their originals.        */
+  qint64      skipped;   /** files left as they were: different, missing, linked elsewhere or with other metadata. */
+  qint64      failed;    /** identical files that couldn't be replaced.                        */
+  QStringList errors;    /** descriptions of the first failures.                               */
+
+  DeduplicationReport(): files{0}, identical{0}, replaced{0}, bytes{0}, shared{0}, skipped{0}, failed{0} {};
+};
+
+/** \class Deduplicator
+ * \brief Replaces the files of duplicated directories with links to the files at the same
+ *        relative paths of their originals. Every pair of files is compared byte by byte
+ *        before, and only regular files on the same file system with a single link are
+ *        replaced. A reflink is a new file cloned from the original with the owner, mode,
+ *        extended attributes and times of the duplicate. A hard link needs the same owner,
+ *        mode, modification time and extended attributes in both files, and keeps the access
+ *        time of the original. The replacement is made under a temporary hidden name in
+ *        the same directory and renamed over the duplicate after checking it hasn't changed,
+ *        so an interruption leaves either file and at most a ".dedup" file behind. Files are
+ *        processed in parallel. Only available on Linux.
+ *
+ */
+class Deduplicator
+: public QThread
+{
+    Q_OBJECT
+  public:
+    /** \brief Deduplicator class constructor.
+     * \param[in] options Deduplication configuration.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit Deduplicator(const DeduplicationOptions &options = DeduplicationOptions(), QObject *parent = nullptr);
+
+    /** \brief Deduplicator class virtual destructor.
+     *
+     */
+    virtual ~Deduplicator()
+    {};
+
+    /** \brief Adds a duplicated directory along its original, before starting the thread.
+     * \param[in] original Original directory path.
+     * \param[in] duplicate Duplicated directory path.
+     *
+     */
+    void add(const QString &original, const QString &duplicate);
+
+    /** \brief Returns the outcome, once the thread has finished.
+     *
+     */
+    const DeduplicationReport &report() const
+    { return m_report; }
+
+    /** \brief Returns the number of files found in the duplicated directories so far.
+     *
+     */
+    qint64 total() const
+    { return m_total.load(); }
+
+    /** \brief Returns the number of files processed so far.
+     *
+     */
+    qint64 processed() const
+    { return m_processed.load(); }
+
+    /** \brief Stops the thread after the files being processed. The files already replaced stay so.
+     *
+     */
+    void stop()
+    { m_cancelled = true; }
+
+    /** \brief Returns true if the thread was stopped before processing all the files.
+     *
+     */
+    bool isCancelled() const
+    { return m_cancelled.load(); }
+
+    /** \brief Returns true if files can be replaced on this system.
+     *
+     */
+    static bool isAvailable();
+
+  protected:
+    virtual void run() override;
+
+  private:
+    /** \struct Task
+     * \brief A duplicated file and its original, in local encoding.
+     *
+     */
+    struct Task
+    {
+      QByteArray original;  /** original file path.   */
+      QByteArray duplicate; /** duplicated file path. */
+    };
+
+    /** \brief Outcomes of the processing of a file.
+     *
+     */
+    enum class Outcome: char
+    {
+      REPLACED = 0, /** replaced, or identical in a dry run. */
+      SHARED   = 1, /** already the same file or clone.      */
+      SKIPPED  = 2, /** not replaceable.                     */
+      FAILED   = 3  /** identical but not replaced.          */
+    };
+
+    /** \brief Adds the files of the given duplicated directory and its subdirectories.
+     * \param[in] original Original directory path.
+     * \param[in] duplicate Duplicated directory path.
+     *
+     */
+    void collect(const QString &original, const QString &duplicate);
+
+    /** \brief Compares the files of the given task and replaces the duplicate if they are identical.
+     * \param[in] task Files.
+     * \param[out] bytes Bytes reclaimed.
+     * \param[out] identical True if the contents are the same.
+     * \param[out] error Description of the failure.
+     *
+     */
+    Outcome process(const Task &task, qint64 &bytes, bool &identical, QString &error) const;
+
+    static const int MAX_ERRORS = 100;         /** failures described in the report. */
+    static const int BLOCK_SIZE = 1024*1024;   /** bytes compared at once.           */
+
+    const DeduplicationOptions       m_options;   /** deduplication configuration.     */
+    QVector<QPair<QString, QString>> m_pairs;     /** original and duplicated directories. */
+    QVector<Task>                    m_tasks;     /** files to process.                */
+    DeduplicationReport              m_report;    /** outcome.                         */
+    QMutex                           m_mutex;     /** protects the report errors.      */
+    std::atomic<qint64>              m_total;     /** files found.                     */
+    std::atomic<qint64>              m_processed; /** files processed.                 */
+    std::atomic<bool>                m_cancelled; /** true to stop.                    */
+    mutable std::atomic<quint32>     m_sequence;  /** temporary names counter.         */
+};
+
+#endif // DEDUPLICATOR_H_
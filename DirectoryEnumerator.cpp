@@ -0,0 +1,607 @@
+/*
+ File: DirectoryEnumerator.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "DirectoryEnumerator.h"
+
+// Qt
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+// C++
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+// Linux
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/sysmacros.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef DUPLICATES_IO_URING
+// io_uring
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#endif
+
+//--------------------------------------------------------------------
+DirectoryEnumerator* DirectoryEnumerator::create(const Backend backend)
+{
+#ifdef DUPLICATES_IO_URING
+  if(backend == Backend::URING)
+  {
+    std::unique_ptr<UringEnumerator> enumerator(new UringEnumerator());
+    if(enumerator->isValid()) return enumerator.release();
+  }
+#endif
+
+#ifdef Q_OS_LINUX
+  if(backend != Backend::QT) return new NativeEnumerator();
+#endif
+
+  return new QtEnumerator();
+}
+
+//--------------------------------------------------------------------
+bool DirectoryEnumerator::isNativeAvailable()
+{
+#ifdef Q_OS_LINUX
+  return true;
+#else
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------
+bool DirectoryEnumerator::isUringAvailable()
+{
+#ifdef DUPLICATES_IO_URING
+  // containers and hardened kernels can forbid them, so a ring is created once to check.
+  static const bool available = UringEnumerator().isValid();
+
+  return available;
+#else
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------
+quint64 DirectoryEnumerator::device(const QString &path)
+{
+#ifdef Q_OS_LINUX
+  struct stat info;
+  if(stat(QFile::encodeName(path).constData(), &info) == 0) return static_cast<quint64>(info.st_dev);
+#else
+  Q_UNUSED(path);
+#endif
+
+  return 0;
+}
+
+//--------------------------------------------------------------------
+bool DirectoryEnumerator::isRotational(const quint64 device)
+{
+#ifdef Q_OS_LINUX
+  // a partition has no queue of its own, it's the one of the parent disk.
+  const auto block = QString("/sys/dev/block/%1:%2/").arg(major(device)).arg(minor(device));
+  for(const auto &queue: {QString("queue/rotational"), QString("../queue/rotational")})
+  {
+    QFile file{block + queue};
+    if(file.open(QIODevice::ReadOnly)) return file.readAll().trimmed() == "1";
+  }
+#else
+  Q_UNUSED(device);
+#endif
+
+  return false;
+}
+
+//--------------------------------------------------------------------
+bool DirectoryEnumerator::usage(const QString &path, qint64 &inodes, qint64 &bytes)
+{
+  inodes = bytes = 0;
+
+#ifdef Q_OS_LINUX
+  struct statvfs info;
+  if(statvfs(QFile::encodeName(path).constData(), &info) != 0) return false;
+
+  // file systems without a fixed number of inodes report none.
+  inodes = static_cast<qint64>(info.f_files - info.f_ffree);
+  bytes  = static_cast<qint64>(info.f_blocks - info.f_bfree) * static_cast<qint64>(info.f_frsize);
+
+  return inodes > 0;
+#else
+  Q_UNUSED(path);
+
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------
+void DirectoryEnumerator::sort(QStringList &names)
+{
+  if(names.size() < 2) return;
+
+  std::vector<std::pair<QString, QString>> keys;
+  keys.reserve(names.size());
+  for(const auto &name: names)
+  {
+    keys.emplace_back(name.toLower(), name);
+  }
+
+  std::sort(keys.begin(), keys.end());
+
+  for(int i = 0; i < names.size(); ++i)
+  {
+    names[i] = keys[i].second;
+  }
+}
+
+//--------------------------------------------------------------------
+bool QtEnumerator::list(const QString& path, Listing& listing)
+{
+  const QDir directory{path};
+  if(!directory.exists() || !directory.isReadable())
+  {
+    m_counters->failures.add();
+    return false;
+  }
+
+  modified(path, listing.modified, listing.subdirectories);
+
+  // entries come sorted by name ignoring case, the default QDir sorting.
+  auto filters = QDir::Filter::NoDotAndDotDot|QDir::Filter::AllDirs|QDir::Filter::Files;
+  if(!m_follow) filters |= QDir::Filter::NoSymLinks;
+
+  const auto entries = directory.entryInfoList(filters);
+  m_counters->lists.add();
+  m_counters->stats.add(entries.size());
+  for(const auto &entry: entries)
+  {
+    if(entry.isDir())
+    {
+      listing.directories << entry.fileName();
+    }
+    else
+    {
+      listing.bytes += entry.size();
+      ++listing.files;
+
+      if(listing.details)
+      {
+        listing.fileNames << QFile::encodeName(entry.fileName());
+        listing.fileSizes << entry.size();
+      }
+    }
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+bool QtEnumerator::modified(const QString& path, qint64& stamp, int& subdirectories)
+{
+  const QFileInfo info{path};
+  m_counters->stats.add();
+  if(!info.isDir()) return false;
+
+  stamp          = info.lastModified().toMSecsSinceEpoch() * 1000000;
+  subdirectories = -1;
+
+  return true;
+}
+
+#ifdef Q_OS_LINUX
+
+namespace
+{
+  /** \struct linux_dirent64
+   * \brief Directory entry as returned by the getdents64 system call.
+   *
+   */
+  struct linux_dirent64
+  {
+    uint64_t       d_ino;    /** inode number.                  */
+    int64_t        d_off;    /** offset to the next entry.      */
+    unsigned short d_reclen; /** length of this record.         */
+    unsigned char  d_type;   /** file type.                     */
+    char           d_name[]; /** null terminated filename.      */
+  };
+
+  /** \brief Returns the type, size and identity of the given entry, following symbolic links
+   *         if asked to, or false if it can't be stat'ed (i.e. a broken link).
+   * \param[in] fd Directory file descriptor.
+   * \param[in] name Entry name.
+   * \param[in] follow True to follow symbolic links.
+   * \param[out] mode Entry type bits.
+   * \param[out] size Entry size in bytes.
+   * \param[out] inode Entry inode.
+   * \param[out] links Number of hard links of the entry.
+   *
+   */
+  bool statEntry(const int fd, const char *name, const bool follow, mode_t &mode, qint64 &size, quint64 &inode, quint32 &links)
+  {
+#ifdef STATX_TYPE
+    struct statx buffer;
+    if(statx(fd, name, AT_STATX_DONT_SYNC|(follow ? 0 : AT_SYMLINK_NOFOLLOW), STATX_TYPE|STATX_SIZE|STATX_INO|STATX_NLINK, &buffer) != 0) return false;
+
+    mode  = buffer.stx_mode;
+    size  = static_cast<qint64>(buffer.stx_size);
+    inode = buffer.stx_ino;
+    links = buffer.stx_nlink;
+#else
+    struct stat buffer;
+    if(fstatat(fd, name, &buffer, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) return false;
+
+    mode  = buffer.st_mode;
+    size  = static_cast<qint64>(buffer.st_size);
+    inode = static_cast<quint64>(buffer.st_ino);
+    links = static_cast<quint32>(buffer.st_nlink);
+#endif
+
+    return true;
+  }
+
+  /** \brief Returns the given time in nanoseconds.
+   * \param[in] seconds Seconds since the epoch.
+   * \param[in] nanoseconds Nanoseconds fraction.
+   *
+   */
+  inline qint64 nanoseconds(const qint64 seconds, const qint64 nanoseconds)
+  { return seconds * 1000000000 + nanoseconds; }
+
+  /** \brief Returns the number of subdirectories of a directory with the given link count, its
+   *         own entry and the ones of its subdirectories, or -1 if the file system doesn't count
+   *         them (i.e. btrfs always reports 1).
+   * \param[in] links Link count of the directory.
+   *
+   */
+  inline int subdirectories(const quint64 links)
+  { return links >= 2 && links - 2 <= static_cast<quint64>(std::numeric_limits<int>::max()) ? static_cast<int>(links - 2) : -1; }
+}
+
+//--------------------------------------------------------------------
+NativeEnumerator::NativeEnumerator()
+: m_buffer(BUFFER_SIZE, Qt::Uninitialized)
+{
+}
+
+//--------------------------------------------------------------------
+bool NativeEnumerator::list(const QString& path, Listing& listing)
+{
+  const auto fd = openat(AT_FDCWD, QFile::encodeName(path).constData(), O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+  m_counters->syscalls.add();
+  if(fd < 0)
+  {
+    m_counters->failures.add();
+    return false;
+  }
+
+  struct stat info;
+  if(fstat(fd, &info) == 0)
+  {
+    listing.modified = nanoseconds(info.st_mtim.tv_sec, info.st_mtim.tv_nsec);
+    listing.device   = static_cast<quint64>(info.st_dev);
+    listing.inode    = static_cast<quint64>(info.st_ino);
+    listing.subdirectories = subdirectories(info.st_nlink);
+  }
+
+  m_counters->lists.add();
+  m_counters->syscalls.add();
+  m_counters->stats.add();
+
+  while(true)
+  {
+    const auto read = syscall(SYS_getdents64, fd, m_buffer.data(), BUFFER_SIZE);
+    m_counters->syscalls.add();
+    if(read == 0) break;
+
+    // a directory removed or unreadable halfway would be taken as complete with the entries read.
+    if(read < 0)
+    {
+      close(fd);
+      m_counters->syscalls.add();
+      m_counters->failures.add();
+      return false;
+    }
+
+    for(long offset = 0; offset < read;)
+    {
+      auto entry = reinterpret_cast<const linux_dirent64 *>(m_buffer.constData() + offset);
+      offset += entry->d_reclen;
+
+      // skips '.', '..' and hidden entries.
+      if(entry->d_name[0] == '.') continue;
+
+      auto type = entry->d_type;
+
+      if(type == DT_DIR)
+      {
+        listing.directories << QFile::decodeName(entry->d_name);
+        continue;
+      }
+
+      if(type != DT_REG && type != DT_LNK && type != DT_UNKNOWN) continue;
+      if(type == DT_LNK && !m_follow) continue;
+
+      m_entries.push_back(Entry{entry->d_name, 0, 0, 0, 0});
+    }
+
+    // the names point to the buffer, so they are stat'ed before reading it again.
+    m_counters->stats.add(m_entries.size());
+    statEntries(fd, m_entries);
+
+    for(const auto &entry: m_entries)
+    {
+      if(S_ISDIR(entry.mode))
+      {
+        listing.directories << QFile::decodeName(entry.name);
+      }
+      else if(S_ISREG(entry.mode))
+      {
+        listing.bytes += entry.size;
+        ++listing.files;
+
+        if(entry.links > 1) listing.links << Link{entry.inode, entry.size};
+
+        if(listing.details)
+        {
+          listing.fileNames << QByteArray(entry.name);
+          listing.fileSizes << entry.size;
+        }
+      }
+    }
+
+    m_entries.clear();
+  }
+
+  close(fd);
+  m_counters->syscalls.add();
+
+  sort(listing.directories);
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+void NativeEnumerator::statEntries(const int fd, std::vector<Entry> &entries)
+{
+  for(auto &entry: entries)
+  {
+    mode_t mode = 0;
+    m_counters->syscalls.add();
+    if(statEntry(fd, entry.name, m_follow, mode, entry.size, entry.inode, entry.links)) entry.mode = mode;
+  }
+}
+
+//--------------------------------------------------------------------
+bool NativeEnumerator::modified(const QString& path, qint64& stamp, int& subdirectories)
+{
+  const auto name = QFile::encodeName(path);
+
+  m_counters->syscalls.add();
+  m_counters->stats.add();
+
+#ifdef STATX_TYPE
+  struct statx buffer;
+  if(statx(AT_FDCWD, name.constData(), AT_STATX_DONT_SYNC, STATX_TYPE|STATX_MTIME|STATX_NLINK, &buffer) != 0 || !S_ISDIR(buffer.stx_mode)) return false;
+
+  stamp          = nanoseconds(buffer.stx_mtime.tv_sec, buffer.stx_mtime.tv_nsec);
+  subdirectories = (buffer.stx_mask & STATX_NLINK) ? ::subdirectories(buffer.stx_nlink) : -1;
+#else
+  struct stat buffer;
+  if(stat(name.constData(), &buffer) != 0 || !S_ISDIR(buffer.st_mode)) return false;
+
+  stamp          = nanoseconds(buffer.st_mtim.tv_sec, buffer.st_mtim.tv_nsec);
+  subdirectories = ::subdirectories(buffer.st_nlink);
+#endif
+
+  return true;
+}
+
+#endif // Q_OS_LINUX
+
+#ifdef DUPLICATES_IO_URING
+
+/** \struct UringEnumerator::Ring
+ * \brief Memory maps of an io_uring, used without liburing.
+ *
+ */
+struct UringEnumerator::Ring
+{
+  int                  fd;       /** ring file descriptor.                      */
+  void                *sqMap;    /** submission queue ring map.                 */
+  size_t               sqSize;   /** size of the submission queue ring map.     */
+  void                *cqMap;    /** completion queue ring map, maybe sqMap.    */
+  size_t               cqSize;   /** size of the completion queue ring map.     */
+  io_uring_sqe        *sqes;     /** submission queue entries.                  */
+  size_t               sqesSize; /** size of the submission queue entries map.  */
+  unsigned            *sqTail;   /** submission queue tail, written by us.      */
+  unsigned            *sqMask;   /** submission queue index mask.               */
+  unsigned            *sqArray;  /** submission queue indexes of the entries.   */
+  unsigned            *cqHead;   /** completion queue head, written by us.      */
+  unsigned            *cqTail;   /** completion queue tail, written by the kernel. */
+  unsigned            *cqMask;   /** completion queue index mask.               */
+  io_uring_cqe        *cqes;     /** completion queue entries.                  */
+  unsigned             entries;  /** submission queue size.                     */
+  bool                 failed;   /** true once the ring can't be used anymore.  */
+  std::vector<struct statx> buffers; /** statx results of the requests.        */
+
+  Ring(): fd{-1}, sqMap{MAP_FAILED}, sqSize{0}, cqMap{MAP_FAILED}, cqSize{0}, sqes{nullptr}, sqesSize{0}, entries{0}, failed{false} {};
+
+  ~Ring()
+  {
+    if(sqes) munmap(sqes, sqesSize);
+    if(cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqSize);
+    if(sqMap != MAP_FAILED) munmap(sqMap, sqSize);
+    if(fd >= 0) close(fd);
+  }
+};
+
+namespace
+{
+  /** \brief Returns true if the given ring supports statx requests.
+   * \param[in] fd Ring file descriptor.
+   *
+   */
+  bool supportsStatx(const int fd)
+  {
+    const unsigned count = 256;
+    std::vector<char> buffer(sizeof(io_uring_probe) + count * sizeof(io_uring_probe_op), 0);
+    auto probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+
+    if(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, count) < 0) return false;
+
+    return probe->ops_len > IORING_OP_STATX && (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+  }
+}
+
+//--------------------------------------------------------------------
+UringEnumerator::UringEnumerator()
+{
+  std::unique_ptr<Ring> ring(new Ring());
+
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+
+  ring->fd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+  if(ring->fd < 0 || !supportsStatx(ring->fd)) return;
+
+  ring->entries = params.sq_entries;
+  ring->sqSize  = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cqSize  = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  // newer kernels map both rings at once.
+  const auto single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if(single) ring->sqSize = ring->cqSize = std::max(ring->sqSize, ring->cqSize);
+
+  ring->sqMap = mmap(nullptr, ring->sqSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if(ring->sqMap == MAP_FAILED) return;
+
+  ring->cqMap = single ? ring->sqMap : mmap(nullptr, ring->cqSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+  if(ring->cqMap == MAP_FAILED) return;
+
+  ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  auto sqes = mmap(nullptr, ring->sqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if(sqes == MAP_FAILED) return;
+  ring->sqes = static_cast<io_uring_sqe *>(sqes);
+
+  auto sq = static_cast<char *>(ring->sqMap);
+  auto cq = static_cast<char *>(ring->cqMap);
+  ring->sqTail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  ring->sqMask  = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  ring->sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  ring->cqHead  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  ring->cqTail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  ring->cqMask  = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  ring->cqes    = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  ring->buffers.resize(ring->entries);
+
+  m_ring = std::move(ring);
+}
+
+//--------------------------------------------------------------------
+UringEnumerator::~UringEnumerator()
+{
+}
+
+//--------------------------------------------------------------------
+void UringEnumerator::statEntries(const int fd, std::vector<Entry> &entries)
+{
+  auto &ring = *m_ring;
+
+  size_t first = 0;
+  while(!ring.failed && first < entries.size())
+  {
+    const auto count = static_cast<unsigned>(std::min<size_t>(entries.size() - first, ring.entries));
+
+    // the queues are empty between batches, so every request gets the slot of its index.
+    auto tail = __atomic_load_n(ring.sqTail, __ATOMIC_RELAXED);
+    for(unsigned i = 0; i < count; ++i)
+    {
+      auto &sqe = ring.sqes[i];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode      = IORING_OP_STATX;
+      sqe.fd          = fd;
+      sqe.addr        = reinterpret_cast<quint64>(entries[first + i].name);
+      sqe.len         = STATX_TYPE|STATX_SIZE|STATX_INO|STATX_NLINK;
+      sqe.statx_flags = AT_STATX_DONT_SYNC|(m_follow ? 0 : AT_SYMLINK_NOFOLLOW);
+      sqe.off         = reinterpret_cast<quint64>(&ring.buffers[i]);
+      sqe.user_data   = i;
+
+      ring.sqArray[tail++ & *ring.sqMask] = i;
+    }
+    __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+
+    unsigned submitted = 0, completed = 0;
+    while(completed < count)
+    {
+      const auto result = syscall(__NR_io_uring_enter, ring.fd, count - submitted, count - completed, IORING_ENTER_GETEVENTS, nullptr, 0);
+      m_counters->syscalls.add();
+      if(result < 0)
+      {
+        if(errno == EINTR) continue;
+
+        // the ring is kept until destroyed, the kernel could still complete the queued requests.
+        ring.failed = true;
+        break;
+      }
+      submitted += static_cast<unsigned>(result);
+
+      auto head = __atomic_load_n(ring.cqHead, __ATOMIC_RELAXED);
+      const auto cqTail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+      for(; head != cqTail; ++head, ++completed)
+      {
+        const auto &cqe = ring.cqes[head & *ring.cqMask];
+        if(cqe.res != 0) continue;
+
+        const auto &buffer = ring.buffers[cqe.user_data];
+        auto &entry = entries[first + cqe.user_data];
+        entry.mode  = buffer.stx_mode;
+        entry.size  = static_cast<qint64>(buffer.stx_size);
+        entry.inode = buffer.stx_ino;
+        entry.links = buffer.stx_nlink;
+      }
+      __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    if(!ring.failed) first += count;
+  }
+
+  // the entries the ring couldn't stat are stat'ed one at a time.
+  if(first < entries.size())
+  {
+    std::vector<Entry> rest(entries.begin() + first, entries.end());
+    NativeEnumerator::statEntries(fd, rest);
+    std::copy(rest.begin(), rest.end(), entries.begin() + first);
+  }
+}
+
+#endif // DUPLICATES_IO_URING
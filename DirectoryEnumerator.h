@@ -0,0 +1,318 @@
+/*
+ File: DirectoryEnumerator.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DIRECTORYENUMERATOR_H_
+#define DIRECTORYENUMERATOR_H_
+
+// Project
+#include "Counter.h"
+
+// Qt
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+
+// C++
+#include <memory>
+#include <vector>
+
+/** \class DirectoryEnumerator
+ * \brief Lists the subdirectories and files of a directory in a single pass. Each traversal
+ *        worker owns its enumerator, so implementations can keep per-worker buffers.
+ *
+ */
+class DirectoryEnumerator
+{
+  public:
+    /** \brief Enumeration backends.
+     *
+     */
+    enum class Backend: char
+    {
+      QT     = 0, /** portable QDir listing.                                 */
+      NATIVE = 1, /** getdents64/statx listing, falls back to QT if missing. */
+      URING  = 2  /** NATIVE with the stats batched in an io_uring, falls back to NATIVE if missing. */
+    };
+
+    /** \struct Link
+     * \brief File with several hard links, so its size may already be counted in another directory.
+     *
+     */
+    struct Link
+    {
+      quint64 inode; /** file inode, in the device of the directory. */
+      qint64  size;  /** file size in bytes.                         */
+    };
+
+    /** \struct Listing
+     * \brief Contents of a directory. Hidden entries are skipped and symbolic links are
+     *        followed, like QDir does by default, unless disabled with setFollowLinks().
+     *
+     */
+    struct Listing
+    {
+      bool              details;     /** in: true to fill the names and sizes of the files.   */
+      QStringList       directories; /** subdirectory names, sorted by name ignoring case.    */
+      qint64            bytes;       /** total size of the files in bytes.                    */
+      int               files;       /** number of files.                                     */
+      QList<QByteArray> fileNames;   /** file names in local encoding, only with details.     */
+      QVector<qint64>   fileSizes;   /** file sizes, in the same order as the names.          */
+      qint64            modified;    /** directory modification time, see modified().         */
+      quint64           device;      /** file system of the directory, 0 if unknown.          */
+      quint64           inode;       /** inode of the directory, 0 if unknown.                */
+      QVector<Link>     links;       /** files with several hard links, only with the native listing. */
+      int               subdirectories; /** subdirectories from the link count of the directory, hidden ones included, -1 if unknown. */
+
+      explicit Listing(const bool withDetails = false): details{withDetails}, bytes{0}, files{0}, modified{0}, device{0}, inode{0}, subdirectories{-1} {};
+    };
+
+    /** \struct Counters
+     * \brief File system operations of an enumerator. Only written by the thread using it.
+     *
+     */
+    struct Counters
+    {
+      Counter lists;    /** directories listed.                                    */
+      Counter syscalls; /** system calls made, only counted by the NATIVE backend. */
+      Counter stats;    /** directories and files stat'ed.                         */
+      Counter failures; /** directories that couldn't be opened or read to the end. */
+    };
+
+    /** \brief DirectoryEnumerator class constructor.
+     *
+     */
+    DirectoryEnumerator()
+    : m_counters{&m_ownCounters}
+    , m_follow  {true}
+    {};
+
+    /** \brief DirectoryEnumerator class virtual destructor.
+     *
+     */
+    virtual ~DirectoryEnumerator()
+    {};
+
+    /** \brief Makes the enumerator count its operations in the given counters instead of its own,
+     *        so they outlive it. The enumerator doesn't take ownership.
+     * \param[in] counters Operation counters.
+     *
+     */
+    void setCounters(Counters *counters)
+    { m_counters = counters ? counters : &m_ownCounters; }
+
+    /** \brief Returns the counters of the operations of the enumerator.
+     *
+     */
+    const Counters &counters() const
+    { return *m_counters; }
+
+    /** \brief Sets if the symbolic links are followed or left out of the listings. They are followed by default.
+     * \param[in] follow True to follow the symbolic links.
+     *
+     */
+    void setFollowLinks(const bool follow)
+    { m_follow = follow; }
+
+    /** \brief Lists the given directory and returns true on success. On failure the listing
+     *        may be incomplete and must not be used.
+     * \param[in] path Directory absolute path.
+     * \param[out] listing Directory contents.
+     *
+     */
+    virtual bool list(const QString &path, Listing &listing) = 0;
+
+    /** \brief Gets the modification time of the given directory, in nanoseconds since the
+     *        epoch, and its number of subdirectories from its link count, and returns true on
+     *        success. The time changes when entries are added, removed or renamed, but not when
+     *        the contents of its files change.
+     * \param[in] path Directory absolute path.
+     * \param[out] stamp Modification time.
+     * \param[out] subdirectories Subdirectories, hidden ones included, -1 if the file system doesn't count them.
+     *
+     */
+    virtual bool modified(const QString &path, qint64 &stamp, int &subdirectories) = 0;
+
+    /** \brief Returns a new enumerator of the given backend, or of the QT backend if the
+     *        requested one isn't available on this platform. Ownership is transferred to the caller.
+     * \param[in] backend Enumeration backend.
+     *
+     */
+    static DirectoryEnumerator *create(const Backend backend);
+
+    /** \brief Returns true if the native backend is available on this platform.
+     *
+     */
+    static bool isNativeAvailable();
+
+    /** \brief Returns true if the io_uring backend is available, that is, it was built with it and
+     *        the kernel supports statx requests in an io_uring and allows creating them.
+     *
+     */
+    static bool isUringAvailable();
+
+    /** \brief Returns the file system of the given directory, the same as Listing::device, or 0
+     *        if unknown on this platform.
+     * \param[in] path Directory absolute path.
+     *
+     */
+    static quint64 device(const QString &path);
+
+    /** \brief Returns true if the given file system is on a rotational disk, where parallel
+     *        requests are slower than serial ones. Unknown devices aren't rotational.
+     * \param[in] device File system, as returned by device().
+     *
+     */
+    static bool isRotational(const quint64 device);
+
+    /** \brief Gets the inodes and bytes in use in the file system of the given directory and
+     *        returns true on success. Both are upper bounds of what a scan of the directory finds.
+     * \param[in] path Directory absolute path.
+     * \param[out] inodes Files and directories of the file system.
+     * \param[out] bytes Bytes of the file system in use.
+     *
+     */
+    static bool usage(const QString &path, qint64 &inodes, qint64 &bytes);
+
+  protected:
+    /** \brief Sorts the given directory names like QDir does with Name|IgnoreCase.
+     * \param[inout] names Directory names.
+     *
+     */
+    static void sort(QStringList &names);
+
+    Counters *m_counters; /** operation counters in use.              */
+    bool      m_follow;   /** true to follow symbolic links.          */
+
+  private:
+    Counters m_ownCounters; /** counters used when none are given. */
+};
+
+/** \class QtEnumerator
+ * \brief Lists directories using QDir, in one entryInfoList() call.
+ *
+ */
+class QtEnumerator
+: public DirectoryEnumerator
+{
+  public:
+    virtual bool list(const QString &path, Listing &listing) override;
+
+    virtual bool modified(const QString &path, qint64 &stamp, int &subdirectories) override;
+};
+
+#ifdef Q_OS_LINUX
+
+/** \class NativeEnumerator
+ * \brief Lists directories reading the directory entries with getdents64. The entry type
+ *        tells files and directories apart and only files (and links or entries of unknown
+ *        type) are stat'ed, relative to the directory file descriptor.
+ *
+ */
+class NativeEnumerator
+: public DirectoryEnumerator
+{
+  public:
+    /** \brief NativeEnumerator class constructor.
+     *
+     */
+    NativeEnumerator();
+
+    virtual bool list(const QString &path, Listing &listing) override;
+
+    virtual bool modified(const QString &path, qint64 &stamp, int &subdirectories) override;
+
+  protected:
+    /** \struct Entry
+     * \brief Directory entry whose type and size are only known after a stat.
+     *
+     */
+    struct Entry
+    {
+      const char *name;  /** entry name, in the entries buffer.      */
+      quint32     mode;  /** type bits, 0 if it couldn't be stat'ed. */
+      qint64      size;  /** size in bytes.                          */
+      quint64     inode; /** inode number.                           */
+      quint32     links; /** number of hard links.                   */
+    };
+
+    /** \brief Stats the given entries of a directory, following symbolic links if enabled. The names are
+     *        only valid until the next read of the directory.
+     * \param[in] fd Directory file descriptor.
+     * \param[inout] entries Directory entries.
+     *
+     */
+    virtual void statEntries(const int fd, std::vector<Entry> &entries);
+
+  private:
+    static const int BUFFER_SIZE = 64*1024; /** size of the getdents64 buffer. */
+
+    QByteArray         m_buffer;  /** directory entries buffer.           */
+    std::vector<Entry> m_entries; /** entries of the buffer to be stat'ed. */
+};
+
+#ifdef DUPLICATES_IO_URING
+
+/** \class UringEnumerator
+ * \brief Lists directories like NativeEnumerator but submits the stats of the entries of
+ *        each read of the directory as a batch of statx requests to an io_uring, so hundreds
+ *        of them are in flight with a single system call. Useful on network and RAID storage,
+ *        where the latency of each request and not the CPU limits the listing. Falls back to
+ *        one statx at a time if the ring fails. Opening and reading the directory stay
+ *        synchronous and nothing stays in flight between directories, so it only helps
+ *        directories with many files.
+ *
+ */
+class UringEnumerator
+: public NativeEnumerator
+{
+  public:
+    /** \brief UringEnumerator class constructor. The ring is created here, check isValid().
+     *
+     */
+    UringEnumerator();
+
+    /** \brief UringEnumerator class virtual destructor.
+     *
+     */
+    virtual ~UringEnumerator();
+
+    /** \brief Returns true if the ring was created.
+     *
+     */
+    bool isValid() const
+    { return m_ring != nullptr; }
+
+  protected:
+    virtual void statEntries(const int fd, std::vector<Entry> &entries) override;
+
+  private:
+    struct Ring;
+
+    static const unsigned RING_ENTRIES = 256; /** submission queue size, requests in flight. */
+
+    std::unique_ptr<Ring> m_ring; /** io_uring, nullptr if unavailable. */
+};
+
+#endif // DUPLICATES_IO_URING
+
+#endif // Q_OS_LINUX
+
+#endif // DIRECTORYENUMERATOR_H_
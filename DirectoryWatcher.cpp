@@ -0,0 +1,93 @@
+/*
+ File: DirectoryWatcher.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "DirectoryWatcher.h"
+
+// Qt
+#include <QDebug>
+
+// C++
+#include <algorithm>
+
+//--------------------------------------------------------------------
+DirectoryWatcher::DirectoryWatcher(const int delay, QObject* parent)
+: QObject(parent)
+, m_warned{false}
+{
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(delay);
+
+  connect(&m_watcher, SIGNAL(directoryChanged(const QString &)), this, SLOT(onDirectoryChanged(const QString &)));
+  connect(&m_timer,   SIGNAL(timeout()),                         this, SLOT(onTimeout()));
+}
+
+//--------------------------------------------------------------------
+void DirectoryWatcher::watch(const QStringList& paths)
+{
+  if(paths.isEmpty()) return;
+
+  // on Linux the number of inotify watches is limited by fs.inotify.max_user_watches.
+  const auto failed = m_watcher.addPaths(paths);
+  for(const auto &path: failed)
+  {
+    m_unwatched.insert(path);
+  }
+
+  if(!failed.isEmpty() && !m_warned)
+  {
+    qWarning() << "Unable to watch" << failed.size() << "directories, the watch limit may have been reached.";
+    m_warned = true;
+  }
+}
+
+//--------------------------------------------------------------------
+void DirectoryWatcher::unwatch(const QStringList& paths)
+{
+  if(paths.isEmpty()) return;
+
+  for(const auto &path: paths)
+  {
+    m_unwatched.remove(path);
+  }
+
+  m_watcher.removePaths(paths);
+}
+
+//--------------------------------------------------------------------
+void DirectoryWatcher::onDirectoryChanged(const QString& path)
+{
+  m_pending.insert(path);
+
+  // the timer isn't restarted, so a continuous burst is still reported every delay.
+  if(!m_timer.isActive()) m_timer.start();
+}
+
+//--------------------------------------------------------------------
+void DirectoryWatcher::onTimeout()
+{
+  if(m_pending.isEmpty()) return;
+
+  QStringList paths = m_pending.toList();
+  m_pending.clear();
+
+  std::sort(paths.begin(), paths.end());
+
+  emit changed(paths);
+}
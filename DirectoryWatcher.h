@@ -0,0 +1,96 @@
+/*
+ File: DirectoryWatcher.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DIRECTORYWATCHER_H_
+#define DIRECTORYWATCHER_H_
+
+// Qt
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QSet>
+#include <QStringList>
+
+/** \class DirectoryWatcher
+ * \brief Watches directories for changes and reports them in batches. The changes are
+ *        coalesced during a delay after the first one, so a burst of changes in the same
+ *        or in many directories is reported once.
+ *
+ */
+class DirectoryWatcher
+: public QObject
+{
+    Q_OBJECT
+  public:
+    /** \brief DirectoryWatcher class constructor.
+     * \param[in] delay Time in milliseconds the changes are coalesced.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit DirectoryWatcher(const int delay = 500, QObject *parent = nullptr);
+
+    /** \brief Starts watching the given directories.
+     * \param[in] paths Directory absolute paths.
+     *
+     */
+    void watch(const QStringList &paths);
+
+    /** \brief Stops watching the given directories.
+     * \param[in] paths Directory absolute paths.
+     *
+     */
+    void unwatch(const QStringList &paths);
+
+    /** \brief Returns the number of watched directories.
+     *
+     */
+    int watched() const
+    { return m_watcher.directories().size(); }
+
+    /** \brief Returns the number of directories that couldn't be watched and still exist in the tree.
+     *
+     */
+    int unwatched() const
+    { return m_unwatched.size(); }
+
+  signals:
+    void changed(const QStringList &paths);
+
+  private slots:
+    /** \brief Adds the given directory to the pending changes and starts the delay if it
+     *        isn't running.
+     * \param[in] path Changed directory path.
+     *
+     */
+    void onDirectoryChanged(const QString &path);
+
+    /** \brief Reports the pending changes, sorted so parents come before their subdirectories.
+     *
+     */
+    void onTimeout();
+
+  private:
+    QFileSystemWatcher m_watcher; /** system watcher.                       */
+    QTimer             m_timer;   /** coalescing delay timer.               */
+    QSet<QString>      m_pending; /** directories changed during the delay. */
+    QSet<QString>      m_unwatched; /** directories that couldn't be watched. */
+    bool               m_warned;  /** true if the watch limit was reported. */
+};
+
+#endif // DIRECTORYWATCHER_H_
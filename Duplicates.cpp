@@ -20,6 +20,12 @@
 // Project
 #include "Duplicates.h"
 #include "AboutDialog.h"
+#include "ScanThread.h"
+#include "ScanIndex.h"
+#include "DuplicatesModel.h"
+#include "ResultFile.h"
+#include "ResultWriter.h"
+#include "Deduplicator.h"
 
 // Qt
 #include <QFileDialog>
@@ -30,21 +36,60 @@
 #include <QAction>
 #include <QVariant>
 #include <QDesktopServices>
+#include <QSortFilterProxyModel>
+#include <QTimer>
+#include <QLocale>
+#include <QInputDialog>
+#include <QProgressDialog>
+#include <QEventLoop>
 #include <QDebug>
 
-const QString Duplicates::FOLDER{"Folder"}; /** Selected folder settings key. */
-
-const unsigned long long MEGABYTE{1024*1024};
+const QString Duplicates::FOLDER{"Folder"};   /** Selected folder settings key. */
+const QString Duplicates::THREADS{"Threads"}; /** Traversal threads settings key. */
+const QString Duplicates::NATIVE{"Native"};   /** Native enumeration settings key. */
+const QString Duplicates::URING{"Uring"};     /** io_uring stats settings key. */
+const QString Duplicates::MODE{"Mode"};       /** Matching mode settings key. */
+const QString Duplicates::INCREMENTAL{"Incremental"}; /** Incremental scan settings key. */
+const QString Duplicates::WATCH{"Watch"};     /** Watch mode settings key. */
+const QString Duplicates::STATISTICS{"Statistics"}; /** Statistics panel settings key. */
+const QString Duplicates::EXCLUSIONS{"Exclusions"}; /** Exclusion rules settings key. */
+const QString Duplicates::LOW_PRIORITY{"LowPriority"}; /** Low priority settings key. */
+const QString Duplicates::OPERATIONS{"Operations"}; /** Operations limit settings key. */
+const QString Duplicates::READ_LIMIT{"ReadLimit"}; /** Read limit settings key. */
+const QString Duplicates::BACKOFF{"Backoff"};  /** Latency backoff settings key. */
+
+const QString Duplicates::FOLDER_SEPARATOR{"; "}; /** Separator of the folders in the folder field. */
 
 //-----------------------------------------------------------------
 Duplicates::Duplicates()
+: m_thread {nullptr}
+, m_found  {0}
+, m_batches{0}
 {
   setupUi(this);
 
+  m_model = new DuplicatesModel(this);
+
+  m_proxy = new QSortFilterProxyModel(this);
+  m_proxy->setSourceModel(m_model);
+  m_proxy->setFilterKeyColumn(-1);
+  m_proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+  // rows are shown in the order they are found until a column is sorted.
+  m_table->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+  m_table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  m_table->setModel(m_proxy);
+
   m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
   m_table->setContextMenuPolicy(Qt::CustomContextMenu);
   m_table->horizontalHeader()->resizeSections(QHeaderView::ResizeMode::ResizeToContents);
 
+  m_native->setVisible(DirectoryEnumerator::isNativeAvailable());
+  m_uring->setVisible(DirectoryEnumerator::isUringAvailable());
+
+  m_timer = new QTimer(this);
+  m_timer->setInterval(500);
+
   connectSignals();
 
   loadSettings();
@@ -53,6 +98,12 @@ Duplicates::Duplicates()
 //--------------------------------------------------------------------
 Duplicates::~Duplicates()
 {
+  if(m_thread)
+  {
+    m_thread->stop();
+    m_thread->wait();
+  }
+
   saveSettings();
 }
 
@@ -62,8 +113,20 @@ void Duplicates::connectSignals()
   connect(m_about,      SIGNAL(pressed()), this, SLOT(onAboutPressed()));
   connect(m_quit,       SIGNAL(pressed()), this, SLOT(close()));
   connect(m_folderPick, SIGNAL(pressed()), this, SLOT(openFolderSelectionDialog()));
+  connect(m_folderAdd,  SIGNAL(pressed()), this, SLOT(addFolder()));
   connect(m_search,     SIGNAL(pressed()), this, SLOT(scan()));
+  connect(m_exclusions, SIGNAL(pressed()), this, SLOT(onExclusionsPressed()));
+  connect(m_open,       SIGNAL(pressed()), this, SLOT(onOpenPressed()));
+  connect(m_export,     SIGNAL(pressed()), this, SLOT(onExportPressed()));
+  connect(m_pause,      SIGNAL(toggled(bool)), this, SLOT(onPauseToggled(bool)));
   connect(m_table,      SIGNAL(customContextMenuRequested(const QPoint &)), this, SLOT(onMenuRequested(const QPoint &)));
+  connect(m_filter,     SIGNAL(textChanged(const QString &)), this, SLOT(onFilterChanged(const QString &)));
+  connect(m_timer,      SIGNAL(timeout()), this, SLOT(updateStatistics()));
+  connect(m_native,     SIGNAL(toggled(bool)), m_uring, SLOT(setEnabled(bool)));
+  connect(m_lowPriority, SIGNAL(toggled(bool)), this, SLOT(onBackgroundChanged()));
+  connect(m_operations,  SIGNAL(valueChanged(int)), this, SLOT(onBackgroundChanged()));
+  connect(m_read,        SIGNAL(valueChanged(int)), this, SLOT(onBackgroundChanged()));
+  connect(m_backoff,     SIGNAL(toggled(bool)), this, SLOT(onBackgroundChanged()));
 }
 
 //-----------------------------------------------------------------
@@ -76,7 +139,31 @@ void Duplicates::onAboutPressed()
 //-----------------------------------------------------------------
 void Duplicates::openFolderSelectionDialog()
 {
-  QDir currentDir{m_folder->text()};
+  const auto folder = selectFolder();
+  if(!folder.isEmpty()) m_folder->setText(folder);
+
+  m_folderPick->setDown(false);
+}
+
+//-----------------------------------------------------------------
+void Duplicates::addFolder()
+{
+  const auto folder = selectFolder();
+  if(!folder.isEmpty())
+  {
+    auto paths = folders();
+    paths << folder;
+    m_folder->setText(paths.join(FOLDER_SEPARATOR));
+  }
+
+  m_folderAdd->setDown(false);
+}
+
+//-----------------------------------------------------------------
+QString Duplicates::selectFolder()
+{
+  const auto paths = folders();
+  QDir currentDir{paths.isEmpty() ? QString() : paths.last()};
   if(!currentDir.exists() || !currentDir.isReadable()) currentDir = QApplication::applicationDirPath();
 
   QFileDialog dialog{this};
@@ -86,8 +173,7 @@ void Duplicates::openFolderSelectionDialog()
   dialog.setFilter(QDir::AllDirs | QDir::Readable);
   dialog.setDirectory(currentDir.absolutePath());
 
-  bool invalid = true;
-  while(invalid && (dialog.exec() == QDialog::Accepted))
+  while(dialog.exec() == QDialog::Accepted)
   {
     auto selection = dialog.selectedFiles();
     if(selection.size() == 1)
@@ -96,45 +182,107 @@ void Duplicates::openFolderSelectionDialog()
 
       if(selectedDir.exists() && selectedDir.isReadable())
       {
-        m_folder->setText(QDir::toNativeSeparators(selectedDir.absolutePath()));
-        invalid = false;
+        return QDir::toNativeSeparators(selectedDir.absolutePath());
       }
     }
 
-    if(invalid)
-    {
-      QMessageBox msgBox;
-      msgBox.setWindowTitle(tr("Error"));
-      msgBox.setWindowIcon(QIcon(":/Duplicates/folder.svg"));
-      msgBox.setText(tr("The selected directory is invalid"));
-      msgBox.setIcon(QMessageBox::Icon::Critical);
-      msgBox.exec();
-    }
+    QMessageBox msgBox;
+    msgBox.setWindowTitle(tr("Error"));
+    msgBox.setWindowIcon(QIcon(":/Duplicates/folder.svg"));
+    msgBox.setText(tr("The selected directory is invalid"));
+    msgBox.setIcon(QMessageBox::Icon::Critical);
+    msgBox.exec();
   }
 
-  m_folderPick->setDown(false);
+  return QString();
+}
+
+//-----------------------------------------------------------------
+QStringList Duplicates::folders() const
+{
+  QStringList result;
+  for(const auto &part: m_folder->text().split(FOLDER_SEPARATOR.trimmed()))
+  {
+    const auto folder = part.trimmed();
+    if(!folder.isEmpty()) result << QDir::fromNativeSeparators(folder);
+  }
+
+  return result;
 }
 
 //--------------------------------------------------------------------
 void Duplicates::scan()
 {
-  m_table->clearContents();
-  m_table->setRowCount(0);
+  if(m_thread)
+  {
+    m_search->setEnabled(false);
+    m_pause->setEnabled(false);
+    m_thread->stop();
+    return;
+  }
+
+  m_model->clear();
+  updateProxy();
+  m_found = 0;
+  m_batches = 0;
   m_inserted->setText("0");
+  m_groups->setText("0");
 
   m_progress->setEnabled(true);
   m_progress->setValue(0);
 
   m_search->setEnabled(false);
-
-  QDir directory{m_folder->text()};
-
-  auto thread = new ScanThread(directory, this);
+  m_threads->setEnabled(false);
+  m_native->setEnabled(false);
+  m_uring->setEnabled(false);
+  m_mode->setEnabled(false);
+  m_incremental->setEnabled(false);
+  m_watch->setEnabled(false);
+  m_exclusions->setEnabled(false);
+  m_folderPick->setEnabled(false);
+  m_folderAdd->setEnabled(false);
+  m_open->setEnabled(false);
+  m_export->setEnabled(false);
+
+  // the search button stops the scan, keeping a checkpoint to resume it later.
+  m_search->setEnabled(true);
+  m_search->setToolTip(tr("Stop the scan"));
+  m_pause->setChecked(false);
+  m_pause->setEnabled(true);
+
+  QStringList paths;
+  for(const auto &folder: folders()) paths << QDir(folder).absolutePath();
+
+  ScanOptions options;
+  options.threads = m_threads->value();
+  options.backend = DirectoryEnumerator::Backend::QT;
+  if(m_native->isChecked()) options.backend = m_uring->isChecked() ? DirectoryEnumerator::Backend::URING : DirectoryEnumerator::Backend::NATIVE;
+  options.mode    = static_cast<ScanOptions::Mode>(m_mode->currentIndex());
+  options.watch   = m_watch->isChecked();
+  options.background = throttleOptions();
+  if(m_incremental->isChecked()) options.indexFile = ScanIndex::defaultFile(paths);
+  options.checkpointFile = ScanIndex::checkpointFile(paths);
+  options.resultsFile    = ScanIndex::resultsFile(paths);
+  m_resultsFile          = options.resultsFile;
+
+  // the rules were validated when edited.
+  QString error;
+  options.rules.parse(m_rules, error);
+
+  auto thread = new ScanThread(paths, options, this);
   connect(thread, SIGNAL(progress(int)), m_progress, SLOT(setValue(int)));
-  connect(thread, SIGNAL(found(const QString &, const QString &, const float, const QString &, const float)), this, SLOT(onFound(const QString &, const QString &, const float, const QString &, const float)));
+  connect(thread, SIGNAL(foundBatch(const DuplicateBatch &)), this, SLOT(onFoundBatch(const DuplicateBatch &)));
+  connect(thread, SIGNAL(foundGroup(const DuplicateGroup &)), this, SLOT(onFoundGroup(const DuplicateGroup &)));
+  connect(thread, SIGNAL(watching()), this, SLOT(onWatching()));
+  connect(thread, SIGNAL(unwatchedChanged(int)), this, SLOT(updateStatistics()));
+  connect(thread, SIGNAL(groupRemoved(quint64)), this, SLOT(onGroupRemoved(quint64)));
   connect(thread, SIGNAL(finished()), this, SLOT(onThreadFinished()));
 
+  m_thread = thread;
+
   thread->start();
+
+  m_timer->start();
 }
 
 //--------------------------------------------------------------------
@@ -142,9 +290,32 @@ void Duplicates::loadSettings()
 {
   QSettings settings("Felix de las Pozas Alvarez", "DuplicatesFinder");
 
-  QDir directory{settings.value(FOLDER, QApplication::applicationDirPath()).toString()};
-
-  m_folder->setText(QDir::toNativeSeparators(directory.absolutePath()));
+  QStringList paths;
+  for(const auto &folder: settings.value(FOLDER, QApplication::applicationDirPath()).toStringList())
+  {
+    const QDir directory{folder};
+    if(directory.exists()) paths << QDir::toNativeSeparators(directory.absolutePath());
+  }
+  if(paths.isEmpty()) paths << QDir::toNativeSeparators(QApplication::applicationDirPath());
+
+  m_folder->setText(paths.join(FOLDER_SEPARATOR));
+
+  m_threads->setValue(settings.value(THREADS, QThread::idealThreadCount()).toInt());
+  m_native->setChecked(settings.value(NATIVE, true).toBool());
+  m_uring->setChecked(settings.value(URING, false).toBool());
+  m_uring->setEnabled(m_native->isChecked());
+  m_mode->setCurrentIndex(settings.value(MODE, 0).toInt());
+  m_incremental->setChecked(settings.value(INCREMENTAL, false).toBool());
+  m_watch->setChecked(settings.value(WATCH, false).toBool());
+  m_statistics->setChecked(settings.value(STATISTICS, false).toBool());
+  m_lowPriority->setChecked(settings.value(LOW_PRIORITY, false).toBool());
+  m_operations->setValue(settings.value(OPERATIONS, 0).toInt());
+  m_read->setValue(settings.value(READ_LIMIT, 0).toInt());
+  m_backoff->setChecked(settings.value(BACKOFF, false).toBool());
+
+  QString error;
+  m_rules = settings.value(EXCLUSIONS, ExclusionRules::defaults()).toString();
+  if(!ExclusionRules().parse(m_rules, error)) m_rules = ExclusionRules::defaults();
 }
 
 //--------------------------------------------------------------------
@@ -155,29 +326,65 @@ void Duplicates::onThreadFinished()
   {
     QApplication::restoreOverrideCursor();
 
+    m_timer->stop();
+    updateStatistics();
+
+    m_thread = nullptr;
+
     m_search->setEnabled(true);
+    m_search->setToolTip(tr("Search for duplicates"));
+    m_threads->setEnabled(true);
+    m_native->setEnabled(true);
+    m_uring->setEnabled(m_native->isChecked());
+    m_mode->setEnabled(true);
+    m_incremental->setEnabled(true);
+    m_watch->setEnabled(true);
+    m_exclusions->setEnabled(true);
+    m_folderPick->setEnabled(true);
+    m_folderAdd->setEnabled(true);
+    m_open->setEnabled(true);
+    m_pause->setChecked(false);
+    m_pause->setEnabled(false);
 
     m_progress->setValue(0);
+    m_progress->setFormat("%p%");
     m_progress->setEnabled(false);
 
+    // the rows are read from the results file from now on, instead of being kept in memory.
+    if(!thread->isCancelled() && m_model->open(m_resultsFile))
+    {
+      m_inserted->setText(QString::number(m_model->rowCount()));
+    }
+    updateProxy();
+    m_export->setEnabled(!m_model->fileName().isEmpty());
+
     QMessageBox msgBox;
     msgBox.setIcon(QMessageBox::Icon::Information);
     msgBox.setWindowTitle(tr("Search results"));
     msgBox.setWindowIcon(QIcon(":/Duplicates/magnifying-glass.svg"));
 
-    if(m_table->rowCount() == 0)
+    if(thread->isCancelled())
+    {
+      msgBox.setText(tr("Scan stopped after %1 folders, it will resume from there the next time.").arg(thread->inspected()));
+    }
+    else if(m_model->rowCount() == 0)
     {
       msgBox.setText(tr("No duplicates found!"));
     }
     else
     {
-      msgBox.setText(tr("Found %1 duplicates!").arg(m_table->rowCount()));
+      msgBox.setText(tr("Found %1 duplicates!").arg(m_model->rowCount()));
       for (int c = 0; c < m_table->horizontalHeader()->count(); ++c)
       {
         m_table->horizontalHeader()->setSectionResizeMode(c, QHeaderView::Stretch);
       }
     }
 
+    if(!thread->isCancelled() && thread->resumed() > 0)
+    {
+      msgBox.setInformativeText(tr("%1 folders were resumed from the last stopped scan.").arg(thread->resumed()));
+    }
+
     msgBox.exec();
 
     m_search->setDown(false);
@@ -195,13 +402,30 @@ void Duplicates::onThreadFinished()
 //--------------------------------------------------------------------
 void Duplicates::saveSettings()
 {
-  QDir directory{m_folder->text()};
+  QStringList paths;
+  for(const auto &folder: folders())
+  {
+    const QDir directory{folder};
+    if(directory.exists() && directory.isReadable()) paths << directory.absolutePath();
+  }
 
-  if(directory.exists() && directory.isReadable())
+  if(!paths.isEmpty())
   {
     QSettings settings("Felix de las Pozas Alvarez", "DuplicatesFinder");
 
-    settings.setValue(FOLDER, directory.absolutePath());
+    settings.setValue(FOLDER, paths);
+    settings.setValue(THREADS, m_threads->value());
+    settings.setValue(NATIVE, m_native->isChecked());
+    settings.setValue(URING, m_uring->isChecked());
+    settings.setValue(MODE, m_mode->currentIndex());
+    settings.setValue(INCREMENTAL, m_incremental->isChecked());
+    settings.setValue(WATCH, m_watch->isChecked());
+    settings.setValue(STATISTICS, m_statistics->isChecked());
+    settings.setValue(LOW_PRIORITY, m_lowPriority->isChecked());
+    settings.setValue(OPERATIONS, m_operations->value());
+    settings.setValue(READ_LIMIT, m_read->value());
+    settings.setValue(BACKOFF, m_backoff->isChecked());
+    settings.setValue(EXCLUSIONS, m_rules);
     settings.sync();
   }
 }
@@ -222,137 +446,357 @@ void Duplicates::onActionTriggered()
 }
 
 //--------------------------------------------------------------------
-const float ScanThread::processDirectory(const QString& directoryPath)
+void Duplicates::onMenuRequested(const QPoint& pos)
 {
-  const QString separator{"/"};
-  float size = 0.f;
+  auto index = m_table->indexAt(pos);
+  if(index.isValid())
+  {
+    const auto &row = m_model->duplicate(sourceRow(index));
+    auto original = row.parent1 + row.name1 + QDir::separator();
+    auto duplicate = row.parent2 + row.name2 + QDir::separator();
 
-  const QDir directory{directoryPath};
-  Q_ASSERT(directory.exists());
+    QMenu menu{this};
 
-  const auto dirEntries = directory.entryInfoList(QDir::Filter::NoDotAndDotDot|QDir::Filter::AllDirs);
-  for(auto entry: dirEntries)
+    auto action = menu.addAction(tr("Open original folder '%1'").arg(original));
+    action->setData(original);
+    connect(action, SIGNAL(triggered(bool)), this, SLOT(onActionTriggered()));
+
+    action = menu.addAction(tr("Open duplicated folder '%1'").arg(duplicate));
+    action->setData(duplicate);
+    connect(action, SIGNAL(triggered(bool)), this, SLOT(onActionTriggered()));
+
+    if(Deduplicator::isAvailable())
+    {
+      menu.addSeparator();
+
+      const auto selected = m_table->selectionModel()->selectedRows().size();
+      action = menu.addAction(tr("Deduplicate %1 selected folders...").arg(qMax(1, selected)));
+      action->setEnabled(!m_thread);
+      connect(action, SIGNAL(triggered(bool)), this, SLOT(onDeduplicateTriggered()));
+    }
+
+    menu.exec(m_table->viewport()->mapToGlobal(pos));
+  }
+}
+
+//--------------------------------------------------------------------
+void Duplicates::onDeduplicateTriggered()
+{
+  auto rows = m_table->selectionModel()->selectedRows();
+  if(rows.isEmpty()) rows << m_table->currentIndex();
+
+  QVector<QPair<QString, QString>> pairs;
+  for(const auto &index: rows)
   {
-    size += processDirectory(entry.absoluteFilePath());
+    if(!index.isValid()) continue;
+
+    const auto row = m_model->duplicate(sourceRow(index));
+    pairs << qMakePair(row.parent1 + row.name1, row.parent2 + row.name2);
   }
+  if(pairs.isEmpty()) return;
+
+  const QStringList methods{tr("Reflinks, independent copy-on-write clones"), tr("Hard links, the same file in both folders")};
+
+  bool ok = false;
+  const auto method = QInputDialog::getItem(this, tr("Deduplicate"), tr("Replace the identical files of the duplicated folders with:"), methods, 0, false, &ok);
+  if(!ok) return;
+
+  DeduplicationOptions options;
+  options.method  = method == methods.first() ? DeduplicationOptions::Method::REFLINK : DeduplicationOptions::Method::HARDLINK;
+  options.threads = m_threads->value();
+  options.dryRun  = true;
 
-  const auto fileEntries = directory.entryInfoList(QDir::Filter::Files);
-  for(auto entry: fileEntries)
+  DeduplicationReport report;
+  if(!deduplicate(pairs, options, report)) return;
+
+  const auto locale = QLocale::system();
+  auto message = tr("%1 files compared, %2 identical and %3 already shared. %4 files would be replaced, reclaiming %5 MB.")
+                 .arg(locale.toString(report.files))
+                 .arg(locale.toString(report.identical))
+                 .arg(locale.toString(report.shared))
+                 .arg(locale.toString(report.replaced))
+                 .arg(locale.toString(report.bytes / (1024. * 1024.), 'f', 1));
+
+  if(report.replaced == 0)
   {
-    size += static_cast<float>(entry.size())/MEGABYTE;
+    QMessageBox::information(this, tr("Deduplicate"), message);
+    return;
   }
 
-  DirectoryInfo info;
-  info.path = directory.absolutePath();
-  info.name = info.path.split(separator).last().toLower();
-  info.size = size;
+  if(QMessageBox::question(this, tr("Deduplicate"), message + "\n\n" + tr("Replace the files?")) != QMessageBox::Yes) return;
+
+  options.dryRun = false;
+  const auto finished = deduplicate(pairs, options, report);
+
+  message = tr("%1 files replaced, reclaiming %2 MB. %3 files failed.")
+            .arg(locale.toString(report.replaced))
+            .arg(locale.toString(report.bytes / (1024. * 1024.), 'f', 1))
+            .arg(locale.toString(report.failed));
+  if(!finished) message.prepend(tr("Cancelled.") + " ");
+  if(!report.errors.isEmpty()) message += "\n\n" + report.errors.mid(0, 10).join("\n");
+
+  if(report.failed > 0) QMessageBox::warning(this, tr("Deduplicate"), message);
+  else                  QMessageBox::information(this, tr("Deduplicate"), message);
+}
 
-  if((info.name.compare("Variado", Qt::CaseInsensitive) == 0) ||
-     (info.name.compare("Various", Qt::CaseInsensitive) == 0) ||
-     (info.name.startsWith("CD ", Qt::CaseInsensitive))       ||
-     size == 0)
+//--------------------------------------------------------------------
+bool Duplicates::deduplicate(const QVector<QPair<QString, QString>> &pairs, const DeduplicationOptions &options, DeduplicationReport &report)
+{
+  Deduplicator deduplicator{options};
+  for(const auto &pair: pairs)
   {
-    return 0;
+    deduplicator.add(pair.first, pair.second);
   }
 
-  auto hashValue = hash(info);
+  QProgressDialog dialog{options.dryRun ? tr("Comparing the files...") : tr("Replacing the files..."), tr("Cancel"), 0, 0, this};
+  dialog.setWindowModality(Qt::WindowModal);
+  dialog.setMinimumDuration(500);
 
-  if(m_directories.keys().contains(hashValue))
+  // the finished signal is queued, it quits the loop once it runs even if the thread ends before.
+  QEventLoop loop;
+  QTimer timer;
+  connect(&deduplicator, SIGNAL(finished()), &loop, SLOT(quit()));
+  connect(&timer, &QTimer::timeout, [&deduplicator, &dialog]()
   {
-    for(const auto entry: m_directories.value(hashValue))
-    {
-      if(entry.name == info.name)
-      {
-        auto parts = entry.path.split(separator);
-        auto name  = parts.last();
+    if(dialog.wasCanceled() && !deduplicator.isCancelled()) deduplicator.stop();
 
-        auto parent1 = QDir::toNativeSeparators(entry.path.left(entry.path.size()-entry.name.size()));
-        parts = info.path.split(separator);
+    dialog.setMaximum(static_cast<int>(deduplicator.total()));
+    dialog.setValue(static_cast<int>(deduplicator.processed()));
+  });
 
-        auto parent2 = QDir::toNativeSeparators(info.path.left(info.path.size()-info.name.size()));
+  timer.start(100);
+  deduplicator.start();
+  loop.exec();
+  timer.stop();
 
-        emit found(name, parent1, entry.size, parent2, info.size);
+  report = deduplicator.report();
 
-        break;
-      }
-    }
-  }
+  return !deduplicator.isCancelled();
+}
+
+//--------------------------------------------------------------------
+void Duplicates::onFoundBatch(const DuplicateBatch& batch)
+{
+  auto thread = qobject_cast<ScanThread *>(sender());
+  if(thread) m_inspected->setText(QString::number(thread->inspected()));
 
-  m_directories[hashValue] << info;
+  ++m_batches;
+  m_model->append(batch);
 
-  return size;
+  m_inserted->setText(QString::number(m_model->rowCount()));
 }
 
 //--------------------------------------------------------------------
-void Duplicates::onMenuRequested(const QPoint& pos)
+void Duplicates::onFoundGroup(const DuplicateGroup& group)
 {
-  auto item = m_table->itemAt(pos);
-  if(item)
-  {
-    auto row = item->row();
-    auto original = m_table->item(row,1)->text() + m_table->item(row,0)->text() + QDir::separator();
-    auto duplicate = m_table->item(row,3)->text() + m_table->item(row,0)->text() + QDir::separator();
+  Q_UNUSED(group);
 
-    QMenu menu{this};
+  m_groups->setText(QString::number(++m_found));
+}
 
-    auto action = menu.addAction(tr("Open original folder '%1'").arg(original));
-    action->setData(original);
-    connect(action, SIGNAL(triggered(bool)), this, SLOT(onActionTriggered()));
+//--------------------------------------------------------------------
+void Duplicates::onWatching()
+{
+  m_progress->setValue(0);
+  m_progress->setEnabled(false);
 
-    action = menu.addAction(tr("Open duplicated folder '%1'").arg(duplicate));
-    action->setData(duplicate);
-    connect(action, SIGNAL(triggered(bool)), this, SLOT(onActionTriggered()));
+  m_search->setEnabled(true);
+  m_search->setToolTip(tr("Stop watching for changes"));
+  m_pause->setEnabled(false);
+}
 
-    menu.exec(m_table->viewport()->mapToGlobal(pos));
-  }
+//--------------------------------------------------------------------
+void Duplicates::onGroupRemoved(quint64 key)
+{
+  m_found -= m_model->remove(key);
+  m_inserted->setText(QString::number(m_model->rowCount()));
+  m_groups->setText(QString::number(m_found));
 }
 
 //--------------------------------------------------------------------
-ScanThread::ScanThread(const QDir& directory, QObject* parent)
-: QThread(parent)
-, m_directory{directory}
+void Duplicates::onPauseToggled(bool paused)
 {
+  if(m_thread) m_thread->setPaused(paused);
+
+  m_pause->setToolTip(paused ? tr("Resume the scan") : tr("Pause the scan"));
 }
 
 //--------------------------------------------------------------------
-void ScanThread::run()
+void Duplicates::onBackgroundChanged()
 {
-  if(m_directory.exists() && m_directory.isReadable())
-  {
-    const auto dirEntries = m_directory.entryInfoList(QDir::Filter::NoDotAndDotDot|QDir::Filter::AllDirs);
-    for(int i = 0; i < dirEntries.size(); ++i)
-    {
-      auto entry = dirEntries.at(i);
-      processDirectory(entry.absoluteFilePath());
+  if(m_thread) m_thread->setBackground(throttleOptions());
+}
 
-      emit progress(100*i/dirEntries.size());
-    }
+//--------------------------------------------------------------------
+void Duplicates::updateProxy()
+{
+  const auto fileBacked = !m_model->fileName().isEmpty();
+  QAbstractItemModel *model = fileBacked ? static_cast<QAbstractItemModel *>(m_model) : m_proxy;
+  if(m_table->model() == model) return;
+
+  // the proxy maps every row and its sort decodes them all, the rows of a results file are
+  // sorted and filtered by the model on the records of the file. The shown order and filter stay.
+  const auto header  = m_table->horizontalHeader();
+  const auto section = header->sortIndicatorSection();
+  const auto order   = header->sortIndicatorOrder();
+
+  m_proxy->setSourceModel(fileBacked ? nullptr : m_model);
+  m_table->setModel(model);
+
+  onFilterChanged(m_filter->text());
+  model->sort(section, order);
+  header->setSortIndicator(section, order);
+}
+
+//--------------------------------------------------------------------
+void Duplicates::onFilterChanged(const QString &text)
+{
+  if(m_table->model() == m_proxy) m_proxy->setFilterFixedString(text);
+  else                            m_model->setFilter(text);
+}
+
+//--------------------------------------------------------------------
+int Duplicates::sourceRow(const QModelIndex &index) const
+{
+  return m_table->model() == m_proxy ? m_proxy->mapToSource(index).row() : index.row();
+}
+
+//--------------------------------------------------------------------
+ThrottleOptions Duplicates::throttleOptions() const
+{
+  ThrottleOptions options;
+  options.lowPriority = m_lowPriority->isChecked();
+  options.operations  = m_operations->value();
+  options.bytes       = static_cast<qint64>(m_read->value()) * 1024 * 1024;
+  options.backoff     = m_backoff->isChecked();
+
+  return options;
+}
+
+//--------------------------------------------------------------------
+void Duplicates::onOpenPressed()
+{
+  const auto fileName = QFileDialog::getOpenFileName(this, tr("Open results"), QDir::homePath(), tr("Results files (*.dat *.results);;All files (*)"));
+  if(fileName.isEmpty()) return;
+
+  if(!m_model->open(fileName))
+  {
+    QMessageBox::warning(this, tr("Open results"), tr("Unable to read the results file '%1'.").arg(QDir::toNativeSeparators(fileName)));
   }
+  updateProxy();
+
+  m_inserted->setText(QString::number(m_model->rowCount()));
+  m_export->setEnabled(!m_model->fileName().isEmpty());
 }
 
 //--------------------------------------------------------------------
-void Duplicates::onFound(const QString& name, const QString& parent1, const float size1, const QString& parent2, const float size2)
+void Duplicates::onExportPressed()
 {
-  auto thread = qobject_cast<ScanThread *>(sender());
-  if(thread) m_inspected->setText(QString::number(thread->inspected()));
+  QString filter;
+  const auto fileName = QFileDialog::getSaveFileName(this, tr("Export results"), QDir::homePath(), tr("CSV files (*.csv);;JSON lines files (*.json)"), &filter);
+  if(fileName.isEmpty()) return;
+
+  ResultFile results;
+  QFile file{fileName};
+  if(!results.open(m_model->fileName()) || !file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+  {
+    QMessageBox::warning(this, tr("Export results"), tr("Unable to write the file '%1'.").arg(QDir::toNativeSeparators(fileName)));
+    return;
+  }
 
-  const auto rows = m_table->rowCount();
-  m_table->insertRow(rows);
+  QApplication::setOverrideCursor(Qt::WaitCursor);
 
-  auto item = new QTableWidgetItem {tr("%1").arg(name)}; //Name
-  m_table->setItem(rows, 0, item);
+  const auto format = filter.contains("csv") ? ResultWriter::Format::CSV : ResultWriter::Format::NDJSON;
+  ResultWriter writer(&file, format);
+  results.write(writer);
 
-  item = new QTableWidgetItem{tr("%1").arg(parent1)}; //Parent 1
-  m_table->setItem(rows, 1, item);
+  QApplication::restoreOverrideCursor();
+}
+
+//--------------------------------------------------------------------
+void Duplicates::onExclusionsPressed()
+{
+  const auto help = tr("One rule per line:\n"
+                       "  skip <pattern>: the folder is never listed.\n"
+                       "  ignore <pattern>: the folder is listed but not reported.\n"
+                       "  min-size <bytes>, max-depth <levels>, same-device, no-symlinks.\n"
+                       "Patterns are names or prefix:, glob: or regex: followed by the text, ignoring case.");
+
+  auto rules = m_rules;
+  while(true)
+  {
+    bool accepted = false;
+    rules = QInputDialog::getMultiLineText(this, tr("Exclusion rules"), help, rules, &accepted);
+    if(!accepted) break;
 
-  item = new QTableWidgetItem{tr("%1").arg(size1)}; //Size 1
-  m_table->setItem(rows, 2, item);
+    QString error;
+    if(ExclusionRules().parse(rules, error))
+    {
+      m_rules = rules;
+      break;
+    }
 
-  item = new QTableWidgetItem{tr("%1").arg(parent2)}; //Parent 2
-  m_table->setItem(rows, 3, item);
+    QMessageBox msgBox;
+    msgBox.setWindowTitle(tr("Error"));
+    msgBox.setWindowIcon(QIcon(":/Duplicates/folder.svg"));
+    msgBox.setText(error);
+    msgBox.setIcon(QMessageBox::Icon::Critical);
+    msgBox.exec();
+  }
 
-  item = new QTableWidgetItem{tr("%1").arg(size2)}; //Size 2
-  m_table->setItem(rows, 4, item);
+  m_exclusions->setDown(false);
+}
 
-  m_inserted->setText(tr("%1").arg(m_inserted->text().toInt() + 1));
+//--------------------------------------------------------------------
+void Duplicates::updateStatistics()
+{
+  if(!m_thread) return;
+
+  // changes in the folders that couldn't be watched are missed, the results may be outdated.
+  const auto unwatched = m_thread->unwatched();
+  const auto remaining = m_thread->remainingTime();
+  if(unwatched > 0)      m_progress->setFormat(tr("%1 folders not watched, the watch limit was reached").arg(unwatched));
+  else if(remaining > 0) m_progress->setFormat(tr("%p% (%1 left)").arg(ScanStatistics::duration(remaining)));
+  else                   m_progress->setFormat("%p%");
+
+  if(!m_statistics->isChecked()) return;
+
+  const auto statistics = m_thread->statistics();
+  const QLocale locale;
+
+  auto milliseconds = [&statistics, &locale](const ScanStatistics::Phase phase)
+  { return locale.toString(statistics.phases[static_cast<int>(phase)] / 1e6, 'f', 0); };
+
+  QStringList lines;
+  lines << tr("Elapsed %1 ms. Index load %2 ms, estimate %8 ms, traversal %3 ms, index save %4 ms, match %5 ms (content verification %6 ms), refresh %7 ms.")
+           .arg(locale.toString(statistics.elapsed / 1e6, 'f', 0))
+           .arg(milliseconds(ScanStatistics::Phase::LOAD_INDEX))
+           .arg(milliseconds(ScanStatistics::Phase::TRAVERSAL))
+           .arg(milliseconds(ScanStatistics::Phase::SAVE_INDEX))
+           .arg(milliseconds(ScanStatistics::Phase::MATCH))
+           .arg(milliseconds(ScanStatistics::Phase::VERIFICATION))
+           .arg(milliseconds(ScanStatistics::Phase::REFRESH))
+           .arg(milliseconds(ScanStatistics::Phase::ESTIMATE));
+
+  lines << tr("%1 folders (%2/s, %3 from the index, %4 already seen), %5 files (%6/s). %7 listings (%8 failed), %9 system calls, %10 stats.")
+           .arg(locale.toString(statistics.directories))
+           .arg(locale.toString(statistics.directoriesPerSecond(), 'f', 0))
+           .arg(locale.toString(statistics.reused))
+           .arg(locale.toString(statistics.aliases))
+           .arg(locale.toString(statistics.files))
+           .arg(locale.toString(statistics.filesPerSecond(), 'f', 0))
+           .arg(locale.toString(statistics.lists))
+           .arg(locale.toString(statistics.failures))
+           .arg(locale.toString(statistics.syscalls))
+           .arg(locale.toString(statistics.stats));
+
+  // batches still queued in the event loop are the ones emitted but not yet received.
+  lines << tr("%1 files hashed (%2 MB). Table load factor %3, %4 probes per lookup. %5 batches pending.")
+           .arg(locale.toString(statistics.filesHashed))
+           .arg(locale.toString(statistics.bytesHashed / (1024. * 1024.), 'f', 1))
+           .arg(locale.toString(statistics.loadFactor, 'f', 2))
+           .arg(locale.toString(statistics.probes, 'f', 2))
+           .arg(locale.toString(statistics.batches - m_batches));
+
+  m_stats->setText(lines.join("\n"));
 }
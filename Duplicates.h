@@ -22,91 +22,18 @@
 
 // Project
 #include <ui_Duplicates.h>
+#include "ScanThread.h"
+#include "Deduplicator.h"
 
 // Qt
 #include <QMainWindow>
-#include <QThread>
-#include <QHash>
-#include <QDir>
-
-// Boost
-#include <boost/functional/hash/extensions.hpp>
-#include <boost/functional/hash.hpp>
-
-// C++
-#include <crtdefs.h>
-#include <string.h>
 
 class QAction;
 class QMenu;
 class QPlainTextEdit;
-
-/** \class ScanThread
- * \brief Thread for scanning a path.
- *
- */
-class ScanThread
-: public QThread
-{
-    Q_OBJECT
-  public:
-    /** \brief ScanThread class constructor.
-     * \param[in] directory Starting directory.
-     * \param[in] parent Raw pointer of the object parent of this one.
-     *
-     */
-    explicit ScanThread(const QDir &directory, QObject *parent = nullptr);
-
-    /** \brief ScanThread class virtual destructor.
-     *
-     */
-    virtual ~ScanThread()
-    {};
-
-    /** \brief Returns the number of inspected directories.
-     *
-     */
-    int inspected() const
-    { return m_directories.size(); }
-
-  signals:
-    void progress(int);
-    void found(const QString &name, const QString &parent1, const float size1, const QString &parent2, const float size2);
-
-  protected:
-    virtual void run() override;
-
-  private:
-    /** \brief Process a directories recursively and returns the size in megabytes.
-     * \param[in] directoryPath Directory path.
-     *
-     */
-    const float processDirectory(const QString &directoryPath);
-
-    /** \struct DirectoryInfo
-     * \brief Holds directory information.
-     *
-     */
-    struct DirectoryInfo
-    {
-      QString name; /** directory basename.  */
-      QString path; /** directory full path. */
-      float   size; /** size in megabytes.   */
-    };
-
-    /** \brief Returns the hash of the given DirectoryInfo struct.
-     * \param[in] info DirectoryInfo struct reference.
-     *
-     */
-    std::size_t hash(const DirectoryInfo &info)
-    {
-      boost::hash<std::string> hasher;
-      return hasher(info.name.toStdString());
-    };
-
-    const QDir m_directory; /** starting directory. */
-    QHash<std::size_t, QList<struct DirectoryInfo>> m_directories; /** stores the directory information mapped with its hash. */
-};
+class QSortFilterProxyModel;
+class QTimer;
+class DuplicatesModel;
 
 /** \class Duplicates
  * \brief Main dialog implementation.
@@ -139,6 +66,11 @@ class Duplicates
 	   */
 	  void openFolderSelectionDialog();
 
+	  /** \brief Dialog to get another folder to search for duplicates along the others.
+	   *
+	   */
+	  void addFolder();
+
 	  /** \brief Scans the contents of folder for duplicates.
 	   *
 	   */
@@ -155,22 +87,116 @@ class Duplicates
 	   */
 	  void onActionTriggered();
 
-	  /** \brief Inserts a row in the table with the given info.
-	   * \param[in] name Directory name.
-	   * \param[in] parent1 First parent name.
-	   * \param[in] size1 First parent size in megabytes.
-     * \param[in] parent2 Second parent name.
-     * \param[in] size2 Second parent size in megabytes.
-     *
+	  /** \brief Replaces the files of the selected duplicated folders with links to their originals,
+	   *        after showing what would be reclaimed.
+	   *
 	   */
-	  void onFound(const QString &name, const QString &parent1, const float size1, const QString &parent2, const float size2);
+	  void onDeduplicateTriggered();
+
+	  /** \brief Adds the given duplicates to the table.
+	   * \param[in] batch Duplicates found.
+	   *
+	   */
+	  void onFoundBatch(const DuplicateBatch &batch);
+
+	  /** \brief Updates the number of duplicate groups.
+	   * \param[in] group Directories with the same name.
+	   *
+	   */
+	  void onFoundGroup(const DuplicateGroup &group);
 
 	  /** \brief Updates the GUI when the scan thread finishes.
 	   *
 	   */
 	  void onThreadFinished();
 
+	  /** \brief Lets the search button stop the scan thread once it starts watching for changes.
+	   *
+	   */
+	  void onWatching();
+
+	  /** \brief Removes the rows of the groups of the given key, the scan thread reports them
+	   *        again after a change.
+	   * \param[in] key Matching key of the groups.
+	   *
+	   */
+	  void onGroupRemoved(quint64 key);
+
+	  /** \brief Shows only the rows with the given text in any column.
+	   * \param[in] text Filter text.
+	   *
+	   */
+	  void onFilterChanged(const QString &text);
+
+	  /** \brief Pauses or resumes the traversal of the scan thread.
+	   * \param[in] paused True to pause and false to resume.
+	   *
+	   */
+	  void onPauseToggled(bool paused);
+
+	  /** \brief Applies the background settings to the running scan thread.
+	   *
+	   */
+	  void onBackgroundChanged();
+
+	  /** \brief Lets the user edit the exclusion rules.
+	   *
+	   */
+	  void onExclusionsPressed();
+
+	  /** \brief Lets the user open the results file of a previous scan.
+	   *
+	   */
+	  void onOpenPressed();
+
+	  /** \brief Lets the user export the shown results to a CSV or JSON file.
+	   *
+	   */
+	  void onExportPressed();
+
+	  /** \brief Shows the performance statistics of the scan thread.
+	   *
+	   */
+	  void updateStatistics();
+
 	private:
+	  /** \brief Helper method that asks the user for a folder and returns its path with native
+	   *        separators, or an empty string if cancelled.
+	   *
+	   */
+	  QString selectFolder();
+
+	  /** \brief Returns the folders to search for duplicates.
+	   *
+	   */
+	  QStringList folders() const;
+
+	  /** \brief Runs a deduplicator with the given folders and configuration showing its progress.
+	   *        Returns false if the user cancelled it.
+	   * \param[in] pairs Original and duplicated folders.
+	   * \param[in] options Deduplication configuration.
+	   * \param[out] report Outcome of the deduplication.
+	   *
+	   */
+	  bool deduplicate(const QVector<QPair<QString, QString>> &pairs, const DeduplicationOptions &options, DeduplicationReport &report);
+
+	  /** \brief Shows the rows of a results file straight from the model, which sorts and
+	   *        filters them, and the rows kept in memory through the proxy.
+	   *
+	   */
+	  void updateProxy();
+
+	  /** \brief Returns the model row of the given table index.
+	   * \param[in] index Table index.
+	   *
+	   */
+	  int sourceRow(const QModelIndex &index) const;
+
+	  /** \brief Returns the background mode settings of the scan.
+	   *
+	   */
+	  ThrottleOptions throttleOptions() const;
+
 	  /** \brief Helper method to connect UI signals.
 	   *
 	   */
@@ -186,7 +212,30 @@ class Duplicates
 	   */
 	  void saveSettings();
 
-	  static const QString FOLDER; /** Folder settings text key. */
+	  static const QString FOLDER;  /** Folder settings text key.  */
+	  static const QString THREADS; /** Threads settings text key. */
+	  static const QString NATIVE;  /** Native enumeration settings text key. */
+	  static const QString URING;   /** io_uring stats settings text key. */
+	  static const QString MODE;    /** Matching mode settings text key. */
+	  static const QString INCREMENTAL; /** Incremental scan settings text key. */
+	  static const QString WATCH;   /** Watch mode settings text key. */
+	  static const QString STATISTICS; /** Statistics panel settings text key. */
+	  static const QString EXCLUSIONS; /** Exclusion rules settings text key. */
+	  static const QString LOW_PRIORITY; /** Low priority settings text key. */
+	  static const QString OPERATIONS; /** Operations limit settings text key. */
+	  static const QString READ_LIMIT; /** Read limit settings text key. */
+	  static const QString BACKOFF; /** Latency backoff settings text key. */
+
+	  static const QString FOLDER_SEPARATOR; /** folders separator in the folder field. */
+
+	  ScanThread            *m_thread; /** running scan thread or nullptr.    */
+	  DuplicatesModel       *m_model;  /** duplicates table model.            */
+	  QSortFilterProxyModel *m_proxy;  /** sorted and filtered table model.   */
+	  int                    m_found;  /** number of duplicate groups found.  */
+	  qint64                 m_batches;/** number of duplicate batches received. */
+	  QString                m_resultsFile; /** results file of the last scan.    */
+	  QTimer                *m_timer;  /** statistics refresh timer.          */
+	  QString                m_rules;  /** exclusion rules text.              */
 };
 
 #endif /* DUPLICATES_H_ */
@@ -0,0 +1,529 @@
+/*
+ File: DuplicatesCli.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ScanThread.h"
+#include "ScanIndex.h"
+#include "ResultWriter.h"
+#include "ResultFile.h"
+#include "Deduplicator.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+
+// C++
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+  std::atomic<bool> interrupted{false}; /** true once the user interrupts the scans. */
+
+  //-----------------------------------------------------------------
+  void onInterrupt(int)
+  {
+    interrupted = true;
+  }
+
+  //-----------------------------------------------------------------
+  bool readThrottle(const QString &fileName, ThrottleOptions &options, QString &error)
+  {
+    QFile file{fileName};
+    if(!file.open(QIODevice::ReadOnly|QIODevice::Text))
+    {
+      error = "Unable to read the throttle file: " + fileName;
+      return false;
+    }
+
+    return options.parse(QString::fromUtf8(file.readAll()), error);
+  }
+}
+
+//-----------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("Duplicates");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Finds duplicated folders and writes the groups to the standard output as they are found.");
+  parser.addHelpOption();
+
+  const QCommandLineOption threadsOption (QStringList{"t", "threads"}, "Number of traversal threads of each solid state device, 0 to use the number of cores.", "count", "0");
+  const QCommandLineOption diskThreadsOption("disk-threads", "Number of traversal threads of each rotational disk.", "count", "2");
+  const QCommandLineOption combineOption (QStringList{"c", "combine"}, "Scan all the folders together, finding the duplicates between them.");
+  const QCommandLineOption modeOption    (QStringList{"m", "mode"},    "Matching mode: names, structure, content or similar.", "mode", "names");
+  const QCommandLineOption formatOption  (QStringList{"f", "format"},  "Output format: ndjson or csv.", "format", "ndjson");
+  const QCommandLineOption indexOption   (QStringList{"i", "index"},   "Scan index file, reused and updated by incremental scans.", "file");
+  const QCommandLineOption incrementalOption("incremental", "Use the default scan index file of every folder. Folders are reused by their modification time alone, files rewritten in place are missed.");
+  const QCommandLineOption qtOption      ("qt-listing", "List directories with Qt instead of native system calls.");
+  const QCommandLineOption uringOption   ("io-uring", "Batch the file stats of each folder of the native listing in an io_uring, if the system allows it. Folders are still opened and read one at a time, so trees with few files per folder gain little.");
+  const QCommandLineOption mapOption     ("mmap", "Hash memory maps of the files in content mode.");
+  const QCommandLineOption traceOption   ("trace", "Chrome trace file of the scan phases and workers.", "file");
+  const QCommandLineOption statsOption   ("stats", "Write the performance statistics of each scan to the standard error as JSON.");
+  const QCommandLineOption progressOption("progress", "Write the progress and the estimated time left of each scan to the standard error.");
+  const QCommandLineOption rulesOption   ("rules", "Exclusion rules file, replaces the default rules.", "file");
+  const QCommandLineOption normalizeOption("normalize", "Similar names normalization: comma separated brackets, years, accents, case and punctuation, or none.", "steps", "brackets,years,accents,case,punctuation");
+  const QCommandLineOption similarityOption("similarity", "Minimum trigram Jaccard similarity of similar names.", "value", "0.6");
+  const QCommandLineOption distanceOption("distance", "Compare similar names by edit distance up to this value instead of by trigrams.", "edits");
+  const QCommandLineOption checkpointOption("checkpoint", "Checkpoint file written when interrupted and read to resume the scan, instead of the default one of the folder.", "file");
+  const QCommandLineOption intervalOption("checkpoint-interval", "Seconds between checkpoints during the traversal, 0 to write it only when interrupted.", "seconds", "300");
+  const QCommandLineOption backgroundOption("background", "Run the scan with idle I/O priority and the lowest CPU priority.");
+  const QCommandLineOption operationsOption("max-operations", "Entries listed and stated per second, 0 for no limit.", "count", "0");
+  const QCommandLineOption readOption    ("max-read", "Megabytes of file contents read per second, 0 for no limit.", "megabytes", "0");
+  const QCommandLineOption backoffOption ("backoff", "Slow down while the listings take longer than usual.");
+  const QCommandLineOption throttleOption("throttle-file", "Background settings file, read again when it changes during the scan. Replaces the other background options.", "file");
+  const QCommandLineOption saveOption    ("save", "Results file of the scan, to export or to compare with the results of a later one.", "file");
+  const QCommandLineOption exportOption  ("export", "Write the groups of a results file in the output format instead of scanning.", "file");
+  const QCommandLineOption diffOption    ("diff", "Compare two results files instead of scanning, writing the groups that are new, resolved, grown, shrunk or changed.");
+  const QCommandLineOption deduplicateOption("deduplicate", "Replace the files of the duplicated folders of a results file with links to the files of their originals instead of scanning. Only reports what would be reclaimed unless applied.", "file");
+  const QCommandLineOption linkOption    ("link-method", "Replacement of the deduplicated files: reflink, or hardlink for files with the same owner, permissions, modification time and extended attributes.", "method", "reflink");
+  const QCommandLineOption applyOption   ("apply", "Replace the deduplicated files instead of only reporting them.");
+  const QCommandLineOption groupOption   ("group", "Number of a group of the results file to deduplicate, as exported, can be repeated. All the groups if not given.", "number");
+  const QCommandLineOption excludeOption (QStringList{"x", "exclude"}, "Exclusion rule added to the others, can be repeated (e.g. \"skip glob:*.snapshot\").", "rule");
+
+  parser.addOptions({threadsOption, diskThreadsOption, combineOption, modeOption, formatOption, indexOption, incrementalOption, qtOption, uringOption, mapOption, traceOption, statsOption, progressOption, rulesOption, excludeOption, normalizeOption, similarityOption, distanceOption, checkpointOption, intervalOption, backgroundOption, operationsOption, readOption, backoffOption, throttleOption, saveOption, exportOption, diffOption, deduplicateOption, linkOption, applyOption, groupOption});
+  parser.addPositionalArgument("folders", "Folders to scan, each one on its own unless combined, or the earlier and later results files to compare.", "<folder>...");
+
+  parser.process(app);
+
+  const auto folders = parser.positionalArguments();
+  if(folders.isEmpty() && !parser.isSet(exportOption) && !parser.isSet(deduplicateOption)) parser.showHelp(1);
+
+  ScanOptions options;
+
+  bool ok = false;
+  options.threads = parser.value(threadsOption).toInt(&ok);
+  if(!ok || options.threads < 0)
+  {
+    std::cerr << "Invalid number of threads: " << parser.value(threadsOption).toStdString() << std::endl;
+    return 1;
+  }
+
+  options.rotationalThreads = parser.value(diskThreadsOption).toInt(&ok);
+  if(!ok || options.rotationalThreads < 1)
+  {
+    std::cerr << "Invalid number of disk threads: " << parser.value(diskThreadsOption).toStdString() << std::endl;
+    return 1;
+  }
+
+  const auto combine = parser.isSet(combineOption);
+
+  const auto mode = parser.value(modeOption).toLower();
+  if(mode == "names")          options.mode = ScanOptions::Mode::NAMES;
+  else if(mode == "structure") options.mode = ScanOptions::Mode::STRUCTURE;
+  else if(mode == "content")   options.mode = ScanOptions::Mode::CONTENT;
+  else if(mode == "similar")   options.mode = ScanOptions::Mode::SIMILAR;
+  else
+  {
+    std::cerr << "Invalid mode: " << mode.toStdString() << std::endl;
+    return 1;
+  }
+
+  const auto format = ResultWriter::format(parser.value(formatOption), ok);
+  if(!ok)
+  {
+    std::cerr << "Invalid format: " << parser.value(formatOption).toStdString() << std::endl;
+    return 1;
+  }
+
+  if(parser.isSet(diffOption))
+  {
+    if(folders.size() != 2)
+    {
+      std::cerr << "Two results files are needed to compare them." << std::endl;
+      return 1;
+    }
+
+    QFile output;
+    output.open(stdout, QIODevice::WriteOnly);
+    ResultWriter writer(&output, format, true);
+
+    ResultFile later;
+    const auto root = later.open(folders.last()) ? later.root() : QString();
+
+    QVector<int> counts(static_cast<int>(ResultFile::Change::CHANGED) + 1, 0);
+    auto onChange = [&writer, &root, &counts](const ResultFile::Change change, const DuplicateGroup &before, const DuplicateGroup &after)
+    {
+      ++counts[static_cast<int>(change)];
+      if(change == ResultFile::Change::UNCHANGED) return;
+
+      writer.write(change == ResultFile::Change::RESOLVED ? before : after, root, ResultFile::name(change));
+    };
+
+    if(!ResultFile::diff(folders.first(), folders.last(), onChange))
+    {
+      std::cerr << "Unable to compare the results files, they must be readable and of the same mode." << std::endl;
+      return 2;
+    }
+
+    for(int i = 0; i < counts.size(); ++i)
+    {
+      std::cerr << (i > 0 ? ", " : "") << counts.at(i) << " " << ResultFile::name(static_cast<ResultFile::Change>(i)).toStdString();
+    }
+    std::cerr << " duplicate groups." << std::endl;
+
+    return 0;
+  }
+
+  if(parser.isSet(exportOption))
+  {
+    ResultFile results;
+    if(!results.open(parser.value(exportOption)))
+    {
+      std::cerr << "Unable to read the results file: " << parser.value(exportOption).toStdString() << std::endl;
+      return 2;
+    }
+
+    QFile output;
+    output.open(stdout, QIODevice::WriteOnly);
+    ResultWriter writer(&output, format);
+    results.write(writer);
+
+    std::cerr << writer.groups() << " duplicate groups exported." << std::endl;
+
+    return 0;
+  }
+
+  if(parser.isSet(deduplicateOption))
+  {
+    if(!Deduplicator::isAvailable())
+    {
+      std::cerr << "Deduplication is not available on this system." << std::endl;
+      return 1;
+    }
+
+    DeduplicationOptions deduplication;
+    deduplication.threads = options.threads;
+    deduplication.dryRun  = !parser.isSet(applyOption);
+
+    const auto method = parser.value(linkOption).toLower();
+    if(method == "reflink")       deduplication.method = DeduplicationOptions::Method::REFLINK;
+    else if(method == "hardlink") deduplication.method = DeduplicationOptions::Method::HARDLINK;
+    else
+    {
+      std::cerr << "Invalid link method: " << method.toStdString() << std::endl;
+      return 1;
+    }
+
+    ResultFile results;
+    if(!results.open(parser.value(deduplicateOption)))
+    {
+      std::cerr << "Unable to read the results file: " << parser.value(deduplicateOption).toStdString() << std::endl;
+      return 2;
+    }
+
+    QVector<qint64> groups;
+    for(const auto &value: parser.values(groupOption))
+    {
+      const auto number = value.toLongLong(&ok);
+      if(!ok || number < 1 || number > results.groups())
+      {
+        std::cerr << "Invalid group number: " << value.toStdString() << std::endl;
+        return 1;
+      }
+      groups << number - 1;
+    }
+    if(groups.isEmpty())
+    {
+      for(qint64 i = 0; i < results.groups(); ++i) groups << i;
+    }
+
+    Deduplicator deduplicator(deduplication);
+    for(const auto index: groups)
+    {
+      const auto group = results.group(index);
+      for(int i = 1; i < group.names.size(); ++i)
+      {
+        deduplicator.add(group.parents.first() + group.names.first(), group.parents.at(i) + group.names.at(i));
+      }
+    }
+
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+
+    deduplicator.start();
+
+    int ticks = 0;
+    while(!deduplicator.wait(100))
+    {
+      if(interrupted && !deduplicator.isCancelled()) deduplicator.stop();
+
+      if(++ticks % 10 == 0 && parser.isSet(progressOption))
+      {
+        std::cerr << "\r" << deduplicator.processed() << " of " << deduplicator.total() << " files    " << std::flush;
+      }
+    }
+
+    if(ticks >= 10 && parser.isSet(progressOption)) std::cerr << std::endl;
+
+    const auto &report = deduplicator.report();
+    for(const auto &error: report.errors)
+    {
+      std::cerr << error.toStdString() << std::endl;
+    }
+
+    std::cerr << report.files << " files compared, " << report.identical << " identical, " << report.shared << " already shared, "
+              << report.skipped << " skipped, " << report.failed << " failed." << std::endl;
+    std::cerr << report.replaced << " files " << (deduplication.dryRun ? "would be" : "were") << " replaced, reclaiming "
+              << QString::number(report.bytes / (1024. * 1024.), 'f', 1).toStdString() << " MB." << std::endl;
+
+    if(deduplicator.isCancelled()) return 3;
+
+    return report.failed > 0 ? 2 : 0;
+  }
+
+  if(parser.isSet(saveOption) && folders.size() > 1 && !combine)
+  {
+    std::cerr << "A results file can only be saved for a single folder or combined folders." << std::endl;
+    return 1;
+  }
+
+  if(parser.isSet(indexOption) && folders.size() > 1 && !combine)
+  {
+    std::cerr << "An index file can only be given for a single folder or combined folders." << std::endl;
+    return 1;
+  }
+
+  if(parser.isSet(traceOption) && folders.size() > 1 && !combine)
+  {
+    std::cerr << "A trace file can only be given for a single folder or combined folders." << std::endl;
+    return 1;
+  }
+
+  if(parser.isSet(checkpointOption) && folders.size() > 1 && !combine)
+  {
+    std::cerr << "A checkpoint file can only be given for a single folder or combined folders." << std::endl;
+    return 1;
+  }
+
+  options.checkpointInterval = parser.value(intervalOption).toInt(&ok);
+  if(!ok || options.checkpointInterval < 0)
+  {
+    std::cerr << "Invalid checkpoint interval: " << parser.value(intervalOption).toStdString() << std::endl;
+    return 1;
+  }
+
+  options.background.lowPriority = parser.isSet(backgroundOption);
+  options.background.backoff     = parser.isSet(backoffOption);
+  options.background.operations  = parser.value(operationsOption).toInt(&ok);
+  if(!ok || options.background.operations < 0)
+  {
+    std::cerr << "Invalid operations limit: " << parser.value(operationsOption).toStdString() << std::endl;
+    return 1;
+  }
+
+  const auto readLimit = parser.value(readOption).toDouble(&ok);
+  if(!ok || readLimit < 0.)
+  {
+    std::cerr << "Invalid read limit: " << parser.value(readOption).toStdString() << std::endl;
+    return 1;
+  }
+  options.background.bytes = static_cast<qint64>(readLimit * 1024 * 1024);
+
+  // the throttle file is watched during the scans, it's how the limits change at runtime.
+  const auto throttleFile = parser.value(throttleOption);
+  QDateTime throttleModified;
+  if(!throttleFile.isEmpty())
+  {
+    QString error;
+    if(!readThrottle(throttleFile, options.background, error))
+    {
+      std::cerr << error.toStdString() << std::endl;
+      return 1;
+    }
+    throttleModified = QFileInfo{throttleFile}.lastModified();
+  }
+
+  options.fuzzy.normalization = 0;
+  for(const auto &step: parser.value(normalizeOption).split(','))
+  {
+    const auto name = step.trimmed().toLower();
+    if(name.isEmpty() || name == "none") continue;
+
+    if(name == "brackets")         options.fuzzy.normalization |= FuzzyOptions::BRACKETS;
+    else if(name == "years")       options.fuzzy.normalization |= FuzzyOptions::YEARS;
+    else if(name == "accents")     options.fuzzy.normalization |= FuzzyOptions::ACCENTS;
+    else if(name == "case")        options.fuzzy.normalization |= FuzzyOptions::CASE;
+    else if(name == "punctuation") options.fuzzy.normalization |= FuzzyOptions::PUNCTUATION;
+    else
+    {
+      std::cerr << "Invalid normalization step: " << name.toStdString() << std::endl;
+      return 1;
+    }
+  }
+
+  options.fuzzy.similarity = parser.value(similarityOption).toDouble(&ok);
+  if(!ok || options.fuzzy.similarity <= 0 || options.fuzzy.similarity > 1)
+  {
+    std::cerr << "Invalid similarity: " << parser.value(similarityOption).toStdString() << std::endl;
+    return 1;
+  }
+
+  if(parser.isSet(distanceOption))
+  {
+    options.fuzzy.metric   = FuzzyOptions::Metric::EDIT_DISTANCE;
+    options.fuzzy.distance = parser.value(distanceOption).toInt(&ok);
+    if(!ok || options.fuzzy.distance < 0)
+    {
+      std::cerr << "Invalid distance: " << parser.value(distanceOption).toStdString() << std::endl;
+      return 1;
+    }
+  }
+
+  options.backend   = parser.isSet(uringOption) ? DirectoryEnumerator::Backend::URING : DirectoryEnumerator::Backend::NATIVE;
+  if(parser.isSet(qtOption)) options.backend = DirectoryEnumerator::Backend::QT;
+  options.mapFiles  = parser.isSet(mapOption);
+  options.traceFile = parser.value(traceOption);
+
+  auto rules = ExclusionRules::defaults();
+  if(parser.isSet(rulesOption))
+  {
+    QFile file{parser.value(rulesOption)};
+    if(!file.open(QIODevice::ReadOnly|QIODevice::Text))
+    {
+      std::cerr << "Unable to read the rules file: " << parser.value(rulesOption).toStdString() << std::endl;
+      return 1;
+    }
+
+    rules = QString::fromUtf8(file.readAll());
+  }
+
+  for(const auto &rule: parser.values(excludeOption))
+  {
+    rules += "\n" + rule;
+  }
+
+  QString error;
+  if(!options.rules.parse(rules, error))
+  {
+    std::cerr << error.toStdString() << std::endl;
+    return 1;
+  }
+
+  QFile output;
+  output.open(stdout, QIODevice::WriteOnly);
+  ResultWriter writer(&output, format);
+
+  // the scan stops writing its checkpoint, the next run resumes it.
+  std::signal(SIGINT, onInterrupt);
+  std::signal(SIGTERM, onInterrupt);
+
+  int result = 0;
+  QList<QStringList> scans;
+  for(const auto &folder: folders)
+  {
+    const QDir directory{folder};
+    if(!directory.exists() || !directory.isReadable())
+    {
+      std::cerr << "Unable to read folder: " << folder.toStdString() << std::endl;
+      result = 2;
+      continue;
+    }
+
+    if(!combine || scans.isEmpty()) scans << QStringList();
+    scans.last() << directory.absolutePath();
+  }
+
+  for(const auto &paths: scans)
+  {
+    if(interrupted) break;
+
+    auto scanOptions = options;
+    if(parser.isSet(indexOption))       scanOptions.indexFile = parser.value(indexOption);
+    if(parser.isSet(incrementalOption)) scanOptions.indexFile = ScanIndex::defaultFile(paths);
+    scanOptions.checkpointFile = parser.isSet(checkpointOption) ? parser.value(checkpointOption) : ScanIndex::checkpointFile(paths);
+    scanOptions.resultsFile    = parser.value(saveOption);
+
+    const auto root = QDir::toNativeSeparators(paths.join(';'));
+
+    // groups are written from the scan thread, without going through an event loop.
+    ScanThread thread(paths, scanOptions);
+    QObject::connect(&thread, &ScanThread::foundGroup, [&writer, &root](const DuplicateGroup &group)
+    { writer.write(group, root); });
+
+    thread.start();
+
+    // the progress line is rewritten in place and the throttle file checked once a second.
+    int ticks = 0;
+    while(!thread.wait(100))
+    {
+      if(interrupted && !thread.isCancelled()) thread.stop();
+
+      if(++ticks % 10 != 0) continue;
+
+      if(!throttleFile.isEmpty())
+      {
+        const auto modified = QFileInfo{throttleFile}.lastModified();
+        if(modified.isValid() && modified != throttleModified)
+        {
+          throttleModified = modified;
+
+          auto background = thread.background();
+          QString error;
+          if(readThrottle(throttleFile, background, error)) thread.setBackground(background);
+          else std::cerr << std::endl << error.toStdString() << std::endl;
+        }
+      }
+
+      if(parser.isSet(progressOption))
+      {
+        const auto remaining = thread.remainingTime();
+        std::cerr << "\r" << root.toStdString() << ": " << static_cast<int>(100 * thread.completion()) << "%";
+        if(remaining > 0) std::cerr << ", " << ScanStatistics::duration(remaining).toStdString() << " left";
+        std::cerr << "    " << std::flush;
+      }
+    }
+
+    if(ticks >= 10 && parser.isSet(progressOption)) std::cerr << std::endl;
+
+    std::cerr << root.toStdString() << ": " << thread.inspected() << " folders inspected";
+    if(thread.devices() > 1) std::cerr << " on " << thread.devices() << " devices";
+    std::cerr << "." << std::endl;
+
+    if(thread.resumed() > 0)
+    {
+      std::cerr << root.toStdString() << ": " << thread.resumed() << " folders resumed from the checkpoint." << std::endl;
+    }
+
+    if(thread.isCancelled())
+    {
+      std::cerr << root.toStdString() << ": interrupted, run again to resume the scan." << std::endl;
+      result = 3;
+    }
+
+    if(parser.isSet(statsOption))
+    {
+      std::cerr << QJsonDocument(thread.statistics().toJson()).toJson(QJsonDocument::Compact).constData() << std::endl;
+    }
+  }
+
+  std::cerr << writer.groups() << " duplicate groups found." << std::endl;
+
+  return result;
+}
@@ -0,0 +1,253 @@
+/*
+ File: DuplicatesModel.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "DuplicatesModel.h"
+
+// Qt
+#include <QSet>
+
+// C++
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+//--------------------------------------------------------------------
+DuplicatesModel::DuplicatesModel(QObject* parent)
+: QAbstractTableModel(parent)
+, m_column   {-1}
+, m_order    {Qt::AscendingOrder}
+, m_arranged {false}
+, m_cachedRow{-1}
+{
+}
+
+//--------------------------------------------------------------------
+int DuplicatesModel::rowCount(const QModelIndex& parent) const
+{
+  if(parent.isValid()) return 0;
+
+  if(m_file.isOpen()) return static_cast<int>(std::min<qint64>(m_arranged ? m_shown.size() : m_file.rows(), std::numeric_limits<int>::max()));
+
+  return m_rows.size();
+}
+
+//--------------------------------------------------------------------
+int DuplicatesModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : COLUMNS;
+}
+
+//--------------------------------------------------------------------
+QVariant DuplicatesModel::data(const QModelIndex& index, int role) const
+{
+  if(!index.isValid() || index.row() >= rowCount()) return QVariant();
+
+  // the columns of a row are asked one after the other, the row is only read once.
+  const auto duplicate = m_file.isOpen() ? this->duplicate(index.row()) : m_rows.at(index.row());
+
+  switch(role)
+  {
+    case Qt::DisplayRole:
+      // sizes are numbers so the proxy model sorts them by value.
+      switch(index.column())
+      {
+        case 0: return duplicate.name1;
+        case 1: return duplicate.parent1;
+        case 2: return duplicate.size1;
+        case 3: return duplicate.name2;
+        case 4: return duplicate.parent2;
+        case 5: return duplicate.size2;
+        case 6: return qRound(duplicate.similarity * 100);
+        case 7: return duplicate.reclaimable;
+        default: break;
+      }
+      break;
+    case Qt::TextAlignmentRole:
+      if(index.column() == 2 || index.column() >= 5) return static_cast<int>(Qt::AlignRight|Qt::AlignVCenter);
+      break;
+    default:
+      break;
+  }
+
+  return QVariant();
+}
+
+//--------------------------------------------------------------------
+QVariant DuplicatesModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if(orientation == Qt::Horizontal && role == Qt::ToolTipRole)
+  {
+    switch(section)
+    {
+      case 6: return tr("Estimated share of the entries directly inside both folders, within about 6 points.");
+      case 7: return tr("Estimated size of the files directly inside the duplicated folder that are also in the original.");
+      default: break;
+    }
+  }
+
+  if(orientation != Qt::Horizontal || role != Qt::DisplayRole) return QAbstractTableModel::headerData(section, orientation, role);
+
+  switch(section)
+  {
+    case 0: return tr("Folder");
+    case 1: return tr("Original Parent");
+    case 2: return tr("Original Size (MB)");
+    case 3: return tr("Duplicated Folder");
+    case 4: return tr("Duplicated Parent");
+    case 5: return tr("Duplicated Size (MB)");
+    case 6: return tr("Similarity, est. (%)");
+    case 7: return tr("Reclaimable, est. (MB)");
+    default: break;
+  }
+
+  return QVariant();
+}
+
+//--------------------------------------------------------------------
+void DuplicatesModel::sort(int column, Qt::SortOrder order)
+{
+  // the rows added in batches are sorted by the proxy.
+  m_column = column;
+  m_order  = order;
+  if(!m_file.isOpen()) return;
+
+  beginResetModel();
+  arrange();
+  endResetModel();
+}
+
+//--------------------------------------------------------------------
+void DuplicatesModel::setFilter(const QString &text)
+{
+  if(text == m_filter) return;
+
+  m_filter = text;
+  if(!m_file.isOpen()) return;
+
+  beginResetModel();
+  arrange();
+  endResetModel();
+}
+
+//--------------------------------------------------------------------
+void DuplicatesModel::arrange()
+{
+  m_cachedRow = -1;
+  m_shown.clear();
+  m_arranged = m_file.isOpen() && ((m_column >= 0 && m_column < COLUMNS) || !m_filter.isEmpty());
+  if(!m_arranged) return;
+
+  if(m_column >= 0 && m_column < COLUMNS) m_shown = m_file.sortedRows(static_cast<ResultFile::Field>(m_column), m_order);
+  if(m_filter.isEmpty()) return;
+
+  const auto matching = m_file.matchingRows(m_filter);
+  if(m_shown.isEmpty())
+  {
+    m_shown = matching;
+    return;
+  }
+
+  // the matching rows come in file order, they are kept in the sorted order.
+  std::vector<bool> matches(m_file.rows(), false);
+  for(const auto row: matching) matches[row] = true;
+
+  m_shown.erase(std::remove_if(m_shown.begin(), m_shown.end(), [&matches](const qint64 row) { return !matches[row]; }), m_shown.end());
+}
+
+//--------------------------------------------------------------------
+void DuplicatesModel::append(const DuplicateBatch& batch)
+{
+  if(batch.isEmpty()) return;
+
+  if(m_file.isOpen()) clear();
+
+  beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + batch.size() - 1);
+  m_rows += batch;
+  endInsertRows();
+}
+
+//--------------------------------------------------------------------
+int DuplicatesModel::remove(const quint64 key)
+{
+  if(m_file.isOpen()) return 0;
+
+  // the rows of a group are removed in runs, the groups are counted by their originals.
+  QSet<QPair<QString, QString>> originals;
+  for(int row = m_rows.size() - 1; row >= 0; --row)
+  {
+    if(m_rows.at(row).key != key) continue;
+
+    auto first = row;
+    while(first > 0 && m_rows.at(first - 1).key == key) --first;
+
+    for(int i = first; i <= row; ++i)
+    {
+      originals.insert(qMakePair(m_rows.at(i).parent1, m_rows.at(i).name1));
+    }
+
+    beginRemoveRows(QModelIndex(), first, row);
+    m_rows.remove(first, row - first + 1);
+    endRemoveRows();
+
+    row = first;
+  }
+
+  return originals.size();
+}
+
+//--------------------------------------------------------------------
+void DuplicatesModel::clear()
+{
+  beginResetModel();
+  m_rows.clear();
+  m_file.close();
+  arrange();
+  endResetModel();
+}
+
+//--------------------------------------------------------------------
+bool DuplicatesModel::open(const QString& fileName)
+{
+  beginResetModel();
+  m_rows.clear();
+  m_rows.squeeze();
+  m_cachedRow = -1;
+  m_fileName  = fileName;
+  const auto result = m_file.open(fileName);
+  arrange();
+  endResetModel();
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+Duplicate DuplicatesModel::duplicate(const int row) const
+{
+  if(!m_file.isOpen()) return m_rows.at(row);
+
+  const auto fileRow = static_cast<int>(m_arranged ? m_shown.at(row) : row);
+  if(fileRow != m_cachedRow)
+  {
+    m_cached    = m_file.duplicate(fileRow);
+    m_cachedRow = fileRow;
+  }
+
+  return m_cached;
+}
@@ -0,0 +1,124 @@
+/*
+ File: DuplicatesModel.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DUPLICATESMODEL_H_
+#define DUPLICATESMODEL_H_
+
+// Project
+#include "ScanThread.h"
+#include "ResultFile.h"
+
+// Qt
+#include <QAbstractTableModel>
+
+/** \class DuplicatesModel
+ * \brief Table model of the found duplicates, one row per duplicated directory along the
+ *        original of its group. Rows are added in batches during a scan, or read on demand
+ *        from the memory map of a results file. The rows of a file are sorted and filtered by
+ *        the model with a permutation of the row numbers of the file, the rows added in
+ *        batches by a proxy model.
+ *
+ */
+class DuplicatesModel
+: public QAbstractTableModel
+{
+    Q_OBJECT
+  public:
+    /** \brief DuplicatesModel class constructor.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit DuplicatesModel(QObject *parent = nullptr);
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /** \brief Shows only the rows of the results file with the given text in any column,
+     *        ignoring case, or all of them if empty.
+     * \param[in] text Text to search for.
+     *
+     */
+    void setFilter(const QString &text);
+
+    /** \brief Adds the given duplicates at the end of the table.
+     * \param[in] batch Duplicates.
+     *
+     */
+    void append(const DuplicateBatch &batch);
+
+    /** \brief Removes the rows of the groups of the given matching key and returns the number
+     *        of groups removed.
+     * \param[in] key Matching key of the groups.
+     *
+     */
+    int remove(const quint64 key);
+
+    /** \brief Replaces the rows with the ones of the given results file and returns true on
+     *        success. On error the table is left empty.
+     * \param[in] fileName Results file name.
+     *
+     */
+    bool open(const QString &fileName);
+
+    /** \brief Returns the name of the results file of the rows, or an empty string if they
+     *        were added in batches.
+     *
+     */
+    QString fileName() const
+    { return m_file.isOpen() ? m_fileName : QString(); }
+
+    /** \brief Removes all the rows.
+     *
+     */
+    void clear();
+
+    /** \brief Returns the duplicate of the given row.
+     * \param[in] row Row number.
+     *
+     */
+    Duplicate duplicate(const int row) const;
+
+  private:
+    /** \brief Computes the shown rows of the results file from the sort column and the filter.
+     *
+     */
+    void arrange();
+
+    static const int COLUMNS = 8; /** number of columns. */
+
+    QVector<Duplicate> m_rows;     /** table rows added in batches.          */
+    ResultFile         m_file;     /** results file of the rows, if opened.  */
+    QString            m_fileName; /** results file name.                    */
+    int                m_column;   /** sort column of the file rows, -1 for the file order. */
+    Qt::SortOrder      m_order;    /** sort order of the file rows.          */
+    QString            m_filter;   /** filter text of the file rows.         */
+    bool               m_arranged; /** true if the file rows are shown in the order of m_shown. */
+    QVector<qint64>    m_shown;    /** row numbers of the file in the shown order. */
+    mutable int        m_cachedRow;/** row of the last duplicate read from the file, -1 if none. */
+    mutable Duplicate  m_cached;   /** last duplicate read from the file.   */
+};
+
+#endif // DUPLICATESMODEL_H_
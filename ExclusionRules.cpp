@@ -0,0 +1,280 @@
+/*
+ File: ExclusionRules.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ExclusionRules.h"
+#include "Hasher.h"
+
+// Qt
+#include <QFile>
+
+//--------------------------------------------------------------------
+ExclusionRules::Matcher::Matcher()
+: m_trie(1)
+{
+}
+
+//--------------------------------------------------------------------
+void ExclusionRules::Matcher::addName(const QString& name)
+{
+  m_names.insert(name.toLower());
+}
+
+//--------------------------------------------------------------------
+void ExclusionRules::Matcher::addPrefix(const QString& prefix)
+{
+  int node = 0;
+  for(const auto character: prefix.toLower())
+  {
+    auto next = m_trie.at(node).next.value(character, -1);
+    if(next < 0)
+    {
+      next = m_trie.size();
+      m_trie[node].next.insert(character, next);
+      m_trie << TrieNode();
+    }
+
+    node = next;
+  }
+
+  m_trie[node].terminal = true;
+}
+
+//--------------------------------------------------------------------
+void ExclusionRules::Matcher::addExpression(const QString& expression)
+{
+  m_expressions << QString("(?:%1)").arg(expression);
+}
+
+//--------------------------------------------------------------------
+bool ExclusionRules::Matcher::compile(QString& error)
+{
+  if(m_expressions.isEmpty()) return true;
+
+  m_expression = QRegularExpression(m_expressions.join('|'), QRegularExpression::CaseInsensitiveOption|QRegularExpression::UseUnicodePropertiesOption);
+  if(!m_expression.isValid())
+  {
+    error = m_expression.errorString();
+    return false;
+  }
+
+  m_expression.optimize();
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+bool ExclusionRules::Matcher::matches(const QString& name) const
+{
+  if(!m_names.isEmpty() || m_trie.size() > 1)
+  {
+    const auto lower = name.toLower();
+    if(m_names.contains(lower)) return true;
+
+    int node = 0;
+    for(const auto character: lower)
+    {
+      if(m_trie.at(node).terminal) return true;
+
+      node = m_trie.at(node).next.value(character, -1);
+      if(node < 0) break;
+    }
+
+    if(node >= 0 && m_trie.at(node).terminal) return true;
+  }
+
+  return !m_expressions.isEmpty() && m_expression.match(name).hasMatch();
+}
+
+//--------------------------------------------------------------------
+ExclusionRules::ExclusionRules()
+: m_minimumSize{0}
+, m_maxDepth   {0}
+, m_sameDevice {false}
+, m_noSymlinks {false}
+, m_fingerprint{0}
+{
+}
+
+//--------------------------------------------------------------------
+bool ExclusionRules::parse(const QString& text, QString& error)
+{
+  ExclusionRules rules;
+  rules.m_text = text;
+
+  // only the rules that change the listings are part of the fingerprint.
+  QStringList pruning;
+
+  const auto lines = text.split('\n');
+  for(int i = 0; i < lines.size(); ++i)
+  {
+    const auto line = lines.at(i).trimmed();
+    if(line.isEmpty() || line.startsWith('#')) continue;
+
+    const auto separator = line.indexOf(' ');
+    const auto keyword   = line.left(separator).toLower();
+    const auto argument  = separator < 0 ? QString() : line.mid(separator + 1).trimmed();
+
+    bool ok = true;
+    if(keyword == "skip" || keyword == "ignore")
+    {
+      ok = !argument.isEmpty() && addPattern(argument, keyword == "skip" ? rules.m_skip : rules.m_ignore);
+      if(keyword == "skip") pruning << line;
+    }
+    else if(keyword == "min-size")
+    {
+      rules.m_minimumSize = argument.toLongLong(&ok);
+      ok &= rules.m_minimumSize >= 0;
+    }
+    else if(keyword == "max-depth")
+    {
+      rules.m_maxDepth = argument.toInt(&ok);
+      ok &= rules.m_maxDepth > 0;
+      pruning << line;
+    }
+    else if(keyword == "same-device")
+    {
+      ok = argument.isEmpty();
+      rules.m_sameDevice = true;
+      pruning << line;
+    }
+    else if(keyword == "no-symlinks")
+    {
+      ok = argument.isEmpty();
+      rules.m_noSymlinks = true;
+      pruning << line;
+    }
+    else
+    {
+      ok = false;
+    }
+
+    if(!ok)
+    {
+      error = QString("Invalid rule in line %1: %2").arg(i + 1).arg(line);
+      return false;
+    }
+  }
+
+  QString expressionError;
+  if(!rules.m_skip.compile(expressionError) || !rules.m_ignore.compile(expressionError))
+  {
+    error = QString("Invalid expression: %1").arg(expressionError);
+    return false;
+  }
+
+  if(!pruning.isEmpty())
+  {
+    const auto data = pruning.join('\n').toUtf8();
+    rules.m_fingerprint = Hasher::hash(data.constData(), data.size());
+  }
+
+  *this = rules;
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+QString ExclusionRules::defaults()
+{
+  return QString("# compilations, listed but not reported.\n"
+                 "ignore Variado\n"
+                 "ignore Various\n"
+                 "ignore prefix:\"CD \"\n"
+                 "# empty folders.\n"
+                 "min-size 1\n");
+}
+
+//--------------------------------------------------------------------
+ExclusionRules ExclusionRules::defaultRules()
+{
+  ExclusionRules rules;
+  QString error;
+  rules.parse(defaults(), error);
+
+  return rules;
+}
+
+//--------------------------------------------------------------------
+bool ExclusionRules::addPattern(const QString& pattern, Matcher& matcher)
+{
+  const auto colon = pattern.indexOf(':');
+  auto kind  = colon < 0 ? QString() : pattern.left(colon).toLower();
+  auto value = colon < 0 ? pattern : pattern.mid(colon + 1);
+
+  if(kind != "prefix" && kind != "glob" && kind != "regex")
+  {
+    kind.clear();
+    value = pattern;
+  }
+
+  if(value.size() > 1 && value.startsWith('"') && value.endsWith('"'))
+  {
+    value = value.mid(1, value.size() - 2);
+  }
+
+  if(value.isEmpty()) return false;
+
+  if(kind == "prefix")     matcher.addPrefix(value);
+  else if(kind == "glob")  matcher.addExpression(globExpression(value));
+  else if(kind == "regex") matcher.addExpression(value);
+  else                     matcher.addName(value);
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+QString ExclusionRules::globExpression(const QString& glob)
+{
+  QString expression("^");
+  for(int i = 0; i < glob.size(); ++i)
+  {
+    const auto character = glob.at(i);
+    if(character == '*')
+    {
+      expression += ".*";
+    }
+    else if(character == '?')
+    {
+      expression += '.';
+    }
+    else if(character == '[')
+    {
+      const auto end = glob.indexOf(']', i + 2);
+      if(end < 0)
+      {
+        expression += "\\[";
+        continue;
+      }
+
+      auto characters = glob.mid(i + 1, end - i - 1);
+      if(characters.startsWith('!')) characters[0] = '^';
+      characters.replace("\\", "\\\\");
+
+      expression += '[' + characters + ']';
+      i = end;
+    }
+    else
+    {
+      expression += QRegularExpression::escape(QString(character));
+    }
+  }
+
+  return expression + '$';
+}
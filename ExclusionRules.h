@@ -0,0 +1,224 @@
+/*
+ File: ExclusionRules.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXCLUSIONRULES_H_
+#define EXCLUSIONRULES_H_
+
+// Qt
+#include <QString>
+#include <QStringList>
+#include <QChar>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QRegularExpression>
+
+/** \class ExclusionRules
+ * \brief Rules that exclude directories from the scan, compiled from a text with one rule per line:
+ *        - skip <pattern>   the directory is never listed, as if it didn't exist.
+ *        - ignore <pattern> the directory is listed and counted in its parent, but not reported.
+ *        - min-size <bytes> directories smaller than this are not reported.
+ *        - max-depth <n>    directories deeper than n levels below the scanned folder are never listed.
+ *        - same-device      directories in other file systems than the scanned folder are left empty,
+ *                           only detected with the native listing.
+ *        - no-symlinks      symbolic links to files and directories are left out of the listings.
+ *        A pattern is a directory name, prefix:<text>, glob:<wildcards> or regex:<expression>, compared
+ *        ignoring case. The text can be quoted to keep leading or trailing spaces. Names are matched with
+ *        a hash of the exact names, a trie of the prefixes and a single expression of all the globs and
+ *        regular expressions, so the cost doesn't grow with the number of rules. Empty lines and lines
+ *        starting with '#' are ignored.
+ *
+ */
+class ExclusionRules
+{
+  public:
+    /** \brief ExclusionRules class constructor. Doesn't exclude anything.
+     *
+     */
+    ExclusionRules();
+
+    /** \brief Replaces the rules with the ones of the given text and returns true on success. On
+     *        error the rules are left unchanged.
+     * \param[in] text Rules, one per line.
+     * \param[out] error Description of the first invalid line.
+     *
+     */
+    bool parse(const QString &text, QString &error);
+
+    /** \brief Returns the text of the rules.
+     *
+     */
+    QString text() const
+    { return m_text; }
+
+    /** \brief Returns true if the directory with the given name must never be listed.
+     * \param[in] name Directory name.
+     *
+     */
+    bool skips(const QString &name) const
+    { return m_skip.matches(name); }
+
+    /** \brief Returns true if the directory with the given name and size must not be reported.
+     * \param[in] name Directory name.
+     * \param[in] bytes Directory size in bytes.
+     *
+     */
+    bool ignores(const QString &name, const double bytes) const
+    { return bytes < m_minimumSize || m_ignore.matches(name); }
+
+    /** \brief Returns true if some rule removes directories from the listings.
+     *
+     */
+    bool prunes() const
+    { return !m_skip.isEmpty() || m_maxDepth > 0 || m_sameDevice; }
+
+    /** \brief Returns true if there are skip rules.
+     *
+     */
+    bool hasSkips() const
+    { return !m_skip.isEmpty(); }
+
+    /** \brief Returns the maximum depth of the listed directories, 0 if unlimited. The directories of
+     *        the scanned folder are at depth 1.
+     *
+     */
+    int maxDepth() const
+    { return m_maxDepth; }
+
+    /** \brief Returns true if the scan doesn't cross to other file systems.
+     *
+     */
+    bool sameDevice() const
+    { return m_sameDevice; }
+
+    /** \brief Returns true if the listings follow symbolic links.
+     *
+     */
+    bool followsLinks() const
+    { return !m_noSymlinks; }
+
+    /** \brief Returns a value that only changes when the rules that remove directories from the
+     *        listings change, 0 if there are none.
+     *
+     */
+    quint64 fingerprint() const
+    { return m_fingerprint; }
+
+    /** \brief Returns the default rules text: the compilation folders aren't reported, nor the empty ones.
+     *
+     */
+    static QString defaults();
+
+    /** \brief Returns the default rules.
+     *
+     */
+    static ExclusionRules defaultRules();
+
+  private:
+    /** \class Matcher
+     * \brief Compiled name patterns of an action.
+     *
+     */
+    class Matcher
+    {
+      public:
+        /** \brief Matcher class constructor.
+         *
+         */
+        Matcher();
+
+        /** \brief Adds an exact name.
+         * \param[in] name Directory name.
+         *
+         */
+        void addName(const QString &name);
+
+        /** \brief Adds a name prefix.
+         * \param[in] prefix Directory name prefix.
+         *
+         */
+        void addPrefix(const QString &prefix);
+
+        /** \brief Adds a regular expression, matched anywhere in the names unless anchored.
+         * \param[in] expression Regular expression.
+         *
+         */
+        void addExpression(const QString &expression);
+
+        /** \brief Compiles the added expressions and returns true on success.
+         * \param[out] error Expression error description.
+         *
+         */
+        bool compile(QString &error);
+
+        /** \brief Returns true if the given name matches a pattern.
+         * \param[in] name Directory name.
+         *
+         */
+        bool matches(const QString &name) const;
+
+        /** \brief Returns true if there are no patterns.
+         *
+         */
+        bool isEmpty() const
+        { return m_names.isEmpty() && m_trie.size() == 1 && m_expressions.isEmpty(); }
+
+      private:
+        /** \struct TrieNode
+         * \brief Node of the prefixes trie, over lowercase characters.
+         *
+         */
+        struct TrieNode
+        {
+          QHash<QChar, int> next;     /** index of the node of each following character. */
+          bool              terminal; /** true if a prefix ends here.                    */
+
+          TrieNode(): terminal{false} {};
+        };
+
+        QSet<QString>       m_names;       /** lowercase exact names.                 */
+        QVector<TrieNode>   m_trie;        /** prefixes trie, the first node the root. */
+        QStringList         m_expressions; /** expressions, until compiled.           */
+        QRegularExpression  m_expression;  /** alternation of all the expressions.    */
+    };
+
+    /** \brief Adds the given pattern to the given matcher and returns true on success.
+     * \param[in] pattern Pattern text.
+     * \param[in] matcher Matcher of the rule action.
+     *
+     */
+    static bool addPattern(const QString &pattern, Matcher &matcher);
+
+    /** \brief Returns the regular expression of the given wildcards pattern.
+     * \param[in] glob Wildcards pattern with '*', '?' and character classes.
+     *
+     */
+    static QString globExpression(const QString &glob);
+
+    QString m_text;        /** rules text.                                   */
+    Matcher m_skip;        /** names of the directories never listed.        */
+    Matcher m_ignore;      /** names of the directories not reported.        */
+    double  m_minimumSize; /** minimum size in bytes of reported directories. */
+    int     m_maxDepth;    /** maximum listed depth, 0 if unlimited.         */
+    bool    m_sameDevice;  /** true to stay in the file system of the root.  */
+    bool    m_noSymlinks;  /** true to leave symbolic links out.             */
+    quint64 m_fingerprint; /** fingerprint of the pruning rules.            */
+};
+
+#endif // EXCLUSIONRULES_H_
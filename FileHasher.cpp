@@ -0,0 +1,298 @@
+/*
+ File: FileHasher.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "FileHasher.h"
+#include "Hasher.h"
+#include "Throttle.h"
+
+// Qt
+#include <QFile>
+#include <QThread>
+
+// C++
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+// Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+const qint64 FileHasher::PARTIAL_SIZE;
+const qint64 FileHasher::BLOCK_SIZE;
+
+namespace
+{
+  const int     BUFFERS{3};              /** number of read buffers of the streamed hash. */
+  const int     ALIGNMENT{4096};         /** alignment of the read buffers.               */
+  const quint64 UNREADABLE_SEED{~0ULL};  /** seed of the hash of unreadable files.        */
+}
+
+//--------------------------------------------------------------------
+FileHasher::FileHasher(const int threads, const bool useMap)
+: m_threads{threads > 0 ? threads : std::max(1, QThread::idealThreadCount())}
+, m_useMap {useMap}
+, m_bytes  {0}
+, m_throttle{nullptr}
+{
+}
+
+//--------------------------------------------------------------------
+quint64 FileHasher::partialHash(const QString& path)
+{
+  QFile file{path};
+  if(!file.open(QIODevice::ReadOnly)) return unreadable(path);
+
+  const auto size = file.size();
+  Hasher hasher{static_cast<quint64>(size)};
+
+  if(partialIsFull(size))
+  {
+    const auto data = file.readAll();
+    if(data.size() != size) return unreadable(path);
+
+    hasher.update(data.constData(), data.size());
+  }
+  else
+  {
+    const auto head = file.read(PARTIAL_SIZE);
+    if(head.size() != PARTIAL_SIZE || !file.seek(size - PARTIAL_SIZE)) return unreadable(path);
+
+    const auto tail = file.read(PARTIAL_SIZE);
+    if(tail.size() != PARTIAL_SIZE) return unreadable(path);
+
+    hasher.update(head.constData(), head.size());
+    hasher.update(tail.constData(), tail.size());
+  }
+
+  m_bytes += std::min(size, 2*PARTIAL_SIZE);
+  if(m_throttle) m_throttle->read(std::min(size, 2*PARTIAL_SIZE));
+
+  return hasher.digest();
+}
+
+//--------------------------------------------------------------------
+quint64 FileHasher::fullHash(const QString& path)
+{
+  QFile file{path};
+  if(!file.open(QIODevice::ReadOnly)) return unreadable(path);
+
+  quint64 hash = 0;
+  if(m_useMap && mapped(file, hash)) return hash;
+
+  if(!file.seek(0) || !streamed(file, hash)) return unreadable(path);
+
+  return hash;
+}
+
+//--------------------------------------------------------------------
+QVector<quint64> FileHasher::partialHashes(const QStringList& paths)
+{
+  return parallel(paths, &FileHasher::partialHash);
+}
+
+//--------------------------------------------------------------------
+QVector<quint64> FileHasher::fullHashes(const QStringList& paths)
+{
+  return parallel(paths, &FileHasher::fullHash);
+}
+
+//--------------------------------------------------------------------
+bool FileHasher::streamed(QFile& file, quint64 &hash)
+{
+  Hasher hasher;
+
+  // small files are read at once, a reader thread isn't worth it.
+  if(file.size() <= BLOCK_SIZE)
+  {
+    const auto data = file.readAll();
+    if(data.size() != file.size()) return false;
+
+    hasher.update(data.constData(), data.size());
+    m_bytes += data.size();
+    if(m_throttle) m_throttle->read(data.size());
+
+    hash = hasher.digest();
+    return true;
+  }
+
+  struct Buffer
+  {
+    char   *data;
+    qint64  size;
+  };
+
+  std::vector<Buffer> buffers(BUFFERS);
+  std::deque<int> empty, filled;
+  for(int i = 0; i < BUFFERS; ++i)
+  {
+    buffers[i].data = static_cast<char *>(qMallocAligned(BLOCK_SIZE, ALIGNMENT));
+    buffers[i].size = 0;
+    empty.push_back(i);
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool failed = false;
+
+#ifdef Q_OS_LINUX
+  posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  // the reader fills the empty buffers and queues them, a buffer of size 0 marks the end.
+  std::thread reader([&]()
+  {
+    int generation = -1;
+    if(m_throttle) m_throttle->prioritize(generation);
+
+    while(true)
+    {
+      int index = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&empty](){ return !empty.empty(); });
+        index = empty.front();
+        empty.pop_front();
+      }
+
+      const auto read = file.read(buffers[index].data, BLOCK_SIZE);
+      if(m_throttle) m_throttle->read(read);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(read < 0) failed = true;
+
+        buffers[index].size = std::max(read, static_cast<qint64>(0));
+        filled.push_back(index);
+      }
+      condition.notify_all();
+
+      if(read <= 0) break;
+    }
+  });
+
+  while(true)
+  {
+    int index = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [&filled](){ return !filled.empty(); });
+      index = filled.front();
+      filled.pop_front();
+    }
+
+    const auto size = buffers[index].size;
+    if(size == 0) break;
+
+    hasher.update(buffers[index].data, size);
+    m_bytes += size;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      empty.push_back(index);
+    }
+    condition.notify_all();
+  }
+
+  reader.join();
+
+  for(auto &buffer: buffers)
+  {
+    qFreeAligned(buffer.data);
+  }
+
+  hash = hasher.digest();
+
+  return !failed;
+}
+
+//--------------------------------------------------------------------
+bool FileHasher::mapped(QFile& file, quint64 &hash)
+{
+  const auto size = file.size();
+  if(size == 0) return false;
+
+  auto data = file.map(0, size);
+  if(!data) return false;
+
+#ifdef Q_OS_LINUX
+  madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+  Hasher hasher;
+  for(qint64 position = 0; position < size; position += BLOCK_SIZE)
+  {
+    const auto length = std::min(BLOCK_SIZE, size - position);
+    hasher.update(data + position, length);
+    m_bytes += length;
+    if(m_throttle) m_throttle->read(length);
+  }
+
+  file.unmap(data);
+
+  hash = hasher.digest();
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+quint64 FileHasher::unreadable(const QString& path)
+{
+  const auto data = path.toUtf8();
+
+  return Hasher::hash(data.constData(), data.size(), UNREADABLE_SEED);
+}
+
+//--------------------------------------------------------------------
+QVector<quint64> FileHasher::parallel(const QStringList& paths, quint64 (FileHasher::*method)(const QString &))
+{
+  QVector<quint64> hashes(paths.size());
+  auto results = hashes.data();
+  std::atomic<int> next{0};
+
+  auto work = [&]()
+  {
+    int generation = -1;
+    int index;
+    while((index = next++) < paths.size())
+    {
+      if(m_throttle) m_throttle->prioritize(generation);
+
+      results[index] = (this->*method)(paths.at(index));
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const auto count = std::min(m_threads, paths.size());
+  for(int i = 1; i < count; ++i)
+  {
+    threads.emplace_back(work);
+  }
+
+  work();
+
+  for(auto &thread: threads) thread.join();
+
+  return hashes;
+}
@@ -0,0 +1,138 @@
+/*
+ File: FileHasher.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILEHASHER_H_
+#define FILEHASHER_H_
+
+// Qt
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// C++
+#include <atomic>
+
+class QFile;
+class Throttle;
+
+/** \class FileHasher
+ * \brief Hashes file contents in stages. The partial hash covers only the first and last
+ *        blocks of a file and is enough to tell most different files apart, the full hash
+ *        reads the whole file. Full hashes are computed by a reader thread that fills large
+ *        aligned buffers and a hasher thread that consumes them, so disk and CPU work overlap,
+ *        or by hashing a memory map of the file. Lists of files are hashed in parallel.
+ *
+ */
+class FileHasher
+{
+  public:
+    static const qint64 PARTIAL_SIZE = 4*1024;      /** size of the head and tail blocks of the partial hash. */
+    static const qint64 BLOCK_SIZE   = 4*1024*1024; /** size of the full hash read buffers.                   */
+
+    /** \brief FileHasher class constructor.
+     * \param[in] threads Number of files hashed at the same time, 0 to use the number of cores.
+     * \param[in] useMap True to hash memory maps of the files instead of reading them.
+     *
+     */
+    explicit FileHasher(const int threads = 0, const bool useMap = false);
+
+    /** \brief Returns the hash of the first and last PARTIAL_SIZE bytes of the given file, or
+     *        of all of it if it's smaller than two blocks. Files that can't be read get a hash
+     *        of their path, so they don't match any other.
+     * \param[in] path File path.
+     *
+     */
+    quint64 partialHash(const QString &path);
+
+    /** \brief Returns the hash of the contents of the given file. Files that can't be read get
+     *        a hash of their path, so they don't match any other.
+     * \param[in] path File path.
+     *
+     */
+    quint64 fullHash(const QString &path);
+
+    /** \brief Returns the partial hashes of the given files, computed in parallel.
+     * \param[in] paths File paths.
+     *
+     */
+    QVector<quint64> partialHashes(const QStringList &paths);
+
+    /** \brief Returns the full hashes of the given files, computed in parallel.
+     * \param[in] paths File paths.
+     *
+     */
+    QVector<quint64> fullHashes(const QStringList &paths);
+
+    /** \brief Limits the reads with the given throttle, that must outlive the hasher, or
+     *        removes the limit with nullptr.
+     * \param[in] throttle Background mode limits.
+     *
+     */
+    void setThrottle(Throttle *throttle)
+    { m_throttle = throttle; }
+
+    /** \brief Returns the number of bytes hashed so far.
+     *
+     */
+    qint64 bytesHashed() const
+    { return m_bytes.load(); }
+
+    /** \brief Returns true if the given file doesn't need a full hash because the partial
+     *        one already covers all of it.
+     * \param[in] size File size in bytes.
+     *
+     */
+    static bool partialIsFull(const qint64 size)
+    { return size <= 2*PARTIAL_SIZE; }
+
+  private:
+    /** \brief Hashes the contents of the given open file reading it in a separate thread.
+     * \param[in] file Open file.
+     * \param[out] hash File hash.
+     *
+     */
+    bool streamed(QFile &file, quint64 &hash);
+
+    /** \brief Hashes the contents of the given open file through a memory map.
+     * \param[in] file Open file.
+     * \param[out] hash File hash.
+     *
+     */
+    bool mapped(QFile &file, quint64 &hash);
+
+    /** \brief Returns the hash given to files that can't be read.
+     * \param[in] path File path.
+     *
+     */
+    static quint64 unreadable(const QString &path);
+
+    /** \brief Calls the given method for every path using the hasher threads.
+     * \param[in] paths File paths.
+     * \param[in] method Hashing method.
+     *
+     */
+    QVector<quint64> parallel(const QStringList &paths, quint64 (FileHasher::*method)(const QString &));
+
+    const int            m_threads; /** number of files hashed at the same time. */
+    const bool           m_useMap;  /** true to hash memory maps.                */
+    std::atomic<qint64>  m_bytes;   /** number of bytes hashed.                  */
+    Throttle            *m_throttle;/** limits of the reads, if any.             */
+};
+
+#endif // FILEHASHER_H_
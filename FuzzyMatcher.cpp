@@ -0,0 +1,371 @@
+/*
+ File: FuzzyMatcher.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "FuzzyMatcher.h"
+
+// Qt
+#include <QChar>
+#include <QHash>
+#include <QRegularExpression>
+
+// C++
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  /** \brief Returns the Jaccard similarity of the given sorted sets.
+   * \param[in] lhs Sorted set.
+   * \param[in] rhs Sorted set.
+   *
+   */
+  double jaccardSimilarity(const QVector<int> &lhs, const QVector<int> &rhs)
+  {
+    int common = 0;
+    for(int i = 0, j = 0; i < lhs.size() && j < rhs.size();)
+    {
+      if(lhs.at(i) < rhs.at(j))      ++i;
+      else if(rhs.at(j) < lhs.at(i)) ++j;
+      else
+      {
+        ++common;
+        ++i;
+        ++j;
+      }
+    }
+
+    return static_cast<double>(common) / (lhs.size() + rhs.size() - common);
+  }
+
+  /** \struct TreeNode
+   * \brief Node of a BK-tree of names.
+   *
+   */
+  struct TreeNode
+  {
+    int             name;     /** name index.                                 */
+    QHash<int, int> children; /** child nodes by their distance to this name. */
+  };
+}
+
+//--------------------------------------------------------------------
+FuzzyMatcher::FuzzyMatcher(const FuzzyOptions& options)
+: m_options(options)
+{
+}
+
+//--------------------------------------------------------------------
+QString FuzzyMatcher::normalize(const QString& name) const
+{
+  QString result;
+  result.reserve(name.size());
+
+  if(m_options.normalization & FuzzyOptions::BRACKETS)
+  {
+    int depth = 0;
+    for(const auto character: name)
+    {
+      if(character == '(' || character == '[' || character == '{')
+      {
+        ++depth;
+      }
+      else if(character == ')' || character == ']' || character == '}')
+      {
+        depth = std::max(0, depth - 1);
+      }
+      else if(depth == 0)
+      {
+        result += character;
+      }
+    }
+  }
+  else
+  {
+    result = name;
+  }
+
+  if(m_options.normalization & FuzzyOptions::YEARS)
+  {
+    static const QRegularExpression years("(?<![\\p{L}\\p{N}])(?:19|20)\\d\\d(?![\\p{L}\\p{N}])");
+    result.remove(years);
+  }
+
+  if(m_options.normalization & FuzzyOptions::ACCENTS)
+  {
+    const auto decomposed = result.normalized(QString::NormalizationForm_KD);
+
+    result.clear();
+    for(const auto character: decomposed)
+    {
+      if(character.category() != QChar::Mark_NonSpacing) result += character;
+    }
+  }
+
+  if(m_options.normalization & FuzzyOptions::CASE)
+  {
+    result = result.toCaseFolded();
+  }
+
+  if(m_options.normalization & FuzzyOptions::PUNCTUATION)
+  {
+    for(auto &character: result)
+    {
+      if(!character.isLetterOrNumber()) character = ' ';
+    }
+  }
+
+  result = result.simplified();
+
+  // a name made only of removed parts keeps its own identity.
+  return result.isEmpty() ? name.toLower() : result;
+}
+
+//--------------------------------------------------------------------
+QVector<int> FuzzyMatcher::cluster(const QStringList& names) const
+{
+  const auto byJaccard = m_options.metric == FuzzyOptions::Metric::JACCARD;
+  const auto threshold = std::min(1., std::max(0.01, m_options.similarity));
+  const auto limit     = std::max(0, m_options.distance);
+
+  QVector<QVector<int>> grams;
+  auto pairs = byJaccard ? jaccard(names, grams) : editDistance(names);
+
+  // closest pairs first, the order of the names only breaks the ties.
+  std::sort(pairs.begin(), pairs.end(), [](const Pair &lhs, const Pair &rhs)
+  { return lhs.closeness > rhs.closeness || (lhs.closeness == rhs.closeness && (lhs.lhs < rhs.lhs || (lhs.lhs == rhs.lhs && lhs.rhs < rhs.rhs))); });
+
+  auto similar = [&](const int lhs, const int rhs)
+  {
+    if(byJaccard) return jaccardSimilarity(grams.at(lhs), grams.at(rhs)) >= threshold;
+    return editDistance(names.at(lhs), names.at(rhs), limit) <= limit;
+  };
+
+  // each cluster is identified by its lowest name, its representative.
+  QVector<int> clusters(names.size());
+  QVector<QVector<int>> members(names.size());
+  for(int i = 0; i < names.size(); ++i)
+  {
+    clusters[i] = i;
+    members[i] << i;
+  }
+
+  for(const auto &pair: pairs)
+  {
+    const auto representative = std::min(clusters.at(pair.lhs), clusters.at(pair.rhs));
+    const auto other          = std::max(clusters.at(pair.lhs), clusters.at(pair.rhs));
+    if(representative == other) continue;
+
+    // every member must be similar to the representative, a chain of similar names isn't a cluster.
+    const auto &joined = members.at(other);
+    if(!std::all_of(joined.constBegin(), joined.constEnd(), [&](const int member) { return similar(representative, member); })) continue;
+
+    for(const auto member: joined) clusters[member] = representative;
+    members[representative] += joined;
+    members[other].clear();
+  }
+
+  return clusters;
+}
+
+//--------------------------------------------------------------------
+QVector<FuzzyMatcher::Pair> FuzzyMatcher::jaccard(const QStringList& names, QVector<QVector<int>>& grams) const
+{
+  const auto threshold = std::min(1., std::max(0.01, m_options.similarity));
+
+  // trigrams of the names with a space at each side, so the first and last letters weigh the same.
+  QHash<QString, int> ids;
+  QVector<int> frequencies;
+  grams = QVector<QVector<int>>(names.size());
+  for(int i = 0; i < names.size(); ++i)
+  {
+    const auto padded = QString(' ') + names.at(i) + ' ';
+
+    auto &set = grams[i];
+    for(int j = 0; j + 3 <= padded.size(); ++j)
+    {
+      const auto gram = padded.mid(j, 3);
+      auto id = ids.value(gram, -1);
+      if(id < 0)
+      {
+        id = ids.size();
+        ids.insert(gram, id);
+        frequencies << 0;
+      }
+
+      set << id;
+    }
+
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+
+    for(const auto id: set) ++frequencies[id];
+  }
+
+  // rarest trigrams first, so the prefixes hit short lists in the inverted index.
+  auto rarer = [&frequencies](const int lhs, const int rhs)
+  { return frequencies.at(lhs) < frequencies.at(rhs) || (frequencies.at(lhs) == frequencies.at(rhs) && lhs < rhs); };
+
+  for(auto &set: grams) std::sort(set.begin(), set.end(), rarer);
+
+  QVector<int> order(names.size());
+  for(int i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&grams](const int lhs, const int rhs) { return grams.at(lhs).size() < grams.at(rhs).size(); });
+
+  // two sets over the threshold share at least one trigram of their prefixes, so only those are indexed.
+  auto prefix = [threshold](const int size)
+  { return size - static_cast<int>(std::ceil(threshold * size - 1e-9)) + 1; };
+
+  QVector<QVector<int>> index(ids.size());
+  QVector<bool> seen(names.size(), false);
+  QVector<int> candidates;
+  QVector<Pair> pairs;
+
+  for(const auto x: order)
+  {
+    const auto &xGrams = grams.at(x);
+    const auto xPrefix = prefix(xGrams.size());
+
+    for(int p = 0; p < xPrefix; ++p)
+    {
+      for(const auto y: index.at(xGrams.at(p)))
+      {
+        // names come by size, the smaller ones can't reach the threshold.
+        if(seen.at(y) || grams.at(y).size() < threshold * xGrams.size()) continue;
+
+        seen[y] = true;
+        candidates << y;
+      }
+    }
+
+    for(const auto y: candidates)
+    {
+      seen[y] = false;
+
+      const auto &yGrams = grams.at(y);
+      int common = 0;
+      for(int i = 0, j = 0; i < xGrams.size() && j < yGrams.size();)
+      {
+        if(rarer(xGrams.at(i), yGrams.at(j)))      ++i;
+        else if(rarer(yGrams.at(j), xGrams.at(i))) ++j;
+        else
+        {
+          ++common;
+          ++i;
+          ++j;
+        }
+      }
+
+      const auto similarity = static_cast<double>(common) / (xGrams.size() + yGrams.size() - common);
+      if(similarity >= threshold) pairs << Pair{std::min(x, y), std::max(x, y), similarity};
+    }
+
+    candidates.clear();
+
+    for(int p = 0; p < xPrefix; ++p)
+    {
+      index[xGrams.at(p)] << x;
+    }
+  }
+
+  for(auto &set: grams) std::sort(set.begin(), set.end());
+
+  return pairs;
+}
+
+//--------------------------------------------------------------------
+QVector<FuzzyMatcher::Pair> FuzzyMatcher::editDistance(const QStringList& names) const
+{
+  const auto limit = std::max(0, m_options.distance);
+
+  QVector<Pair> pairs;
+
+  QVector<TreeNode> tree;
+  tree.reserve(names.size());
+
+  for(int i = 0; i < names.size(); ++i)
+  {
+    const auto &name = names.at(i);
+
+    // the names already in the tree within the distance are paired, then the name is inserted.
+    QVector<int> stack;
+    if(!tree.isEmpty()) stack << 0;
+
+    while(!stack.isEmpty())
+    {
+      const auto &node = tree.at(stack.takeLast());
+      const auto &other = names.at(node.name);
+      const auto distance = editDistance(name, other, std::max(name.size(), other.size()));
+
+      if(distance <= limit) pairs << Pair{node.name, i, static_cast<double>(-distance)};
+
+      for(auto it = node.children.constBegin(); it != node.children.constEnd(); ++it)
+      {
+        if(std::abs(it.key() - distance) <= limit) stack << it.value();
+      }
+    }
+
+    TreeNode leaf;
+    leaf.name = i;
+    tree << leaf;
+
+    for(int node = 0; node != tree.size() - 1;)
+    {
+      const auto distance = editDistance(name, names.at(tree.at(node).name), std::max(name.size(), names.at(tree.at(node).name).size()));
+      const auto child = tree.at(node).children.value(distance, -1);
+      if(child < 0)
+      {
+        tree[node].children.insert(distance, tree.size() - 1);
+        break;
+      }
+
+      node = child;
+    }
+  }
+
+  return pairs;
+}
+
+//--------------------------------------------------------------------
+int FuzzyMatcher::editDistance(const QString& lhs, const QString& rhs, const int limit)
+{
+  if(std::abs(lhs.size() - rhs.size()) > limit) return limit + 1;
+
+  QVector<int> previous(rhs.size() + 1), current(rhs.size() + 1);
+  for(int j = 0; j <= rhs.size(); ++j) previous[j] = j;
+
+  for(int i = 1; i <= lhs.size(); ++i)
+  {
+    current[0] = i;
+    auto minimum = current[0];
+
+    for(int j = 1; j <= rhs.size(); ++j)
+    {
+      const auto substitution = previous.at(j - 1) + (lhs.at(i - 1) == rhs.at(j - 1) ? 0 : 1);
+      current[j] = std::min(substitution, std::min(previous.at(j), current.at(j - 1)) + 1);
+      minimum = std::min(minimum, current.at(j));
+    }
+
+    if(minimum > limit) return limit + 1;
+
+    previous.swap(current);
+  }
+
+  return std::min(previous.at(rhs.size()), limit + 1);
+}
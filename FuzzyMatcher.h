@@ -0,0 +1,134 @@
+/*
+ File: FuzzyMatcher.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FUZZYMATCHER_H_
+#define FUZZYMATCHER_H_
+
+// Qt
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/** \struct FuzzyOptions
+ * \brief Configuration of the similar names matching.
+ *
+ */
+struct FuzzyOptions
+{
+  /** \brief Name normalization steps, applied in this order. The whitespace is always collapsed.
+   *
+   */
+  enum Normalization
+  {
+    BRACKETS    = 0x01, /** removes the text in parentheses, brackets or braces, like years or tags. */
+    YEARS       = 0x02, /** removes the numbers between 1900 and 2099 that aren't part of a word.    */
+    ACCENTS     = 0x04, /** removes the diacritical marks and compatibility forms of the letters.    */
+    CASE        = 0x08, /** folds the case of the letters.                                            */
+    PUNCTUATION = 0x10, /** replaces punctuation and symbols by spaces.                               */
+    ALL         = 0x1F
+  };
+
+  /** \brief Similarity metrics of the normalized names.
+   *
+   */
+  enum class Metric: char
+  {
+    JACCARD       = 0, /** Jaccard similarity of the sets of character trigrams. */
+    EDIT_DISTANCE = 1  /** Levenshtein distance.                                 */
+  };
+
+  int    normalization; /** combination of Normalization flags.                     */
+  Metric metric;        /** similarity metric.                                      */
+  double similarity;    /** minimum Jaccard similarity, in (0, 1].                  */
+  int    distance;      /** maximum edit distance.                                  */
+
+  FuzzyOptions(): normalization{ALL}, metric{Metric::JACCARD}, similarity{0.6}, distance{2} {};
+};
+
+/** \class FuzzyMatcher
+ * \brief Normalizes directory names and clusters the names that are similar. Names are never
+ *        compared all against all: with the Jaccard metric the candidates come from an inverted
+ *        index of trigrams where each name only indexes and looks up its rarest trigrams (prefix
+ *        filtering), which is enough to find every pair over the threshold, and with the edit
+ *        distance from a BK-tree, which prunes the subtrees outside the distance by the triangle
+ *        inequality. The similar pairs are then joined from the closest one, and a name only joins a
+ *        cluster when it's also similar to its representative, so clusters don't chain.
+ *
+ */
+class FuzzyMatcher
+{
+  public:
+    /** \brief FuzzyMatcher class constructor.
+     * \param[in] options Matching configuration.
+     *
+     */
+    explicit FuzzyMatcher(const FuzzyOptions &options = FuzzyOptions());
+
+    /** \brief Returns the normalized form of the given name. Names that have the same normalized
+     *        form are always in the same cluster.
+     * \param[in] name Directory name.
+     *
+     */
+    QString normalize(const QString &name) const;
+
+    /** \brief Returns the cluster of each of the given distinct normalized names, as the index of its
+     *        representative, the first name of the cluster. Every name is similar to its representative.
+     * \param[in] names Distinct normalized names.
+     *
+     */
+    QVector<int> cluster(const QStringList &names) const;
+
+    /** \brief Returns the Levenshtein distance of the given strings, or limit + 1 if it's greater
+     *        than the limit.
+     * \param[in] lhs String.
+     * \param[in] rhs String.
+     * \param[in] limit Maximum distance of interest.
+     *
+     */
+    static int editDistance(const QString &lhs, const QString &rhs, const int limit);
+
+  private:
+    /** \struct Pair
+     * \brief Two similar names.
+     *
+     */
+    struct Pair
+    {
+      int    lhs;       /** name index.                     */
+      int    rhs;       /** name index.                     */
+      double closeness; /** similarity, greater is closer. */
+    };
+
+    /** \brief Returns the pairs of names within the Jaccard similarity threshold.
+     * \param[in] names Distinct normalized names.
+     * \param[out] grams Trigram identifiers of each name, sorted.
+     *
+     */
+    QVector<Pair> jaccard(const QStringList &names, QVector<QVector<int>> &grams) const;
+
+    /** \brief Returns the pairs of names within the edit distance threshold.
+     * \param[in] names Distinct normalized names.
+     *
+     */
+    QVector<Pair> editDistance(const QStringList &names) const;
+
+    const FuzzyOptions m_options; /** matching configuration. */
+};
+
+#endif // FUZZYMATCHER_H_
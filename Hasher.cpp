@@ -0,0 +1,198 @@
+/*
+ File: Hasher.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "Hasher.h"
+
+// C++
+#include <cstring>
+
+namespace
+{
+  const quint64 PRIME1 = 0x9E3779B185EBCA87ULL;
+  const quint64 PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+  const quint64 PRIME3 = 0x165667B19E3779F9ULL;
+  const quint64 PRIME4 = 0x85EBCA77C2B2AE63ULL;
+  const quint64 PRIME5 = 0x27D4EB2F165667C5ULL;
+
+  inline quint64 rotl(const quint64 value, const int bits)
+  { return (value << bits) | (value >> (64 - bits)); }
+
+  inline quint64 read64(const quint8 *data)
+  {
+    quint64 value = 0;
+    for(int i = 7; i >= 0; --i) value = (value << 8) | data[i];
+    return value;
+  }
+
+  inline quint64 read32(const quint8 *data)
+  {
+    quint64 value = 0;
+    for(int i = 3; i >= 0; --i) value = (value << 8) | data[i];
+    return value;
+  }
+
+  inline quint64 round(quint64 acc, const quint64 input)
+  {
+    acc += input * PRIME2;
+    acc  = rotl(acc, 31);
+    return acc * PRIME1;
+  }
+
+  inline quint64 mergeRound(quint64 acc, const quint64 value)
+  {
+    acc ^= round(0, value);
+    return acc * PRIME1 + PRIME4;
+  }
+
+  /** \brief Adds the 32 bytes stripes of the given data to the accumulators and returns the
+   *         number of bytes consumed.
+   *
+   */
+  inline qint64 stripes(quint64 *acc, const quint8 *data, const qint64 length)
+  {
+    qint64 consumed = 0;
+    while(length - consumed >= 32)
+    {
+      acc[0] = round(acc[0], read64(data + consumed));
+      acc[1] = round(acc[1], read64(data + consumed + 8));
+      acc[2] = round(acc[2], read64(data + consumed + 16));
+      acc[3] = round(acc[3], read64(data + consumed + 24));
+      consumed += 32;
+    }
+
+    return consumed;
+  }
+}
+
+//--------------------------------------------------------------------
+Hasher::Hasher(const quint64 seed)
+{
+  reset(seed);
+}
+
+//--------------------------------------------------------------------
+void Hasher::reset(const quint64 seed)
+{
+  m_seed     = seed;
+  m_acc[0]   = seed + PRIME1 + PRIME2;
+  m_acc[1]   = seed + PRIME2;
+  m_acc[2]   = seed;
+  m_acc[3]   = seed - PRIME1;
+  m_length   = 0;
+  m_buffered = 0;
+}
+
+//--------------------------------------------------------------------
+void Hasher::update(const void* data, const qint64 length)
+{
+  if(length <= 0) return;
+
+  auto bytes = static_cast<const quint8 *>(data);
+  qint64 position = 0;
+  m_length += length;
+
+  if(m_buffered > 0)
+  {
+    const auto needed = qMin<qint64>(32 - m_buffered, length);
+    std::memcpy(m_buffer + m_buffered, bytes, needed);
+    m_buffered += needed;
+    position   += needed;
+
+    if(m_buffered < 32) return;
+
+    stripes(m_acc, m_buffer, 32);
+    m_buffered = 0;
+  }
+
+  position += stripes(m_acc, bytes + position, length - position);
+
+  if(position < length)
+  {
+    m_buffered = length - position;
+    std::memcpy(m_buffer, bytes + position, m_buffered);
+  }
+}
+
+//--------------------------------------------------------------------
+quint64 Hasher::digest() const
+{
+  quint64 value;
+
+  if(m_length >= 32)
+  {
+    value = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+    for(int i = 0; i < 4; ++i) value = mergeRound(value, m_acc[i]);
+  }
+  else
+  {
+    value = m_seed + PRIME5;
+  }
+
+  value += m_length;
+
+  int i = 0;
+  for(; i + 8 <= m_buffered; i += 8)
+  {
+    value ^= round(0, read64(m_buffer + i));
+    value  = rotl(value, 27) * PRIME1 + PRIME4;
+  }
+
+  if(i + 4 <= m_buffered)
+  {
+    value ^= read32(m_buffer + i) * PRIME1;
+    value  = rotl(value, 23) * PRIME2 + PRIME3;
+    i += 4;
+  }
+
+  for(; i < m_buffered; ++i)
+  {
+    value ^= m_buffer[i] * PRIME5;
+    value  = rotl(value, 11) * PRIME1;
+  }
+
+  value ^= value >> 33;
+  value *= PRIME2;
+  value ^= value >> 29;
+  value *= PRIME3;
+  value ^= value >> 32;
+
+  return value;
+}
+
+//--------------------------------------------------------------------
+quint64 Hasher::hash(const void* data, const qint64 length, const quint64 seed)
+{
+  Hasher hasher{seed};
+  hasher.update(data, length);
+
+  return hasher.digest();
+}
+
+//--------------------------------------------------------------------
+quint64 Hasher::mix(quint64 value)
+{
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+
+  return value;
+}
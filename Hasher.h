@@ -0,0 +1,80 @@
+/*
+ File: Hasher.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HASHER_H_
+#define HASHER_H_
+
+// Qt
+#include <QtGlobal>
+
+/** \class Hasher
+ * \brief Streaming 64 bits XXH64 hash. Input can be added in blocks of any size and the
+ *        result is the same as hashing all of it at once.
+ *
+ */
+class Hasher
+{
+  public:
+    /** \brief Hasher class constructor.
+     * \param[in] seed Hash seed.
+     *
+     */
+    explicit Hasher(const quint64 seed = 0);
+
+    /** \brief Restarts the hash with the given seed.
+     * \param[in] seed Hash seed.
+     *
+     */
+    void reset(const quint64 seed = 0);
+
+    /** \brief Adds the given data to the hash.
+     * \param[in] data Data pointer.
+     * \param[in] length Data length in bytes.
+     *
+     */
+    void update(const void *data, const qint64 length);
+
+    /** \brief Returns the hash of the data added so far.
+     *
+     */
+    quint64 digest() const;
+
+    /** \brief Returns the hash of the given data.
+     * \param[in] data Data pointer.
+     * \param[in] length Data length in bytes.
+     * \param[in] seed Hash seed.
+     *
+     */
+    static quint64 hash(const void *data, const qint64 length, const quint64 seed = 0);
+
+    /** \brief Returns the given value with its bits mixed, so close values give unrelated results.
+     * \param[in] value Value to mix.
+     *
+     */
+    static quint64 mix(quint64 value);
+
+  private:
+    quint64 m_seed;      /** hash seed.                                 */
+    quint64 m_acc[4];    /** accumulators of the 32 bytes stripes.      */
+    quint64 m_length;    /** number of bytes added.                     */
+    quint8  m_buffer[32];/** bytes not yet added to the accumulators.   */
+    int     m_buffered;  /** number of bytes in the buffer.             */
+};
+
+#endif // HASHER_H_
@@ -0,0 +1,104 @@
+/*
+ File: MinHash.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "MinHash.h"
+#include "Hasher.h"
+
+// Qt
+#include <QDataStream>
+
+// C++
+#include <algorithm>
+
+const int MinHash::SIZE;
+
+//--------------------------------------------------------------------
+MinHash::MinHash()
+{
+  clear();
+}
+
+//--------------------------------------------------------------------
+void MinHash::add(const quint64 element)
+{
+  // each function is the mix of the element with its own offset, they only keep the high bits.
+  for(int i = 0; i < SIZE; ++i)
+  {
+    const auto value = static_cast<quint32>(Hasher::mix(element + (i + 1) * 0x9e3779b97f4a7c15ULL) >> 32);
+    m_minimums[i] = std::min(m_minimums[i], value);
+  }
+
+  ++m_count;
+}
+
+//--------------------------------------------------------------------
+void MinHash::clear()
+{
+  std::fill(m_minimums, m_minimums + SIZE, 0xffffffffU);
+  m_count = 0;
+}
+
+//--------------------------------------------------------------------
+double MinHash::similarity(const MinHash &other) const
+{
+  if(m_count == 0 || other.m_count == 0) return (m_count == other.m_count) ? 1. : 0.;
+
+  int equal = 0;
+  for(int i = 0; i < SIZE; ++i)
+  {
+    if(m_minimums[i] == other.m_minimums[i]) ++equal;
+  }
+
+  return static_cast<double>(equal) / SIZE;
+}
+
+//--------------------------------------------------------------------
+double MinHash::containment(const MinHash &other) const
+{
+  if(m_count == 0) return 1.;
+
+  // the common elements of sets A and B are J (|A| + |B|) / (1 + J).
+  const auto jaccard = similarity(other);
+  const auto common  = jaccard * (static_cast<double>(m_count) + other.m_count) / (1. + jaccard);
+
+  return std::min(1., common / m_count);
+}
+
+//--------------------------------------------------------------------
+QDataStream &operator<<(QDataStream &stream, const MinHash &sketch)
+{
+  for(int i = 0; i < MinHash::SIZE; ++i)
+  {
+    stream << sketch.m_minimums[i];
+  }
+
+  return stream << sketch.m_count;
+}
+
+//--------------------------------------------------------------------
+QDataStream &operator>>(QDataStream &stream, MinHash &sketch)
+{
+  for(int i = 0; i < MinHash::SIZE; ++i)
+  {
+    stream >> sketch.m_minimums[i];
+  }
+
+  return stream >> sketch.m_count;
+}
@@ -0,0 +1,96 @@
+/*
+ File: MinHash.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MINHASH_H_
+#define MINHASH_H_
+
+// Qt
+#include <QtGlobal>
+
+class QDataStream;
+
+/** \class MinHash
+ * \brief Fixed size MinHash sketch of a set of 64 bits elements, the minimum of each of SIZE
+ *        hash functions over the elements and the number of elements added. Two sketches give an
+ *        estimate of the Jaccard similarity of their sets, with a standard error of about
+ *        1/sqrt(SIZE), without the sets themselves.
+ *
+ */
+class MinHash
+{
+  public:
+    static const int SIZE = 64; /** number of hash functions, a standard error of about 0.06. */
+
+    /** \brief MinHash class constructor, the sketch of an empty set.
+     *
+     */
+    MinHash();
+
+    /** \brief Adds the given element to the set.
+     * \param[in] element Well distributed hash of the element.
+     *
+     */
+    void add(const quint64 element);
+
+    /** \brief Empties the set.
+     *
+     */
+    void clear();
+
+    /** \brief Returns the number of elements added.
+     *
+     */
+    quint32 count() const
+    { return m_count; }
+
+    /** \brief Returns the estimated Jaccard similarity of both sets, 1 if both are empty.
+     * \param[in] other Sketch of the other set.
+     *
+     */
+    double similarity(const MinHash &other) const;
+
+    /** \brief Returns the estimated fraction of the elements of this set that are also in the other one.
+     * \param[in] other Sketch of the other set.
+     *
+     */
+    double containment(const MinHash &other) const;
+
+    friend QDataStream &operator<<(QDataStream &stream, const MinHash &sketch);
+    friend QDataStream &operator>>(QDataStream &stream, MinHash &sketch);
+
+  private:
+    quint32 m_minimums[SIZE]; /** minimum of each hash function. */
+    quint32 m_count;          /** number of elements added.      */
+};
+
+/** \brief Writes the sketch to the stream.
+ * \param[in] stream Data stream.
+ * \param[in] sketch MinHash sketch.
+ *
+ */
+QDataStream &operator<<(QDataStream &stream, const MinHash &sketch);
+
+/** \brief Reads the sketch from the stream.
+ * \param[in] stream Data stream.
+ * \param[out] sketch MinHash sketch.
+ *
+ */
+QDataStream &operator>>(QDataStream &stream, MinHash &sketch);
+
+#endif /* MINHASH_H_ */
@@ -0,0 +1,306 @@
+/*
+ File: NameIndex.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NAMEINDEX_H_
+#define NAMEINDEX_H_
+
+// Qt
+#include <QString>
+#include <QVector>
+
+// Boost
+#include <boost/functional/hash.hpp>
+
+/** \class NameIndex
+ * \brief Groups values by normalized name, or by any other key with a well distributed
+ *        64 bits hash like a directory signature. The slots table uses open addressing with linear
+ *        probing and stores the full hash of each key so probing and growing don't compare or
+ *        rehash names. Groups and values are kept in contiguous arrays, the values of a group
+ *        are chained in insertion order.
+ *
+ */
+template<class T, class Key = QString>
+class NameIndex
+{
+  public:
+    /** \brief NameIndex class constructor.
+     * \param[in] capacity Initial number of slots, rounded up to a power of two.
+     *
+     */
+    explicit NameIndex(const int capacity = 1024)
+    : m_lookups{0}
+    , m_probes {0}
+    {
+      int size = 16;
+      while(size < capacity) size <<= 1;
+
+      m_slots.fill(Slot(), size);
+    }
+
+    /** \brief Returns the hash of the given normalized name.
+     * \param[in] name Normalized name.
+     *
+     */
+    static quint64 hash(const QString &name)
+    {
+      const auto data = name.utf16();
+      quint64 value = boost::hash_range(data, data + name.size());
+
+      // mixes the bits, the low ones select the slot and the high ones may select a shard.
+      value ^= value >> 33;
+      value *= 0xff51afd7ed558ccdULL;
+      value ^= value >> 33;
+      value *= 0xc4ceb9fe1a85ec53ULL;
+      value ^= value >> 33;
+
+      return value;
+    }
+
+    /** \brief Adds the value to the group of the given key and returns the group index.
+     * \param[in] key Normalized name or key.
+     * \param[in] hashValue Hash of the key.
+     * \param[in] value Value to add.
+     *
+     */
+    int insert(const Key &key, const quint64 hashValue, const T &value)
+    {
+      if((m_groups.size() + 1) * 10 > m_slots.size() * 7) grow();
+
+      auto index = probe(key, hashValue);
+      auto &slot = m_slots[index];
+      if(slot.group == EMPTY)
+      {
+        slot.hash  = hashValue;
+        slot.group = m_groups.size();
+
+        m_groups << Group(key);
+      }
+
+      auto &group = m_groups[slot.group];
+      const auto position = m_values.size();
+
+      m_values << value;
+      m_next   << EMPTY;
+
+      if(group.last == EMPTY) group.first = position;
+      else                    m_next[group.last] = position;
+
+      group.last = position;
+      ++group.count;
+
+      return slot.group;
+    }
+
+    /** \brief Removes the value from the group of the given key and returns true if it was
+     *        there. The value stays unused in the values array and an emptied group keeps its
+     *        slot, both until the index is cleared.
+     * \param[in] key Normalized name or key.
+     * \param[in] hashValue Hash of the key.
+     * \param[in] value Value to remove.
+     *
+     */
+    bool remove(const Key &key, const quint64 hashValue, const T &value)
+    {
+      const auto index = m_slots.at(probe(key, hashValue)).group;
+      if(index == EMPTY) return false;
+
+      auto &group = m_groups[index];
+      for(int i = group.first, previous = EMPTY; i != EMPTY; previous = i, i = m_next.at(i))
+      {
+        if(!(m_values.at(i) == value)) continue;
+
+        const auto next = m_next.at(i);
+        if(previous == EMPTY) group.first = next;
+        else                  m_next[previous] = next;
+        if(group.last == i) group.last = previous;
+        --group.count;
+
+        return true;
+      }
+
+      return false;
+    }
+
+    /** \brief Returns the index of the group of the given key or -1 if there isn't one.
+     * \param[in] key Normalized name or key.
+     * \param[in] hashValue Hash of the key.
+     *
+     */
+    int find(const Key &key, const quint64 hashValue) const
+    {
+      return m_slots.at(probe(key, hashValue)).group;
+    }
+
+    /** \brief Returns the number of groups.
+     *
+     */
+    int groups() const
+    { return m_groups.size(); }
+
+    /** \brief Returns the number of values.
+     *
+     */
+    int size() const
+    { return m_values.size(); }
+
+    /** \brief Returns the fraction of used slots.
+     *
+     */
+    double loadFactor() const
+    { return static_cast<double>(m_groups.size()) / m_slots.size(); }
+
+    /** \brief Returns the number of lookups of the table, by insertion or search.
+     *
+     */
+    qint64 lookups() const
+    { return m_lookups; }
+
+    /** \brief Returns the number of slots visited by the lookups.
+     *
+     */
+    qint64 probes() const
+    { return m_probes; }
+
+    /** \brief Returns the key of the given group.
+     * \param[in] group Group index.
+     *
+     */
+    const Key &key(const int group) const
+    { return m_groups.at(group).key; }
+
+    /** \brief Returns the number of values in the given group.
+     * \param[in] group Group index.
+     *
+     */
+    int count(const int group) const
+    { return m_groups.at(group).count; }
+
+    /** \brief Returns the values of the given group in insertion order.
+     * \param[in] group Group index.
+     *
+     */
+    QVector<T> values(const int group) const
+    {
+      QVector<T> result;
+      result.reserve(m_groups.at(group).count);
+
+      for(auto i = m_groups.at(group).first; i != EMPTY; i = m_next.at(i))
+      {
+        result << m_values.at(i);
+      }
+
+      return result;
+    }
+
+    /** \brief Removes all the groups and values.
+     *
+     */
+    void clear()
+    {
+      m_slots.fill(Slot());
+      m_groups.clear();
+      m_values.clear();
+      m_next.clear();
+
+      m_lookups = m_probes = 0;
+    }
+
+  private:
+    enum { EMPTY = -1 }; /** unused slot or end of chain. */
+
+    /** \struct Slot
+     * \brief Hash table slot.
+     *
+     */
+    struct Slot
+    {
+      quint64     hash;  /** hash of the group key.             */
+      int         group; /** group index or EMPTY if not used.  */
+
+      Slot(): hash{0}, group{EMPTY} {};
+    };
+
+    /** \struct Group
+     * \brief Values with the same key.
+     *
+     */
+    struct Group
+    {
+      Key key;   /** normalized name or key.         */
+      int first; /** index of the first value.       */
+      int last;  /** index of the last value.        */
+      int count; /** number of values in the group.  */
+
+      Group(): key(), first{EMPTY}, last{EMPTY}, count{0} {};
+      explicit Group(const Key &k): key(k), first{EMPTY}, last{EMPTY}, count{0} {};
+    };
+
+    /** \brief Returns the slot of the given key, or the empty slot where it should be inserted.
+     * \param[in] key Normalized name or key.
+     * \param[in] hashValue Hash of the key.
+     *
+     */
+    int probe(const Key &key, const quint64 hashValue) const
+    {
+      const auto mask = m_slots.size() - 1;
+      auto index = static_cast<int>(hashValue & mask);
+
+      ++m_lookups;
+      while(true)
+      {
+        ++m_probes;
+
+        const auto &slot = m_slots.at(index);
+        if(slot.group == EMPTY) return index;
+        if(slot.hash == hashValue && m_groups.at(slot.group).key == key) return index;
+
+        index = (index + 1) & mask;
+      }
+    }
+
+    /** \brief Doubles the number of slots, reinserting the groups with their stored hashes.
+     *
+     */
+    void grow()
+    {
+      QVector<Slot> table(m_slots.size() * 2);
+      const auto mask = table.size() - 1;
+
+      for(const auto &slot: m_slots)
+      {
+        if(slot.group == EMPTY) continue;
+
+        auto index = static_cast<int>(slot.hash & mask);
+        while(table.at(index).group != EMPTY) index = (index + 1) & mask;
+
+        table[index] = slot;
+      }
+
+      m_slots.swap(table);
+    }
+
+    QVector<Slot>  m_slots;   /** open addressing table.              */
+    QVector<Group> m_groups;  /** groups in creation order.           */
+    QVector<T>     m_values;  /** values in insertion order.          */
+    QVector<int>   m_next;    /** next value of the same group.       */
+    mutable qint64 m_lookups; /** number of lookups.                  */
+    mutable qint64 m_probes;  /** number of slots visited by lookups. */
+};
+
+#endif // NAMEINDEX_H_
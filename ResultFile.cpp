@@ -0,0 +1,613 @@
+/*
+ File: ResultFile.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ResultFile.h"
+#include "ResultWriter.h"
+
+// Qt
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+
+// C++
+#include <algorithm>
+#include <cstring>
+
+const quint32 ResultFile::MAGIC;
+const quint32 ResultFile::VERSION;
+
+namespace
+{
+  const qint64 COPY_BLOCK = 1024*1024; /** bytes copied at once from the temporary files. */
+
+  //-----------------------------------------------------------------
+  QSet<QString> paths(const DuplicateGroup &group)
+  {
+    QSet<QString> result;
+    result.reserve(group.names.size());
+    for(int i = 0; i < group.names.size(); ++i)
+    {
+      result.insert(group.parents.at(i) + group.names.at(i));
+    }
+
+    return result;
+  }
+
+  //-----------------------------------------------------------------
+  ResultFile::Change compare(const QSet<QString> &before, const QSet<QString> &after)
+  {
+    const auto added   = !before.contains(after);
+    const auto removed = !after.contains(before);
+
+    if(added && removed) return ResultFile::Change::CHANGED;
+    if(added)            return ResultFile::Change::GROWN;
+    if(removed)          return ResultFile::Change::SHRUNK;
+
+    return ResultFile::Change::UNCHANGED;
+  }
+
+  //-----------------------------------------------------------------
+  bool copy(QIODevice &source, QIODevice &destination)
+  {
+    if(!source.seek(0)) return false;
+
+    while(!source.atEnd())
+    {
+      const auto block = source.read(COPY_BLOCK);
+      if(block.isEmpty() || destination.write(block) != block.size()) return false;
+    }
+
+    return true;
+  }
+}
+
+//--------------------------------------------------------------------
+ResultFile::ResultFile()
+: m_data{nullptr}
+, m_size{0}
+{
+  std::memset(&m_header, 0, sizeof(Header));
+}
+
+//--------------------------------------------------------------------
+ResultFile::~ResultFile()
+{
+  close();
+}
+
+//--------------------------------------------------------------------
+bool ResultFile::create(const QString& fileName, const QString& root, const ScanOptions::Mode mode)
+{
+  close();
+
+  m_strings.clear();
+  m_keys.clear();
+
+  QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+  m_output.reset(new QSaveFile(fileName));
+  m_members.reset(new QTemporaryFile(QDir::tempPath() + "/duplicates-XXXXXX.members"));
+  m_groups.reset(new QTemporaryFile(QDir::tempPath() + "/duplicates-XXXXXX.groups"));
+
+  if(!m_output->open(QIODevice::WriteOnly) || !m_members->open() || !m_groups->open())
+  {
+    m_output.reset();
+    m_members.reset();
+    m_groups.reset();
+    return false;
+  }
+
+  std::memset(&m_header, 0, sizeof(Header));
+  m_header.magic   = MAGIC;
+  m_header.version = VERSION;
+  m_header.mode    = static_cast<quint32>(mode);
+
+  // the header is written again with the offsets when committed.
+  m_output->write(reinterpret_cast<const char *>(&m_header), sizeof(Header));
+  m_header.root = intern(root);
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+void ResultFile::append(const DuplicateGroup& group)
+{
+  if(!m_output) return;
+
+  const Group record{group.key, m_header.members, static_cast<quint64>(group.names.size())};
+  m_keys << qMakePair(group.key, m_header.groups);
+
+  for(int i = 0; i < group.names.size(); ++i)
+  {
+    Member member;
+    member.name        = intern(group.names.at(i));
+    member.parent      = intern(group.parents.at(i));
+    member.size        = group.sizes.value(i, 0.f);
+    member.similarity  = group.similarities.value(i, i == 0 ? 1.f : 0.f);
+    member.reclaimable = group.reclaimables.value(i, 0.f);
+    member.padding     = 0;
+
+    m_members->write(reinterpret_cast<const char *>(&member), sizeof(Member));
+  }
+
+  m_groups->write(reinterpret_cast<const char *>(&record), sizeof(Group));
+
+  ++m_header.groups;
+  m_header.members += record.count;
+}
+
+//--------------------------------------------------------------------
+bool ResultFile::commit()
+{
+  if(!m_output) return false;
+
+  // the records are aligned so they can be read in place from the map.
+  const auto padding = (8 - m_output->pos() % 8) % 8;
+  m_output->write(QByteArray(padding, '\0'));
+
+  m_header.records = m_output->pos();
+  auto ok = copy(*m_members, *m_output);
+
+  m_header.entries = m_output->pos();
+  ok &= copy(*m_groups, *m_output);
+
+  std::sort(m_keys.begin(), m_keys.end());
+
+  QVector<quint64> index;
+  index.reserve(m_keys.size());
+  for(const auto &key: m_keys) index << key.second;
+
+  m_header.index = m_output->pos();
+  const auto bytes = static_cast<qint64>(index.size() * sizeof(quint64));
+  ok &= m_output->write(reinterpret_cast<const char *>(index.constData()), bytes) == bytes;
+
+  ok &= m_output->seek(0);
+  ok &= m_output->write(reinterpret_cast<const char *>(&m_header), sizeof(Header)) == sizeof(Header);
+  ok &= m_output->commit();
+
+  m_output.reset();
+  m_members.reset();
+  m_groups.reset();
+  m_strings.clear();
+  m_keys.clear();
+
+  return ok;
+}
+
+//--------------------------------------------------------------------
+bool ResultFile::open(const QString& fileName)
+{
+  close();
+
+  m_file.setFileName(fileName);
+  if(!m_file.open(QIODevice::ReadOnly)) return false;
+
+  m_size = m_file.size();
+  if(m_size >= static_cast<qint64>(sizeof(Header))) m_data = m_file.map(0, m_size);
+
+  if(!m_data)
+  {
+    close();
+    return false;
+  }
+
+  std::memcpy(&m_header, m_data, sizeof(Header));
+
+  // the sections follow each other, anything else is another version or a damaged file.
+  const auto &header = m_header;
+  const auto valid = header.magic == MAGIC && header.version == VERSION && header.mode <= static_cast<quint32>(ScanOptions::Mode::SIMILAR) &&
+                     header.records % 8 == 0 && header.records <= static_cast<quint64>(m_size) &&
+                     header.entries == header.records + header.members * sizeof(Member) &&
+                     header.index == header.entries + header.groups * sizeof(Group) &&
+                     header.index + header.groups * sizeof(quint64) == static_cast<quint64>(m_size);
+
+  if(!valid)
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+void ResultFile::close()
+{
+  if(m_data) m_file.unmap(m_data);
+  m_data = nullptr;
+  m_size = 0;
+
+  if(m_file.isOpen()) m_file.close();
+}
+
+//--------------------------------------------------------------------
+QString ResultFile::root() const
+{
+  return string(m_header.root);
+}
+
+//--------------------------------------------------------------------
+ScanOptions::Mode ResultFile::mode() const
+{
+  return static_cast<ScanOptions::Mode>(m_header.mode);
+}
+
+//--------------------------------------------------------------------
+qint64 ResultFile::groups() const
+{
+  return static_cast<qint64>(m_header.groups);
+}
+
+//--------------------------------------------------------------------
+qint64 ResultFile::rows() const
+{
+  return isOpen() ? static_cast<qint64>(m_header.members - m_header.groups) : 0;
+}
+
+//--------------------------------------------------------------------
+DuplicateGroup ResultFile::group(const qint64 index) const
+{
+  DuplicateGroup result;
+  if(!isOpen() || index < 0 || index >= groups()) return result;
+
+  const auto &record = groupRecord(index);
+  if(record.first + record.count > m_header.members) return result;
+
+  result.key = record.key;
+  for(quint64 i = record.first; i < record.first + record.count; ++i)
+  {
+    const auto &member = memberRecord(i);
+    result.names        << string(member.name);
+    result.parents      << string(member.parent);
+    result.sizes        << member.size;
+    result.similarities << member.similarity;
+    result.reclaimables << member.reclaimable;
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+qint64 ResultFile::sorted(const qint64 position) const
+{
+  if(!isOpen() || position < 0 || position >= groups()) return -1;
+
+  const auto index = reinterpret_cast<const quint64 *>(m_data + m_header.index)[position];
+
+  return index < m_header.groups ? static_cast<qint64>(index) : -1;
+}
+
+//--------------------------------------------------------------------
+Duplicate ResultFile::duplicate(const qint64 row) const
+{
+  Duplicate result{QString(), QString(), 0.f, QString(), QString(), 0.f, 0.f, 0.f, 0};
+  if(row < 0 || row >= rows()) return result;
+
+  // every group has a row less than members, so the rows before a group are the members
+  // before it minus its number.
+  qint64 low = 0, high = groups() - 1;
+  while(low < high)
+  {
+    const auto middle = (low + high + 1) / 2;
+    if(static_cast<qint64>(groupRecord(middle).first) - middle <= row) low = middle;
+    else                                                              high = middle - 1;
+  }
+
+  const auto &record = groupRecord(low);
+  const auto member  = record.first + 1 + (row - (static_cast<qint64>(record.first) - low));
+  if(member >= record.first + record.count || record.first + record.count > m_header.members) return result;
+
+  const auto &original  = memberRecord(record.first);
+  const auto &duplicate = memberRecord(member);
+
+  result.name1       = string(original.name);
+  result.parent1     = string(original.parent);
+  result.size1       = original.size;
+  result.name2       = string(duplicate.name);
+  result.parent2     = string(duplicate.parent);
+  result.size2       = duplicate.size;
+  result.similarity  = duplicate.similarity;
+  result.reclaimable = duplicate.reclaimable;
+  result.key         = record.key;
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+QVector<qint64> ResultFile::sortedRows(const Field field, const Qt::SortOrder order) const
+{
+  QVector<qint64> result;
+  if(!isOpen()) return result;
+
+  const auto count = rows();
+  QVector<double> values(static_cast<int>(count));
+  result.reserve(count);
+
+  const auto isString = field == Field::NAME1 || field == Field::PARENT1 || field == Field::NAME2 || field == Field::PARENT2;
+  if(isString)
+  {
+    // the strings are interned, so their offsets are ranked instead of comparing them per row.
+    QVector<quint64> offsets(static_cast<int>(count));
+    QHash<quint64, int> ranks;
+    forEachRow([&](const qint64 row, const Member &original, const Member &duplicate)
+    {
+      switch(field)
+      {
+        case Field::NAME1:   offsets[row] = original.name;    break;
+        case Field::PARENT1: offsets[row] = original.parent;  break;
+        case Field::NAME2:   offsets[row] = duplicate.name;   break;
+        default:             offsets[row] = duplicate.parent; break;
+      }
+      ranks.insert(offsets.at(row), 0);
+    });
+
+    QVector<QPair<QString, quint64>> strings;
+    strings.reserve(ranks.size());
+    for(auto it = ranks.constBegin(); it != ranks.constEnd(); ++it)
+    {
+      strings << qMakePair(string(it.key()), it.key());
+    }
+    std::sort(strings.begin(), strings.end());
+
+    for(int i = 0; i < strings.size(); ++i)
+    {
+      ranks[strings.at(i).second] = i;
+    }
+
+    for(qint64 row = 0; row < count; ++row)
+    {
+      values[row] = ranks.value(offsets.at(row));
+    }
+  }
+  else
+  {
+    forEachRow([&](const qint64 row, const Member &original, const Member &duplicate)
+    {
+      switch(field)
+      {
+        case Field::SIZE1:      values[row] = original.size;          break;
+        case Field::SIZE2:      values[row] = duplicate.size;         break;
+        case Field::SIMILARITY: values[row] = duplicate.similarity;   break;
+        default:                values[row] = duplicate.reclaimable;  break;
+      }
+    });
+  }
+
+  for(qint64 row = 0; row < count; ++row)
+  {
+    result << row;
+  }
+
+  if(order == Qt::AscendingOrder)
+  {
+    std::stable_sort(result.begin(), result.end(), [&values](const qint64 lhs, const qint64 rhs)
+    { return values.at(lhs) < values.at(rhs); });
+  }
+  else
+  {
+    std::stable_sort(result.begin(), result.end(), [&values](const qint64 lhs, const qint64 rhs)
+    { return values.at(rhs) < values.at(lhs); });
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+QVector<qint64> ResultFile::matchingRows(const QString& text) const
+{
+  QVector<qint64> result;
+  if(!isOpen()) return result;
+
+  QHash<quint64, bool> strings;
+  auto contains = [this, &text, &strings](const quint64 offset)
+  {
+    auto it = strings.constFind(offset);
+    if(it == strings.constEnd()) it = strings.insert(offset, string(offset).contains(text, Qt::CaseInsensitive));
+
+    return it.value();
+  };
+
+  // the numbers are only written with these characters, any other can't be in them.
+  const auto numeric = std::all_of(text.cbegin(), text.cend(), [](const QChar c)
+  { return c.isDigit() || QString(".e+-").contains(c, Qt::CaseInsensitive); });
+
+  auto inNumbers = [&text](const Member &original, const Member &duplicate)
+  {
+    return QString::number(original.size).contains(text, Qt::CaseInsensitive) ||
+           QString::number(duplicate.size).contains(text, Qt::CaseInsensitive) ||
+           QString::number(qRound(duplicate.similarity * 100)).contains(text) ||
+           QString::number(duplicate.reclaimable).contains(text, Qt::CaseInsensitive);
+  };
+
+  forEachRow([&](const qint64 row, const Member &original, const Member &duplicate)
+  {
+    if(contains(original.name) || contains(original.parent) || contains(duplicate.name) || contains(duplicate.parent) ||
+       (numeric && inNumbers(original, duplicate)))
+    {
+      result << row;
+    }
+  });
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+void ResultFile::write(ResultWriter& writer) const
+{
+  const auto folders = root();
+  for(qint64 i = 0; i < groups(); ++i)
+  {
+    writer.write(group(i), folders);
+  }
+}
+
+//--------------------------------------------------------------------
+bool ResultFile::diff(const QString& before, const QString& after, const Callback& callback)
+{
+  ResultFile lhs, rhs;
+  if(!lhs.open(before) || !rhs.open(after) || lhs.mode() != rhs.mode()) return false;
+
+  auto key = [](const ResultFile &file, const qint64 position)
+  {
+    const auto index = file.sorted(position);
+    return index < 0 ? 0 : file.groupRecord(index).key;
+  };
+
+  const DuplicateGroup none;
+  qint64 i = 0, j = 0;
+  while(i < lhs.groups() || j < rhs.groups())
+  {
+    if(j == rhs.groups() || (i < lhs.groups() && key(lhs, i) < key(rhs, j)))
+    {
+      callback(Change::RESOLVED, lhs.group(lhs.sorted(i++)), none);
+      continue;
+    }
+
+    if(i == lhs.groups() || key(rhs, j) < key(lhs, i))
+    {
+      callback(Change::NEW, none, rhs.group(rhs.sorted(j++)));
+      continue;
+    }
+
+    // the groups of the same key are paired by the directories they share, usually there's
+    // only one on each side.
+    const auto value = key(lhs, i);
+    QVector<DuplicateGroup> earlier, later;
+    for(; i < lhs.groups() && key(lhs, i) == value; ++i) earlier << lhs.group(lhs.sorted(i));
+    for(; j < rhs.groups() && key(rhs, j) == value; ++j) later << rhs.group(rhs.sorted(j));
+
+    QVector<QSet<QString>> earlierPaths;
+    for(const auto &group: earlier) earlierPaths << paths(group);
+
+    QVector<bool> paired(earlier.size(), false);
+    for(const auto &group: later)
+    {
+      const auto laterPaths = paths(group);
+
+      int best = -1, shared = 0;
+      for(int k = 0; k < earlier.size(); ++k)
+      {
+        if(paired.at(k)) continue;
+
+        const auto count = QSet<QString>(earlierPaths.at(k)).intersect(laterPaths).size();
+        if(count > shared)
+        {
+          best   = k;
+          shared = count;
+        }
+      }
+
+      if(best < 0)
+      {
+        callback(Change::NEW, none, group);
+        continue;
+      }
+
+      paired[best] = true;
+      callback(compare(earlierPaths.at(best), laterPaths), earlier.at(best), group);
+    }
+
+    for(int k = 0; k < earlier.size(); ++k)
+    {
+      if(!paired.at(k)) callback(Change::RESOLVED, earlier.at(k), none);
+    }
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+QString ResultFile::name(const Change change)
+{
+  switch(change)
+  {
+    case Change::NEW:      return "new";
+    case Change::RESOLVED: return "resolved";
+    case Change::GROWN:    return "grown";
+    case Change::SHRUNK:   return "shrunk";
+    case Change::CHANGED:  return "changed";
+    default:               break;
+  }
+
+  return "unchanged";
+}
+
+//--------------------------------------------------------------------
+quint64 ResultFile::intern(const QString& text)
+{
+  const auto it = m_strings.constFind(text);
+  if(it != m_strings.constEnd()) return it.value();
+
+  const auto offset = static_cast<quint64>(m_output->pos());
+  const auto data   = text.toUtf8();
+  const auto length = static_cast<quint32>(data.size());
+
+  m_output->write(reinterpret_cast<const char *>(&length), sizeof(quint32));
+  m_output->write(data);
+
+  m_strings.insert(text, offset);
+
+  return offset;
+}
+
+//--------------------------------------------------------------------
+QString ResultFile::string(const quint64 offset) const
+{
+  if(!isOpen() || offset + sizeof(quint32) > static_cast<quint64>(m_size)) return QString();
+
+  quint32 length;
+  std::memcpy(&length, m_data + offset, sizeof(quint32));
+  if(offset + sizeof(quint32) + length > static_cast<quint64>(m_size)) return QString();
+
+  return QString::fromUtf8(reinterpret_cast<const char *>(m_data + offset + sizeof(quint32)), length);
+}
+
+//--------------------------------------------------------------------
+const ResultFile::Group& ResultFile::groupRecord(const qint64 index) const
+{
+  return reinterpret_cast<const Group *>(m_data + m_header.entries)[index];
+}
+
+//--------------------------------------------------------------------
+const ResultFile::Member& ResultFile::memberRecord(const qint64 index) const
+{
+  return reinterpret_cast<const Member *>(m_data + m_header.records)[index];
+}
+
+//--------------------------------------------------------------------
+void ResultFile::forEachRow(const std::function<void(const qint64, const Member &, const Member &)> &function) const
+{
+  if(!isOpen()) return;
+
+  // the rows are numbered as in duplicate(), the rows before a group are its first member
+  // minus its number.
+  for(qint64 index = 0; index < groups(); ++index)
+  {
+    const auto &record = groupRecord(index);
+    if(record.first + record.count > m_header.members) continue;
+
+    const auto &original = memberRecord(record.first);
+    for(quint64 member = record.first + 1; member < record.first + record.count; ++member)
+    {
+      const auto row = static_cast<qint64>(member - 1) - index;
+      if(row >= 0 && row < rows()) function(row, original, memberRecord(member));
+    }
+  }
+}
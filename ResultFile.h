@@ -0,0 +1,305 @@
+/*
+ File: ResultFile.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULTFILE_H_
+#define RESULTFILE_H_
+
+// Project
+#include "ScanThread.h"
+
+// Qt
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+
+// C++
+#include <functional>
+
+class ResultWriter;
+
+/** \class ResultFile
+ * \brief Duplicate groups of a scan in a binary file that is read through a memory map. The
+ *        file has a header, a table of interned UTF-8 strings, fixed-width records of the
+ *        directories and of the groups, and an index of the groups sorted by their matching
+ *        keys. Groups are appended while the scan reports them, the strings go straight to the
+ *        file and the records to temporary files that are copied after them when committed.
+ *        An opened file is mapped and its groups and rows are read on demand, so it costs
+ *        little memory whatever its size. The results of two scans of the same mode are
+ *        compared by merging their indexes in a single pass: groups with the same key in both
+ *        files are the same group, and their directories tell if it has grown or shrunk since.
+ *
+ */
+class ResultFile
+{
+  public:
+    /** \brief Changes of a group between two scans.
+     *
+     */
+    enum class Change: char
+    {
+      UNCHANGED = 0, /** same directories in both scans.                          */
+      NEW       = 1, /** group only in the later scan.                            */
+      RESOLVED  = 2, /** group only in the earlier scan.                          */
+      GROWN     = 3, /** directories added to the group and none removed.         */
+      SHRUNK    = 4, /** directories removed from the group and none added.       */
+      CHANGED   = 5  /** directories both added to and removed from the group.    */
+    };
+
+    /** \brief Fields of a row, in the order of the members of a duplicate.
+     *
+     */
+    enum class Field: char
+    {
+      NAME1       = 0, /** original directory name.          */
+      PARENT1     = 1, /** original parent path.             */
+      SIZE1       = 2, /** original size.                    */
+      NAME2       = 3, /** duplicate directory name.         */
+      PARENT2     = 4, /** duplicate parent path.            */
+      SIZE2       = 5, /** duplicate size.                   */
+      SIMILARITY  = 6, /** estimated similarity.             */
+      RECLAIMABLE = 7  /** estimated reclaimable size.       */
+    };
+
+    /** \brief Callback of the differences, with the change and the group in the earlier
+     *        and later scans. The group of the scan that doesn't have it is empty.
+     *
+     */
+    using Callback = std::function<void(const Change, const DuplicateGroup &, const DuplicateGroup &)>;
+
+    /** \brief ResultFile class constructor.
+     *
+     */
+    ResultFile();
+
+    /** \brief ResultFile class destructor. Discards a file being written and not committed.
+     *
+     */
+    ~ResultFile();
+
+    /** \brief Starts writing the given file and returns true on success. The file is replaced
+     *        atomically when committed.
+     * \param[in] fileName Results file name.
+     * \param[in] root Scanned folder, or folders separated by semicolons.
+     * \param[in] mode Matching mode of the scan.
+     *
+     */
+    bool create(const QString &fileName, const QString &root, const ScanOptions::Mode mode);
+
+    /** \brief Adds the given group to the file being written.
+     * \param[in] group Duplicated directories.
+     *
+     */
+    void append(const DuplicateGroup &group);
+
+    /** \brief Writes the records and the index of the groups after the strings and returns
+     *        true on success.
+     *
+     */
+    bool commit();
+
+    /** \brief Maps the given file and returns true if it's a valid results file.
+     * \param[in] fileName Results file name.
+     *
+     */
+    bool open(const QString &fileName);
+
+    /** \brief Unmaps the opened file.
+     *
+     */
+    void close();
+
+    /** \brief Returns true if a file is opened.
+     *
+     */
+    bool isOpen() const
+    { return m_data != nullptr; }
+
+    /** \brief Returns the scanned folders of the opened file.
+     *
+     */
+    QString root() const;
+
+    /** \brief Returns the matching mode of the opened file.
+     *
+     */
+    ScanOptions::Mode mode() const;
+
+    /** \brief Returns the number of groups of the opened file, or of the file being written.
+     *
+     */
+    qint64 groups() const;
+
+    /** \brief Returns the number of rows of the opened file, one per duplicated directory
+     *        along the original of its group.
+     *
+     */
+    qint64 rows() const;
+
+    /** \brief Returns the given group of the opened file, in the order they were found.
+     * \param[in] index Group number.
+     *
+     */
+    DuplicateGroup group(const qint64 index) const;
+
+    /** \brief Returns the number of the group at the given position of the key order.
+     * \param[in] position Position in the index.
+     *
+     */
+    qint64 sorted(const qint64 position) const;
+
+    /** \brief Returns the given row of the opened file.
+     * \param[in] row Row number.
+     *
+     */
+    Duplicate duplicate(const qint64 row) const;
+
+    /** \brief Returns the row numbers of the opened file sorted by the given field, rows with
+     *        equal values keep their order. Each string is read once and ranked, the rows are
+     *        sorted by the ranks of their strings or by the numbers of their records.
+     * \param[in] field Field to sort by.
+     * \param[in] order Ascending or descending order.
+     *
+     */
+    QVector<qint64> sortedRows(const Field field, const Qt::SortOrder order) const;
+
+    /** \brief Returns the numbers of the rows of the opened file with the given text in a name
+     *        or parent path, ignoring case, or in a number as the table shows it. Each string is
+     *        read once.
+     * \param[in] text Text to search for.
+     *
+     */
+    QVector<qint64> matchingRows(const QString &text) const;
+
+    /** \brief Writes the groups of the opened file with the given writer.
+     * \param[in] writer Results writer.
+     *
+     */
+    void write(ResultWriter &writer) const;
+
+    /** \brief Compares the results of two scans of the same mode, calling the callback for
+     *        every group of either file in key order. Returns false if a file can't be read
+     *        or the modes differ.
+     * \param[in] before Results file of the earlier scan.
+     * \param[in] after Results file of the later scan.
+     * \param[in] callback Called with the change of each group.
+     *
+     */
+    static bool diff(const QString &before, const QString &after, const Callback &callback);
+
+    /** \brief Returns the lowercase name of the given change.
+     * \param[in] change Group change.
+     *
+     */
+    static QString name(const Change change);
+
+    static const quint32 MAGIC   = 0x44555052; /** results files magic number. */
+    static const quint32 VERSION = 2;          /** results files version.      */
+
+  private:
+    /** \struct Header
+     * \brief Start of the file, offsets are in bytes from the start of the file.
+     *
+     */
+    struct Header
+    {
+      quint32 magic;   /** results files magic number.          */
+      quint32 version; /** results files version.               */
+      quint32 mode;    /** matching mode.                       */
+      quint32 padding; /** unused.                              */
+      quint64 root;    /** string of the scanned folders.       */
+      quint64 groups;  /** number of group records.             */
+      quint64 members; /** number of directory records.         */
+      quint64 records; /** offset of the directory records.     */
+      quint64 entries; /** offset of the group records.         */
+      quint64 index;   /** offset of the sorted group numbers.  */
+    };
+
+    /** \struct Member
+     * \brief Record of a directory of a group.
+     *
+     */
+    struct Member
+    {
+      quint64 name;        /** string of the directory name.                   */
+      quint64 parent;      /** string of the parent path.                      */
+      float   size;        /** size in megabytes.                              */
+      float   similarity;  /** estimated similarity with the original.         */
+      float   reclaimable; /** megabytes estimated to be also in the original. */
+      quint32 padding;     /** unused.                                         */
+    };
+
+    /** \struct Group
+     * \brief Record of a group, its directories are consecutive members.
+     *
+     */
+    struct Group
+    {
+      quint64 key;     /** matching key.                     */
+      quint64 first;   /** number of its first member.       */
+      quint64 count;   /** number of members.                */
+    };
+
+    /** \brief Returns the offset of the given string in the file being written, adding it
+     *        if it's new.
+     * \param[in] text String.
+     *
+     */
+    quint64 intern(const QString &text);
+
+    /** \brief Returns the string at the given offset of the opened file.
+     * \param[in] offset String offset.
+     *
+     */
+    QString string(const quint64 offset) const;
+
+    /** \brief Returns the record of the given group of the opened file.
+     * \param[in] index Group number.
+     *
+     */
+    const Group &groupRecord(const qint64 index) const;
+
+    /** \brief Returns the record of the given member of the opened file.
+     * \param[in] index Member number.
+     *
+     */
+    const Member &memberRecord(const qint64 index) const;
+
+    /** \brief Calls the given function with the number and the records of the original and the
+     *        duplicate of every row of the opened file, in order.
+     * \param[in] function Called for each row.
+     *
+     */
+    void forEachRow(const std::function<void(const qint64, const Member &, const Member &)> &function) const;
+
+    QFile                          m_file;    /** opened file.                               */
+    uchar                         *m_data;    /** opened file memory map.                    */
+    qint64                         m_size;    /** opened file size.                          */
+    QScopedPointer<QSaveFile>      m_output;  /** file being written.                        */
+    QScopedPointer<QTemporaryFile> m_members; /** directory records being written.           */
+    QScopedPointer<QTemporaryFile> m_groups;  /** group records being written.               */
+    Header                         m_header;  /** header of the opened or written file.      */
+    QHash<QString, quint64>        m_strings; /** offsets of the strings being written.      */
+    QVector<QPair<quint64, quint64>> m_keys;  /** keys and numbers of the groups being written. */
+};
+
+#endif // RESULTFILE_H_
@@ -0,0 +1,113 @@
+/*
+ File: ResultWriter.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ResultWriter.h"
+
+// Qt
+#include <QIODevice>
+#include <QFileDevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+//--------------------------------------------------------------------
+ResultWriter::ResultWriter(QIODevice* device, const Format format, const bool changes)
+: m_device {device}
+, m_format {format}
+, m_changes{changes}
+, m_groups {0}
+{
+  if(m_format == Format::CSV)
+  {
+    m_device->write(m_changes ? "change,group,name,parent,size\n" : "group,name,parent,size\n");
+  }
+}
+
+//--------------------------------------------------------------------
+void ResultWriter::write(const DuplicateGroup& group, const QString& root, const QString& change)
+{
+  ++m_groups;
+
+  QByteArray data;
+  if(m_format == Format::NDJSON)
+  {
+    QJsonArray directories;
+    for(int i = 0; i < group.names.size(); ++i)
+    {
+      QJsonObject directory;
+      directory.insert("name",   group.names.at(i));
+      directory.insert("parent", group.parents.at(i));
+      directory.insert("size",   static_cast<double>(group.sizes.at(i)));
+
+      directories.append(directory);
+    }
+
+    QJsonObject object;
+    if(m_changes) object.insert("change", change);
+    object.insert("group",       m_groups);
+    object.insert("root",        root);
+    object.insert("directories", directories);
+
+    data = QJsonDocument(object).toJson(QJsonDocument::Compact) + "\n";
+  }
+  else
+  {
+    for(int i = 0; i < group.names.size(); ++i)
+    {
+      // a single substitution, a name with a percent sign isn't replaced again.
+      auto line = QString("%1,%2,%3,%4\n").arg(QString::number(m_groups),
+                                               csvField(group.names.at(i)),
+                                               csvField(group.parents.at(i)),
+                                               QString::number(group.sizes.at(i)));
+      if(m_changes) line.prepend(change + ",");
+
+      data += line.toUtf8();
+    }
+  }
+
+  m_device->write(data);
+
+  // the consumer sees every group as soon as it's found.
+  auto file = qobject_cast<QFileDevice *>(m_device);
+  if(file) file->flush();
+}
+
+//--------------------------------------------------------------------
+ResultWriter::Format ResultWriter::format(const QString& name, bool &ok)
+{
+  ok = true;
+
+  if(name.compare("ndjson", Qt::CaseInsensitive) == 0) return Format::NDJSON;
+  if(name.compare("csv", Qt::CaseInsensitive) == 0)    return Format::CSV;
+
+  ok = false;
+  return Format::NDJSON;
+}
+
+//--------------------------------------------------------------------
+QString ResultWriter::csvField(const QString& field)
+{
+  if(!field.contains(',') && !field.contains('"') && !field.contains('\n')) return field;
+
+  auto quoted = field;
+  quoted.replace("\"", "\"\"");
+
+  return "\"" + quoted + "\"";
+}
@@ -0,0 +1,91 @@
+/*
+ File: ResultWriter.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULTWRITER_H_
+#define RESULTWRITER_H_
+
+// Project
+#include "ScanThread.h"
+
+// Qt
+#include <QString>
+
+class QIODevice;
+
+/** \class ResultWriter
+ * \brief Writes duplicate groups to a device as they are found, one group per line in
+ *        NDJSON or one directory per line in CSV, flushing after every group. The groups of
+ *        a comparison of two scans also have their change, see ResultFile.
+ *
+ */
+class ResultWriter
+{
+  public:
+    /** \brief Output formats.
+     *
+     */
+    enum class Format: char
+    {
+      NDJSON = 0, /** a JSON object per group.                               */
+      CSV    = 1  /** a row per directory with the group number, with header. */
+    };
+
+    /** \brief ResultWriter class constructor.
+     * \param[in] device Open output device.
+     * \param[in] format Output format.
+     * \param[in] changes True to write the change of each group.
+     *
+     */
+    ResultWriter(QIODevice *device, const Format format, const bool changes = false);
+
+    /** \brief Writes the given group.
+     * \param[in] group Duplicated directories.
+     * \param[in] root Scanned folder of the group, or folders separated by semicolons.
+     * \param[in] change Change of the group since the previous scan, only with changes.
+     *
+     */
+    void write(const DuplicateGroup &group, const QString &root, const QString &change = QString());
+
+    /** \brief Returns the number of groups written.
+     *
+     */
+    int groups() const
+    { return m_groups; }
+
+    /** \brief Returns the format of the given name, "ndjson" or "csv", and false in ok if unknown.
+     * \param[in] name Format name.
+     * \param[out] ok True if the name is known.
+     *
+     */
+    static Format format(const QString &name, bool &ok);
+
+  private:
+    /** \brief Returns the given field quoted for CSV if needed.
+     * \param[in] field Field text.
+     *
+     */
+    static QString csvField(const QString &field);
+
+    QIODevice   *m_device;  /** output device.                    */
+    const Format m_format;  /** output format.                    */
+    const bool   m_changes; /** true to write the group changes.  */
+    int          m_groups;  /** number of groups written.         */
+};
+
+#endif // RESULTWRITER_H_
@@ -0,0 +1,345 @@
+/*
+ File: ScanIndex.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ScanIndex.h"
+#include "Hasher.h"
+
+// Qt
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// C++
+#include <cstring>
+#include <limits>
+
+const quint32 ScanIndex::MAGIC;
+const quint32 ScanIndex::VERSION;
+
+//--------------------------------------------------------------------
+ScanIndex::ScanIndex(const QStringList& roots, const bool details, const quint64 rules)
+: m_root   {rootKey(roots)}
+, m_details{details}
+, m_rules  {rules}
+, m_started{0}
+, m_data   {nullptr}
+{
+  clear();
+}
+
+//--------------------------------------------------------------------
+ScanIndex::~ScanIndex()
+{
+  clear();
+}
+
+//--------------------------------------------------------------------
+bool ScanIndex::load(const QString& fileName)
+{
+  clear();
+
+  m_file.setFileName(fileName);
+  if(!m_file.open(QIODevice::ReadOnly)) return false;
+
+  const auto size = static_cast<quint64>(m_file.size());
+  if(size >= sizeof(Header)) m_data = m_file.map(0, m_file.size());
+
+  if(!m_data)
+  {
+    clear();
+    return false;
+  }
+
+  std::memcpy(&m_header, m_data, sizeof(Header));
+
+  // the sections follow each other, anything else is another version or a damaged file.
+  const auto &header = m_header;
+  const auto root    = m_root.toUtf8();
+  auto valid = header.magic == MAGIC && header.version == VERSION &&
+               header.root == static_cast<quint64>(root.size()) && header.root <= header.names && header.names <= std::numeric_limits<quint32>::max() &&
+               header.records < std::numeric_limits<quint32>::max() && header.buckets > header.records && (header.buckets & (header.buckets - 1)) == 0 &&
+               header.entries == (sizeof(Header) + header.names + 7) / 8 * 8 &&
+               header.linked == header.entries + header.records * sizeof(Entry) &&
+               header.table == header.linked + header.links * sizeof(DirectoryEnumerator::Link) &&
+               header.table + header.buckets * sizeof(quint32) == size;
+
+  // an index without the file signatures can't be used for a scan that needs them, and the
+  // listings of other exclusion rules may lack directories or have excluded ones.
+  valid = valid && std::memcmp(m_data + sizeof(Header), root.constData(), root.size()) == 0 && (!m_details || header.details) && header.rules == m_rules;
+
+  if(!valid)
+  {
+    clear();
+    return false;
+  }
+
+  m_started = header.started;
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+bool ScanIndex::save(const QString& fileName) const
+{
+  QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+  QSaveFile file{fileName};
+  if(!file.open(QIODevice::WriteOnly)) return false;
+
+  // the table is at most half full, so the lookups seldom probe more than one bucket.
+  quint64 buckets = 2;
+  while(buckets < 2 * static_cast<quint64>(m_records.size())) buckets *= 2;
+
+  QVector<quint32> table(static_cast<int>(buckets), 0);
+  for(int i = 0; i < m_hashes.size(); ++i)
+  {
+    auto bucket = m_hashes.at(i) & (buckets - 1);
+    while(table.at(static_cast<int>(bucket)) != 0) bucket = (bucket + 1) & (buckets - 1);
+
+    table[static_cast<int>(bucket)] = static_cast<quint32>(i + 1);
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  header.magic   = MAGIC;
+  header.version = VERSION;
+  header.details = m_details ? 1 : 0;
+  header.rules   = m_rules;
+  header.started = m_started;
+  header.root    = static_cast<quint64>(m_root.toUtf8().size());
+  header.records = static_cast<quint64>(m_records.size());
+  header.buckets = buckets;
+  header.names   = static_cast<quint64>(m_names.size());
+  header.entries = (sizeof(Header) + header.names + 7) / 8 * 8;
+  header.links   = static_cast<quint64>(m_links.size());
+  header.linked  = header.entries + header.records * sizeof(Entry);
+  header.table   = header.linked + header.links * sizeof(DirectoryEnumerator::Link);
+
+  // the records are aligned so they can be read in place from the map.
+  const auto padding = static_cast<int>(header.entries - sizeof(Header) - header.names);
+  const auto records = static_cast<qint64>(m_records.size() * sizeof(Entry));
+  const auto links   = static_cast<qint64>(m_links.size() * sizeof(DirectoryEnumerator::Link));
+  const auto bucketBytes = static_cast<qint64>(table.size() * sizeof(quint32));
+
+  auto ok = file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == sizeof(Header);
+  ok &= file.write(m_names) == m_names.size();
+  ok &= file.write(QByteArray(padding, '\0')) == padding;
+  ok &= file.write(reinterpret_cast<const char *>(m_records.constData()), records) == records;
+  ok &= file.write(reinterpret_cast<const char *>(m_links.constData()), links) == links;
+  ok &= file.write(reinterpret_cast<const char *>(table.constData()), bucketBytes) == bucketBytes;
+
+  return ok && file.commit();
+}
+
+//--------------------------------------------------------------------
+const ScanIndex::Entry* ScanIndex::find(const QString& path) const
+{
+  if(!m_data) return nullptr;
+
+  const auto key   = relative(path).toUtf8();
+  const auto table = reinterpret_cast<const quint32 *>(m_data + m_header.table);
+  const auto mask  = m_header.buckets - 1;
+
+  for(auto bucket = Hasher::hash(key.constData(), key.size()) & mask; table[bucket] != 0; bucket = (bucket + 1) & mask)
+  {
+    const auto number = table[bucket];
+    if(number > m_header.records || !matches(number, key)) continue;
+
+    const auto &entry = record(number);
+
+    return entry.listed ? &entry : nullptr;
+  }
+
+  return nullptr;
+}
+
+//--------------------------------------------------------------------
+bool ScanIndex::directories(const Entry& entry, QStringList& names) const
+{
+  names.clear();
+  if(!m_data || entry.count == 0) return true;
+
+  const auto number = static_cast<quint32>(&entry - &record(1)) + 1;
+  if(entry.children <= number || entry.children - 1 + static_cast<quint64>(entry.count) > m_header.records) return false;
+
+  QStringList result;
+  result.reserve(static_cast<int>(entry.count));
+  for(quint32 i = entry.children; i < entry.children + entry.count; ++i)
+  {
+    const auto &child = record(i);
+    if(child.parent != number || static_cast<quint64>(child.name) + child.length > m_header.names) return false;
+
+    result << QString::fromUtf8(name(child), static_cast<int>(child.length));
+  }
+
+  names = result;
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+bool ScanIndex::links(const Entry& entry, QVector<DirectoryEnumerator::Link>& links) const
+{
+  links.clear();
+  if(!m_data || entry.linkCount == 0) return true;
+
+  if(static_cast<quint64>(entry.links) + entry.linkCount > m_header.links) return false;
+
+  const auto first = reinterpret_cast<const DirectoryEnumerator::Link *>(m_data + m_header.linked) + entry.links;
+  links.reserve(static_cast<int>(entry.linkCount));
+  for(quint32 i = 0; i < entry.linkCount; ++i)
+  {
+    links << first[i];
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+quint32 ScanIndex::add(const QString& path, const quint32 parent, const Entry& entry, const QVector<DirectoryEnumerator::Link>& links)
+{
+  const auto number = static_cast<quint32>(m_records.size() + 1);
+  const auto key    = relative(path).toUtf8();
+
+  // top-level entries keep their relative path, the rest only their name.
+  const auto directoryName = parent == 0 ? key : key.mid(key.lastIndexOf('/') + 1);
+
+  auto added = entry;
+  added.parent   = parent;
+  added.children = 0;
+  added.count    = 0;
+  added.name     = static_cast<quint32>(m_names.size());
+  added.length   = static_cast<quint32>(directoryName.size());
+  added.links    = static_cast<quint32>(m_links.size());
+  added.linkCount = static_cast<quint32>(links.size());
+  added.padding  = 0;
+  if(!m_details) added.files = 0;
+
+  if(parent != 0)
+  {
+    auto &parentRecord = m_records[static_cast<int>(parent - 1)];
+    if(parentRecord.count == 0) parentRecord.children = number;
+    ++parentRecord.count;
+  }
+
+  m_records << added;
+  m_links   << links;
+  m_hashes  << Hasher::hash(key.constData(), key.size());
+  m_names.append(directoryName);
+
+  return number;
+}
+
+//--------------------------------------------------------------------
+qint64 ScanIndex::bytes() const
+{
+  qint64 result = 0;
+  for(int i = 1; i <= size(); ++i)
+  {
+    const auto &entry = m_data ? record(static_cast<quint32>(i)) : m_records.at(i - 1);
+    result += entry.bytes;
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+void ScanIndex::clear()
+{
+  if(m_data) m_file.unmap(m_data);
+  m_data = nullptr;
+
+  if(m_file.isOpen()) m_file.close();
+
+  std::memset(&m_header, 0, sizeof(Header));
+
+  m_records.clear();
+  m_links.clear();
+  m_hashes.clear();
+  m_names = m_root.toUtf8();
+}
+
+//--------------------------------------------------------------------
+QString ScanIndex::defaultFile(const QStringList& roots)
+{
+  return dataFile(roots, "index");
+}
+
+//--------------------------------------------------------------------
+QString ScanIndex::checkpointFile(const QStringList& roots)
+{
+  return dataFile(roots, "checkpoint");
+}
+
+//--------------------------------------------------------------------
+QString ScanIndex::resultsFile(const QStringList& roots)
+{
+  return dataFile(roots, "results");
+}
+
+//--------------------------------------------------------------------
+QString ScanIndex::dataFile(const QStringList& roots, const QString& prefix)
+{
+  QStringList absolutePaths;
+  for(const auto &root: roots) absolutePaths << QDir(root).absolutePath();
+
+  const auto path = QFile::encodeName(absolutePaths.join('\n'));
+  const auto name = QString("%1-%2.dat").arg(prefix).arg(Hasher::hash(path.constData(), path.size()), 16, 16, QChar('0'));
+
+  return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/" + name;
+}
+
+//--------------------------------------------------------------------
+QString ScanIndex::rootKey(const QStringList& roots)
+{
+  QStringList result;
+  for(const auto &root: roots) result << (root.endsWith('/') ? root : root + "/");
+
+  return result.join('\n');
+}
+
+//--------------------------------------------------------------------
+bool ScanIndex::matches(quint32 number, const QByteArray& path) const
+{
+  // the path is compared from its last name up to the top-level entry, parents come first.
+  auto end = path.size();
+  while(true)
+  {
+    const auto &entry = record(number);
+    if(static_cast<quint64>(entry.name) + entry.length > m_header.names || entry.length > static_cast<quint32>(end)) return false;
+
+    const auto start = end - static_cast<int>(entry.length);
+    if(std::memcmp(path.constData() + start, name(entry), entry.length) != 0) return false;
+
+    if(entry.parent == 0) return start == 0;
+    if(entry.parent >= number || start == 0 || path.at(start - 1) != '/') return false;
+
+    end    = start - 1;
+    number = entry.parent;
+  }
+}
+
+//--------------------------------------------------------------------
+QString ScanIndex::relative(const QString& path) const
+{
+  // the key of several folders has new lines, so their paths are kept absolute.
+  return path.startsWith(m_root) ? path.mid(m_root.size()) : path;
+}
@@ -0,0 +1,269 @@
+/*
+ File: ScanIndex.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANINDEX_H_
+#define SCANINDEX_H_
+
+// Project
+#include "DirectoryEnumerator.h"
+
+// Qt
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/** \class ScanIndex
+ * \brief On-disk index of a previous scan. Keeps the listing of every directory along its
+ *        modification time, so the next scan of the same folder can reuse the directories
+ *        that haven't changed instead of listing them again. The file has a header, the UTF-8
+ *        names of the directories, fixed-width records of the directories in breadth-first
+ *        order, so the subdirectories of a directory are consecutive records, the hard linked
+ *        files of the directories and a hash table of the records by relative path. Records only keep the name of the directory and the
+ *        number of its parent, the paths and the listings are rebuilt from them. A loaded index
+ *        is read through a memory map, so it costs little memory whatever its size. Paths are
+ *        relative to the scanned folder, or absolute in the index of a scan of several folders.
+ *
+ */
+class ScanIndex
+{
+  public:
+    /** \struct Entry
+     * \brief Record of a directory in the index.
+     *
+     */
+    struct Entry
+    {
+      qint64  modified;  /** directory modification time when it was listed.        */
+      qint64  bytes;     /** total size of its files in bytes.                      */
+      quint64 files;     /** signature of its files, only with details.             */
+      quint64 device;    /** file system of the directory, 0 if unknown.            */
+      quint64 inode;     /** inode of the directory, 0 if unknown.                  */
+      qint32  subdirectories; /** subdirectories from its link count when listed, -1 if unknown. */
+      quint32 listed;    /** 1 if the directory was listed, 0 if only its name is known. */
+      quint32 parent;    /** number of the parent directory, 0 for top-level entries. */
+      quint32 children;  /** number of its first subdirectory, they are consecutive. */
+      quint32 count;     /** number of subdirectories.                              */
+      quint32 name;      /** offset of its name in the names.                       */
+      quint32 length;    /** bytes of its name.                                     */
+      quint32 links;     /** number of its first hard linked file, they are consecutive. */
+      quint32 linkCount; /** number of hard linked files.                           */
+      quint32 padding;   /** unused.                                                */
+
+      Entry(): modified{0}, bytes{0}, files{0}, device{0}, inode{0}, subdirectories{-1}, listed{0}, parent{0}, children{0}, count{0}, name{0}, length{0}, links{0}, linkCount{0}, padding{0} {};
+    };
+
+    /** \brief ScanIndex class constructor.
+     * \param[in] roots Absolute paths of the scanned folders.
+     * \param[in] details True if the entries have the signatures of the files.
+     * \param[in] rules Fingerprint of the exclusion rules that removed directories from the listings.
+     *
+     */
+    ScanIndex(const QStringList &roots, const bool details, const quint64 rules);
+
+    /** \brief ScanIndex class destructor.
+     *
+     */
+    ~ScanIndex();
+
+    ScanIndex(const ScanIndex &) = delete;
+    ScanIndex &operator=(const ScanIndex &) = delete;
+
+    /** \brief Maps the index of the given file and returns true on success. Files of other
+     *        folders, of scans without the same details or exclusion rules or of another
+     *        version are ignored.
+     * \param[in] fileName Index file name.
+     *
+     */
+    bool load(const QString &fileName);
+
+    /** \brief Writes the added directories to the given file, replacing it atomically, and
+     *        returns true on success.
+     * \param[in] fileName Index file name.
+     *
+     */
+    bool save(const QString &fileName) const;
+
+    /** \brief Returns the entry of the given listed directory of the loaded index or nullptr if
+     *        it's not in the index. It's safe to call it from several threads.
+     * \param[in] path Directory absolute path.
+     *
+     */
+    const Entry *find(const QString &path) const;
+
+    /** \brief Gets the names of the subdirectories of the given entry of the loaded index in
+     *        listing order, and returns false if the records don't match the entry.
+     * \param[in] entry Directory entry.
+     * \param[out] names Subdirectory names.
+     *
+     */
+    bool directories(const Entry &entry, QStringList &names) const;
+
+    /** \brief Gets the hard linked files of the given entry of the loaded index and returns false
+     *        if the records don't match the entry.
+     * \param[in] entry Directory entry.
+     * \param[out] links Files with several hard links.
+     *
+     */
+    bool links(const Entry &entry, QVector<DirectoryEnumerator::Link> &links) const;
+
+    /** \brief Adds a directory to the index being written and returns its number. Directories
+     *        must be added in breadth-first order, each one after its parent and the
+     *        subdirectories of a directory one after another in listing order.
+     * \param[in] path Directory absolute path.
+     * \param[in] parent Number of the parent directory, 0 for top-level entries.
+     * \param[in] entry Directory listing, its structure fields are ignored.
+     * \param[in] links Files of the directory with several hard links.
+     *
+     */
+    quint32 add(const QString &path, const quint32 parent, const Entry &entry, const QVector<DirectoryEnumerator::Link> &links);
+
+    /** \brief Sets the time the scan of the index started, in nanoseconds since the epoch.
+     * \param[in] time Scan start time.
+     *
+     */
+    void setStarted(const qint64 time)
+    { m_started = time; }
+
+    /** \brief Returns the time the scan of the index started, in nanoseconds since the epoch.
+     *
+     */
+    qint64 started() const
+    { return m_started; }
+
+    /** \brief Returns the number of directories in the index.
+     *
+     */
+    int size() const
+    { return static_cast<int>(m_data ? m_header.records : m_records.size()); }
+
+    /** \brief Returns the total size of the files of the directories in the index.
+     *
+     */
+    qint64 bytes() const;
+
+    /** \brief Unmaps the loaded index and removes the added directories.
+     *
+     */
+    void clear();
+
+    /** \brief Returns the default index file name of the given folders, in the application
+     *        data directory.
+     * \param[in] roots Absolute paths of the scanned folders.
+     *
+     */
+    static QString defaultFile(const QStringList &roots);
+
+    /** \brief Returns the default checkpoint file name of the given folders, in the application
+     *        data directory. A checkpoint is an index of the directories listed by an interrupted scan.
+     * \param[in] roots Absolute paths of the scanned folders.
+     *
+     */
+    static QString checkpointFile(const QStringList &roots);
+
+    /** \brief Returns the default results file name of the given folders, in the application
+     *        data directory. See ResultFile.
+     * \param[in] roots Absolute paths of the scanned folders.
+     *
+     */
+    static QString resultsFile(const QStringList &roots);
+
+  private:
+    /** \struct Header
+     * \brief Start of the file, offsets are in bytes from the start of the file.
+     *
+     */
+    struct Header
+    {
+      quint32 magic;    /** index files magic number.              */
+      quint32 version;  /** index files version.                   */
+      quint32 details;  /** 1 if the entries have files signatures. */
+      quint32 padding;  /** unused.                                */
+      quint64 rules;    /** exclusion rules fingerprint.           */
+      qint64  started;  /** scan start time.                       */
+      quint64 root;     /** bytes of the scanned folders key, the start of the names. */
+      quint64 records;  /** number of directory records.           */
+      quint64 buckets;  /** number of hash table buckets, a power of two. */
+      quint64 names;    /** bytes of the names.                    */
+      quint64 links;    /** number of hard linked file records.    */
+      quint64 entries;  /** offset of the directory records.       */
+      quint64 linked;   /** offset of the hard linked file records. */
+      quint64 table;    /** offset of the hash table.              */
+    };
+
+    /** \brief Returns the key of the given path, relative to the root.
+     * \param[in] path Directory absolute path.
+     *
+     */
+    QString relative(const QString &path) const;
+
+    /** \brief Returns the record of the given directory number of the loaded index.
+     * \param[in] number Directory number.
+     *
+     */
+    const Entry &record(const quint32 number) const
+    { return reinterpret_cast<const Entry *>(m_data + m_header.entries)[number - 1]; }
+
+    /** \brief Returns the name of the given record of the loaded index.
+     * \param[in] entry Directory record.
+     *
+     */
+    const char *name(const Entry &entry) const
+    { return reinterpret_cast<const char *>(m_data + sizeof(Header)) + entry.name; }
+
+    /** \brief Returns true if the given record of the loaded index is the directory of the given
+     *        relative path.
+     * \param[in] number Directory number.
+     * \param[in] path Relative path in UTF-8.
+     *
+     */
+    bool matches(quint32 number, const QByteArray &path) const;
+
+    /** \brief Returns the name of a file of the given folders in the application data directory.
+     * \param[in] roots Absolute paths of the scanned folders.
+     * \param[in] prefix File name prefix.
+     *
+     */
+    static QString dataFile(const QStringList &roots, const QString &prefix);
+
+    /** \brief Returns the key of the given folders stored in the index, the folder with a trailing
+     *        separator or the folders separated by new lines.
+     * \param[in] roots Absolute paths of the scanned folders.
+     *
+     */
+    static QString rootKey(const QStringList &roots);
+
+    static const quint32 MAGIC   = 0x44555049; /** index files magic number. */
+    static const quint32 VERSION = 8;          /** index files version.      */
+
+    const QString    m_root;    /** scanned folders key, see rootKey().        */
+    const bool       m_details; /** true if the entries have files signatures. */
+    const quint64    m_rules;   /** exclusion rules fingerprint.               */
+    qint64           m_started; /** scan start time.                           */
+    QFile            m_file;    /** loaded index file.                         */
+    uchar           *m_data;    /** map of the loaded index, nullptr if none.  */
+    Header           m_header;  /** header of the loaded index.                */
+    QVector<Entry>   m_records; /** added directories.                         */
+    QVector<DirectoryEnumerator::Link> m_links; /** hard linked files of the added directories. */
+    QVector<quint64> m_hashes;  /** relative path hashes of the added directories. */
+    QByteArray       m_names;   /** names of the added directories.            */
+};
+
+#endif // SCANINDEX_H_
@@ -0,0 +1,322 @@
+/*
+ File: ScanStatistics.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ScanStatistics.h"
+
+// Qt
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+const int ScanStatistics::PHASES;
+
+//--------------------------------------------------------------------
+double ScanStatistics::Snapshot::directoriesPerSecond() const
+{
+  const auto traversal = phases[static_cast<int>(Phase::TRAVERSAL)];
+
+  return traversal > 0 ? directories * 1e9 / traversal : 0.;
+}
+
+//--------------------------------------------------------------------
+double ScanStatistics::Snapshot::filesPerSecond() const
+{
+  const auto traversal = phases[static_cast<int>(Phase::TRAVERSAL)];
+
+  return traversal > 0 ? files * 1e9 / traversal : 0.;
+}
+
+//--------------------------------------------------------------------
+double ScanStatistics::Snapshot::bytesPerNode(const bool pointers) const
+{
+  return nodes > 0 ? static_cast<double>(pointers ? pointerBytes : treeBytes) / nodes : 0.;
+}
+
+//--------------------------------------------------------------------
+QJsonObject ScanStatistics::Snapshot::toJson() const
+{
+  QJsonObject times;
+  for(int i = 0; i < PHASES; ++i)
+  {
+    times.insert(QString(name(static_cast<Phase>(i))), phases[i] / 1e6);
+  }
+
+  QJsonObject object;
+  object.insert("elapsed",              elapsed / 1e6);
+  object.insert("phases",               times);
+  object.insert("directories",          directories);
+  object.insert("files",                files);
+  object.insert("directoriesPerSecond", directoriesPerSecond());
+  object.insert("filesPerSecond",       filesPerSecond());
+  object.insert("reused",               reused);
+  object.insert("aliases",              aliases);
+  object.insert("lists",                lists);
+  object.insert("failures",             failures);
+  object.insert("syscalls",             syscalls);
+  object.insert("stats",                stats);
+  object.insert("filesHashed",          filesHashed);
+  object.insert("bytesHashed",          bytesHashed);
+  object.insert("batches",              batches);
+  object.insert("loadFactor",           loadFactor);
+  object.insert("probes",               probes);
+  object.insert("nodes",                nodes);
+  object.insert("treeBytes",            treeBytes);
+  object.insert("bytesPerNode",         bytesPerNode());
+  object.insert("pointerBytesPerNode",  bytesPerNode(true));
+  object.insert("throttled",            throttled / 1e6);
+
+  return object;
+}
+
+//--------------------------------------------------------------------
+ScanStatistics::ScanStatistics(const int workers, const bool trace)
+: m_count     {workers}
+, m_trace     {trace}
+, m_workers   {new Worker[workers]}
+, m_busy      {new qint64[workers]}
+, m_loadFactor{0.}
+, m_probes    {0.}
+, m_nodes     {0}
+, m_treeBytes {0}
+, m_pointerBytes{0}
+{
+  m_timer.start();
+
+  for(int i = 0; i < PHASES; ++i)
+  {
+    m_started[i] = -1;
+    m_spent[i]   = 0;
+  }
+
+  for(int i = 0; i < workers; ++i)
+  {
+    m_busy[i] = -1;
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::begin(const Phase phase)
+{
+  m_started[static_cast<int>(phase)] = m_timer.nsecsElapsed();
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::end(const Phase phase)
+{
+  const auto i = static_cast<int>(phase);
+  const auto started = m_started[i].exchange(-1);
+  if(started < 0) return;
+
+  const auto duration = m_timer.nsecsElapsed() - started;
+  m_spent[i] += duration;
+
+  if(m_trace) record(Event{name(phase), 0, started, duration, QJsonObject()});
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::setBusy(const int index, const bool busy)
+{
+  if(!m_trace || (m_busy[index] >= 0) == busy) return;
+
+  const auto now = m_timer.nsecsElapsed();
+  if(busy)
+  {
+    m_busy[index] = now;
+  }
+  else
+  {
+    record(Event{"busy", index + 1, m_busy[index], now - m_busy[index], QJsonObject()});
+    m_busy[index] = -1;
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::addHashed(const qint64 files, const qint64 bytes)
+{
+  m_filesHashed.add(files);
+  m_bytesHashed.add(bytes);
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::setIndex(const double loadFactor, const double probes)
+{
+  m_loadFactor = loadFactor;
+  m_probes     = probes;
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::setTree(const qint64 nodes, const qint64 bytes, const qint64 pointerBytes)
+{
+  m_nodes        = nodes;
+  m_treeBytes    = bytes;
+  m_pointerBytes = pointerBytes;
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::sample()
+{
+  if(!m_trace) return;
+
+  const auto current = snapshot();
+
+  QJsonObject values;
+  values.insert("directories", current.directories);
+  values.insert("files",       current.files);
+  values.insert("syscalls",    current.syscalls);
+
+  record(Event{"progress", 0, current.elapsed, -1, values});
+}
+
+//--------------------------------------------------------------------
+ScanStatistics::Snapshot ScanStatistics::snapshot() const
+{
+  Snapshot result;
+  result.elapsed = m_timer.nsecsElapsed();
+
+  for(int i = 0; i < PHASES; ++i)
+  {
+    const auto started = m_started[i].load();
+    result.phases[i] = m_spent[i] + (started >= 0 ? result.elapsed - started : 0);
+  }
+
+  result.directories = result.files = result.reused = result.aliases = result.lists = result.failures = result.syscalls = result.stats = 0;
+  for(int i = 0; i < m_count; ++i)
+  {
+    const auto &worker = m_workers[i];
+    result.directories += worker.directories.value();
+    result.files       += worker.files.value();
+    result.reused      += worker.reused.value();
+    result.aliases     += worker.aliases.value();
+    result.lists       += worker.enumeration.lists.value();
+    result.failures    += worker.enumeration.failures.value();
+    result.syscalls    += worker.enumeration.syscalls.value();
+    result.stats       += worker.enumeration.stats.value();
+  }
+
+  result.filesHashed = m_filesHashed.value();
+  result.bytesHashed = m_bytesHashed.value();
+  result.batches     = m_batches.value();
+  result.loadFactor  = m_loadFactor;
+  result.probes      = m_probes;
+  result.nodes       = m_nodes;
+  result.treeBytes   = m_treeBytes;
+  result.pointerBytes = m_pointerBytes;
+  result.throttled   = 0;
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+bool ScanStatistics::writeTrace(const QString& fileName) const
+{
+  QJsonArray events;
+
+  auto metadata = [&events](const int thread, const QString &threadName)
+  {
+    QJsonObject args;
+    args.insert("name", threadName);
+
+    QJsonObject event;
+    event.insert("name", "thread_name");
+    event.insert("ph",   "M");
+    event.insert("pid",  1);
+    event.insert("tid",  thread);
+    event.insert("args", args);
+
+    events.append(event);
+  };
+
+  metadata(0, "Scan");
+  for(int i = 0; i < m_count; ++i)
+  {
+    metadata(i + 1, QString("Worker %1").arg(i));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(const auto &recorded: m_events)
+    {
+      // trace times are in microseconds.
+      QJsonObject event;
+      event.insert("name", recorded.name);
+      event.insert("pid",  1);
+      event.insert("tid",  recorded.thread);
+      event.insert("ts",   recorded.start / 1e3);
+
+      if(recorded.duration >= 0)
+      {
+        event.insert("ph",  "X");
+        event.insert("dur", recorded.duration / 1e3);
+      }
+      else
+      {
+        event.insert("ph",   "C");
+        event.insert("args", recorded.values);
+      }
+
+      events.append(event);
+    }
+  }
+
+  QJsonObject trace;
+  trace.insert("traceEvents",     events);
+  trace.insert("displayTimeUnit", "ms");
+
+  QFile file{fileName};
+  if(!file.open(QIODevice::WriteOnly|QIODevice::Truncate)) return false;
+
+  const auto data = QJsonDocument(trace).toJson(QJsonDocument::Compact);
+
+  return file.write(data) == data.size();
+}
+
+//--------------------------------------------------------------------
+const char* ScanStatistics::name(const Phase phase)
+{
+  switch(phase)
+  {
+    case Phase::LOAD_INDEX:   return "load index";
+    case Phase::TRAVERSAL:    return "traversal";
+    case Phase::SAVE_INDEX:   return "save index";
+    case Phase::MATCH:        return "match";
+    case Phase::VERIFICATION: return "verification";
+    case Phase::REFRESH:      return "refresh";
+    case Phase::ESTIMATE:     return "estimate";
+  }
+
+  return "unknown";
+}
+
+//--------------------------------------------------------------------
+QString ScanStatistics::duration(const qint64 milliseconds)
+{
+  const auto seconds = (milliseconds + 500) / 1000;
+
+  return QString("%1:%2:%3").arg(seconds / 3600)
+                            .arg((seconds / 60) % 60, 2, 10, QChar('0'))
+                            .arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+//--------------------------------------------------------------------
+void ScanStatistics::record(Event&& event)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_events << event;
+}
@@ -0,0 +1,258 @@
+/*
+ File: ScanStatistics.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANSTATISTICS_H_
+#define SCANSTATISTICS_H_
+
+// Project
+#include "Counter.h"
+#include "DirectoryEnumerator.h"
+
+// Qt
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QVector>
+#include <QString>
+
+// C++
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/** \class ScanStatistics
+ * \brief Performance statistics of a scan. Each traversal worker counts in its own counters,
+ *        padded so they don't share cache lines, and the snapshots add them up when asked,
+ *        so they can be taken from any thread while the scan runs. Optionally the phases and
+ *        the busy periods of the workers are recorded as trace events that can be written in
+ *        the Chrome trace format and opened in chrome://tracing or Perfetto.
+ *
+ */
+class ScanStatistics
+{
+  public:
+    /** \brief Scan phases.
+     *
+     */
+    enum class Phase: char
+    {
+      LOAD_INDEX   = 0, /** reading the index of the previous scan.             */
+      TRAVERSAL    = 1, /** listing the tree and rolling up the directories.    */
+      SAVE_INDEX   = 2, /** writing the scan index.                             */
+      MATCH        = 3, /** grouping and reporting the duplicates.              */
+      VERIFICATION = 4, /** comparing the contents of the files, during MATCH.  */
+      REFRESH      = 5, /** updating the tree after changes, in watch mode.     */
+      ESTIMATE     = 6  /** estimating the size of the tree for the progress.   */
+    };
+
+    static const int PHASES = 7; /** number of phases. */
+
+    /** \struct Worker
+     * \brief Counters of a traversal worker, only written by its thread.
+     *
+     */
+    struct Worker
+    {
+      Counter                       directories; /** directories processed.                  */
+      Counter                       files;       /** files found in them.                    */
+      Counter                       reused;      /** directories taken from the index.       */
+      Counter                       aliases;     /** directories already seen by another path. */
+      DirectoryEnumerator::Counters enumeration; /** file system operations.                 */
+      char                          padding[64]; /** keeps workers in different cache lines. */
+    };
+
+    /** \struct Snapshot
+     * \brief Statistics at some point of the scan. Times are in nanoseconds.
+     *
+     */
+    struct Snapshot
+    {
+      qint64 elapsed;        /** time since the scan started.                          */
+      qint64 phases[PHASES]; /** time spent in each phase, including the running ones. */
+      qint64 directories;    /** directories processed.                                */
+      qint64 files;          /** files found.                                          */
+      qint64 reused;         /** directories taken from the scan index.                */
+      qint64 aliases;        /** directories left empty, already seen by another path. */
+      qint64 lists;          /** directories listed.                                   */
+      qint64 failures;       /** directories that couldn't be listed completely.       */
+      qint64 syscalls;       /** system calls made by the enumerators.                 */
+      qint64 stats;          /** stat calls made by the enumerators.                   */
+      qint64 filesHashed;    /** files hashed to verify their contents.                */
+      qint64 bytesHashed;    /** bytes read to hash them.                              */
+      qint64 batches;        /** duplicate batches emitted.                            */
+      double loadFactor;     /** average load factor of the directories table shards.  */
+      double probes;         /** average slots visited by a directories table lookup.  */
+      qint64 nodes;          /** directories of the scanned tree.                      */
+      qint64 treeBytes;      /** memory of the scanned tree, nodes and child links.    */
+      qint64 pointerBytes;   /** memory the tree would take linked by pointers and a list of children per node. */
+      qint64 throttled;      /** time slept by the background mode limits.             */
+
+      /** \brief Returns the number of directories processed per second of traversal.
+       *
+       */
+      double directoriesPerSecond() const;
+
+      /** \brief Returns the number of files found per second of traversal.
+       *
+       */
+      double filesPerSecond() const;
+
+      /** \brief Returns the memory of the scanned tree per directory, in bytes.
+       * \param[in] pointers True to use the memory of the tree linked by pointers instead.
+       *
+       */
+      double bytesPerNode(const bool pointers = false) const;
+
+      /** \brief Returns the snapshot as a JSON object, with the times in milliseconds.
+       *
+       */
+      QJsonObject toJson() const;
+    };
+
+    /** \brief ScanStatistics class constructor.
+     * \param[in] workers Number of traversal workers.
+     * \param[in] trace True to record trace events.
+     *
+     */
+    ScanStatistics(const int workers, const bool trace);
+
+    /** \brief Returns the counters of the given worker. Worker 0 runs in the scan thread, so its
+     *        counters are also used for the work done there outside the traversal.
+     * \param[in] index Worker index.
+     *
+     */
+    Worker &worker(const int index)
+    { return m_workers[index]; }
+
+    /** \brief Marks the start of the given phase. Only called from the scan thread.
+     * \param[in] phase Scan phase.
+     *
+     */
+    void begin(const Phase phase);
+
+    /** \brief Marks the end of the given phase. Only called from the scan thread.
+     * \param[in] phase Scan phase.
+     *
+     */
+    void end(const Phase phase);
+
+    /** \brief Marks the given worker busy or idle, recording its busy periods in the trace.
+     * \param[in] index Worker index.
+     * \param[in] busy True if the worker starts processing directories, false if it runs out of them.
+     *
+     */
+    void setBusy(const int index, const bool busy);
+
+    /** \brief Adds the given hashed files. Only called from the scan thread.
+     * \param[in] files Number of files.
+     * \param[in] bytes Number of bytes read.
+     *
+     */
+    void addHashed(const qint64 files, const qint64 bytes);
+
+    /** \brief Counts an emitted duplicates batch. Only called from the scan thread.
+     *
+     */
+    void addBatch()
+    { m_batches.add(); }
+
+    /** \brief Sets the directories table statistics.
+     * \param[in] loadFactor Average load factor of the shards.
+     * \param[in] probes Average number of slots visited by a lookup.
+     *
+     */
+    void setIndex(const double loadFactor, const double probes);
+
+    /** \brief Sets the scanned tree statistics.
+     * \param[in] nodes Number of directories of the tree.
+     * \param[in] bytes Memory of the tree.
+     * \param[in] pointerBytes Memory of the same tree linked by pointers.
+     *
+     */
+    void setTree(const qint64 nodes, const qint64 bytes, const qint64 pointerBytes);
+
+    /** \brief Records the progress counters in the trace.
+     *
+     */
+    void sample();
+
+    /** \brief Returns the current statistics.
+     *
+     */
+    Snapshot snapshot() const;
+
+    /** \brief Writes the recorded trace events to the given file in the Chrome trace JSON format
+     *        and returns true on success.
+     * \param[in] fileName Trace file name.
+     *
+     */
+    bool writeTrace(const QString &fileName) const;
+
+    /** \brief Returns the name of the given phase.
+     * \param[in] phase Scan phase.
+     *
+     */
+    static const char *name(const Phase phase);
+
+    /** \brief Returns the given time as hours, minutes and seconds, like 1:05:09.
+     * \param[in] milliseconds Time in milliseconds.
+     *
+     */
+    static QString duration(const qint64 milliseconds);
+
+  private:
+    /** \struct Event
+     * \brief Trace event, a complete span or a counter sample.
+     *
+     */
+    struct Event
+    {
+      QString     name;     /** event name.                                     */
+      int         thread;   /** trace thread, 0 for phases and i+1 for workers. */
+      qint64      start;    /** start time in nanoseconds.                      */
+      qint64      duration; /** span duration in nanoseconds, -1 for counters.  */
+      QJsonObject values;   /** counter values.                                 */
+    };
+
+    /** \brief Adds the given event to the trace.
+     * \param[in] event Trace event.
+     *
+     */
+    void record(Event &&event);
+
+    const int                 m_count;           /** number of workers.                                 */
+    const bool                m_trace;           /** true to record trace events.                       */
+    QElapsedTimer             m_timer;           /** time since the construction.                       */
+    std::unique_ptr<Worker[]> m_workers;         /** worker counters.                                   */
+    std::unique_ptr<qint64[]> m_busy;            /** start of the busy period of each worker, -1 if idle. */
+    std::atomic<qint64>       m_started[PHASES]; /** start of each running phase, -1 if not running.    */
+    std::atomic<qint64>       m_spent[PHASES];   /** time spent in each phase, finished runs only.      */
+    Counter                   m_filesHashed;     /** files hashed.                                      */
+    Counter                   m_bytesHashed;     /** bytes hashed.                                      */
+    Counter                   m_batches;         /** duplicate batches emitted.                         */
+    std::atomic<double>       m_loadFactor;      /** directories table load factor.                     */
+    std::atomic<double>       m_probes;          /** directories table probes per lookup.               */
+    std::atomic<qint64>       m_nodes;           /** directories of the scanned tree.                   */
+    std::atomic<qint64>       m_treeBytes;       /** memory of the scanned tree.                        */
+    std::atomic<qint64>       m_pointerBytes;    /** memory of the tree linked by pointers.             */
+    mutable std::mutex        m_mutex;           /** protects the trace events.                         */
+    QVector<Event>            m_events;          /** recorded trace events.                             */
+};
+
+#endif // SCANSTATISTICS_H_
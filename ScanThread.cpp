@@ -0,0 +1,2188 @@
+/*
+ File: ScanThread.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ScanThread.h"
+#include "Hasher.h"
+#include "FileHasher.h"
+#include "DirectoryWatcher.h"
+#include "ResultFile.h"
+
+// Qt
+#include <QMutexLocker>
+#include <QPair>
+#include <QFile>
+#include <QSet>
+#include <QHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+
+// C++
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+
+const unsigned long long MEGABYTE{1024*1024};
+
+const quint64 FILE_SEED{0x66696c65};      /** seed of the file names hashes.      */
+const quint64 DIRECTORY_SEED{0x64697273}; /** seed of the directory names hashes. */
+const quint64 CONTENT_SEED{0x636f6e74};   /** seed of the verified groups signatures. */
+
+/** directories modified this close to the start of the previous scan could have changed again
+ *  without changing their modification time, they are always listed again.
+ */
+const qint64 RACY_WINDOW{2000000000LL};
+
+const int    BATCH_SIZE{4096};    /** maximum number of duplicates of a batch.               */
+const qint64 BATCH_INTERVAL{100}; /** maximum time in milliseconds a duplicate is kept back. */
+
+const int    SAMPLES{256};        /** maximum number of random paths of the estimation.      */
+const int    SAMPLE_DEPTH{256};   /** maximum depth of a random path, in case of loops.      */
+const qint64 SAMPLING_TIME{250};  /** maximum time in milliseconds of the estimation.        */
+
+const quint16 UNKNOWN_SUBDIRECTORIES{0xFFFF}; /** link count subdirectories of a node when unknown or too many. */
+
+//--------------------------------------------------------------------
+static quint16 subdirectories(const DirectoryEnumerator::Listing &listing)
+{
+  return listing.subdirectories >= 0 && listing.subdirectories < UNKNOWN_SUBDIRECTORIES ? static_cast<quint16>(listing.subdirectories) : UNKNOWN_SUBDIRECTORIES;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::WorkQueue::push(const quint32 node)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_nodes.push_back(node);
+}
+
+//--------------------------------------------------------------------
+quint32 ScanThread::WorkQueue::pop()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(m_nodes.empty()) return 0;
+
+  auto node = m_nodes.back();
+  m_nodes.pop_back();
+
+  return node;
+}
+
+//--------------------------------------------------------------------
+quint32 ScanThread::WorkQueue::steal()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(m_nodes.empty()) return 0;
+
+  auto node = m_nodes.front();
+  m_nodes.pop_front();
+
+  return node;
+}
+
+//--------------------------------------------------------------------
+ScanThread::ScanThread(const QDir& directory, const ScanOptions &options, QObject* parent)
+: ScanThread(QStringList{directory.absolutePath()}, options, parent)
+{
+}
+
+//--------------------------------------------------------------------
+ScanThread::ScanThread(const QStringList& directories, const ScanOptions &options, QObject* parent)
+: QThread(parent)
+, m_directories{normalize(directories)}
+, m_options   {options}
+, m_devices   (devices(m_directories))
+, m_groups    (schedule(m_devices, options))
+, m_threads   {m_groups.back().first + m_groups.back().workers}
+, m_queues    (m_threads)
+, m_remaining {0}
+, m_inspected {0}
+, m_sleeping  {0}
+, m_reused    {0}
+, m_estimated {0}
+, m_estimatedBytes{0}
+, m_bytes     {0}
+, m_percent   {0}
+, m_throttle  (options.background)
+, m_generation{-1}
+, m_resumed   {0}
+, m_unwatched {0}
+, m_cancelled {false}
+, m_paused    {false}
+, m_holding   {false}
+, m_parked    {0}
+, m_exited    {0}
+, m_complete  {false}
+, m_started   {0}
+, m_fuzzy     (options.fuzzy)
+, m_verified  {0}
+, m_statistics(m_threads, !options.traceFile.isEmpty())
+{
+  qRegisterMetaType<DuplicateGroup>("DuplicateGroup");
+  qRegisterMetaType<DuplicateBatch>("DuplicateBatch");
+}
+
+//--------------------------------------------------------------------
+ScanThread::~ScanThread()
+{
+  clear();
+}
+
+//--------------------------------------------------------------------
+QStringList ScanThread::normalize(const QStringList &directories)
+{
+  QStringList result;
+  for(const auto &directory: directories)
+  {
+    const auto path = QDir(directory).absolutePath();
+    if(!result.contains(path)) result << path;
+  }
+
+  // a directory inside another one is already scanned with it.
+  QStringList paths;
+  for(const auto &path: result)
+  {
+    auto nested = false;
+    for(const auto &other: result)
+    {
+      nested |= (other != path && path.startsWith(other.endsWith('/') ? other : other + "/"));
+    }
+
+    if(!nested) paths << path;
+  }
+
+  return paths;
+}
+
+//--------------------------------------------------------------------
+std::vector<quint64> ScanThread::devices(const QStringList &directories)
+{
+  std::vector<quint64> result;
+  for(const auto &directory: directories)
+  {
+    result.push_back(DirectoryEnumerator::device(directory));
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+std::vector<ScanThread::DeviceGroup> ScanThread::schedule(const std::vector<quint64> &devices, const ScanOptions &options)
+{
+  const auto threads = options.threads > 0 ? options.threads : std::max(1, QThread::idealThreadCount());
+
+  std::vector<DeviceGroup> groups;
+  for(const auto device: devices)
+  {
+    const auto it = std::find_if(groups.cbegin(), groups.cend(), [device](const DeviceGroup &group) { return group.device == device; });
+    if(it != groups.cend()) continue;
+
+    DeviceGroup group;
+    group.device     = device;
+    group.rotational = device != 0 && DirectoryEnumerator::isRotational(device);
+    group.first      = groups.empty() ? 0 : groups.back().first + groups.back().workers;
+    group.workers    = group.rotational ? std::max(1, options.rotationalThreads) : threads;
+
+    groups.push_back(group);
+  }
+
+  // the first worker runs in the scan thread, so there is always one.
+  if(groups.empty()) groups.push_back(DeviceGroup{0, false, 0, threads});
+
+  return groups;
+}
+
+//--------------------------------------------------------------------
+int ScanThread::group(const int root) const
+{
+  int result = 0;
+  while(m_groups[result].device != m_devices[root]) ++result;
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::run()
+{
+  if(!m_directories.isEmpty())
+  {
+    auto enumerator = createEnumerator(m_statistics.worker(0).enumeration);
+
+    m_started = QDateTime::currentMSecsSinceEpoch() * 1000000;
+
+    m_statistics.begin(ScanStatistics::Phase::LOAD_INDEX);
+    loadIndex();
+    m_statistics.end(ScanStatistics::Phase::LOAD_INDEX);
+
+    m_statistics.begin(ScanStatistics::Phase::TRAVERSAL);
+
+    // the top-level directories are spread between the workers of the device of their starting directory.
+    for(int root = 0; root < m_directories.size(); ++root)
+    {
+      const QDir directory{m_directories.at(root)};
+      DirectoryEnumerator::Listing listing;
+      if(!directory.exists() || !directory.isReadable() || !enumerator->list(m_directories.at(root), listing))
+      {
+        qWarning() << "Unable to read the folder" << m_directories.at(root);
+        continue;
+      }
+
+      prune(nullptr, listing);
+
+      // a starting directory reached again from another one, through a bind mount, is scanned once.
+      if(!visit(listing.device, listing.inode)) continue;
+
+      const auto &workers = m_groups[group(root)];
+      for(int i = 0; i < listing.directories.size(); ++i)
+      {
+        const auto node = m_nodes.create(intern(listing.directories.at(i)), 0, static_cast<quint16>(root));
+
+        m_roots << node;
+        m_queues[workers.first + i % workers.workers].push(node);
+      }
+    }
+
+    // without subdirectories there is nothing to traverse, but the scan still finishes as usual.
+    if(!m_roots.isEmpty())
+    {
+      m_statistics.end(ScanStatistics::Phase::TRAVERSAL);
+      m_statistics.begin(ScanStatistics::Phase::ESTIMATE);
+      estimate(*enumerator);
+      m_statistics.end(ScanStatistics::Phase::ESTIMATE);
+      m_statistics.begin(ScanStatistics::Phase::TRAVERSAL);
+
+      m_remaining = m_roots.size();
+
+      std::vector<std::thread> workers;
+      for(int i = 1; i < m_threads; ++i)
+      {
+        workers.emplace_back(&ScanThread::worker, this, i);
+      }
+
+      worker(0);
+
+      for(auto &thread: workers) thread.join();
+
+      if(!m_cancelled) settle();
+    }
+
+    m_statistics.end(ScanStatistics::Phase::TRAVERSAL);
+    m_checkpoint.reset();
+
+    if(m_cancelled)
+    {
+      if(!m_options.checkpointFile.isEmpty() && !writeIndex(m_options.checkpointFile))
+      {
+        qWarning() << "Unable to write the checkpoint" << m_options.checkpointFile;
+      }
+    }
+    else
+    {
+      m_percent = 100;
+      emit progress(100);
+
+      if(!m_options.checkpointFile.isEmpty()) QFile::remove(m_options.checkpointFile);
+
+      indexStatistics();
+      treeStatistics();
+
+      saveIndex();
+
+      match();
+
+      if(m_options.watch && !m_cancelled)
+      {
+        watch();
+        saveIndex();
+      }
+    }
+  }
+
+  clear();
+
+  if(!m_options.traceFile.isEmpty() && !m_statistics.writeTrace(m_options.traceFile))
+  {
+    qWarning() << "Unable to write the trace file" << m_options.traceFile;
+  }
+}
+
+//--------------------------------------------------------------------
+std::unique_ptr<DirectoryEnumerator> ScanThread::createEnumerator(DirectoryEnumerator::Counters &counters) const
+{
+  std::unique_ptr<DirectoryEnumerator> enumerator(DirectoryEnumerator::create(m_options.backend));
+  enumerator->setCounters(&counters);
+  enumerator->setFollowLinks(m_options.rules.followsLinks());
+
+  return enumerator;
+}
+
+//--------------------------------------------------------------------
+bool ScanThread::list(DirectoryEnumerator &enumerator, const QString &path, DirectoryEnumerator::Listing &listing) const
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  const auto result = enumerator.list(path, listing);
+
+  // opening and reading the directory and a stat of each entry.
+  m_throttle.operations(1 + listing.files + listing.directories.size(), timer.nsecsElapsed());
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+bool ScanThread::visit(const quint64 device, const quint64 inode)
+{
+  if(inode == 0) return true;
+
+  auto &shard = m_shards[Hasher::mix(inode ^ device) % SHARDS];
+
+  QMutexLocker lock(&shard.mutex);
+  const auto identity = qMakePair(device, inode);
+  if(shard.inodes.contains(identity)) return false;
+
+  shard.inodes.insert(identity);
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::unvisit(const quint64 device, const quint64 inode)
+{
+  if(inode == 0) return;
+
+  auto &shard = m_shards[Hasher::mix(inode ^ device) % SHARDS];
+
+  QMutexLocker lock(&shard.mutex);
+  shard.inodes.remove(qMakePair(device, inode));
+}
+
+//--------------------------------------------------------------------
+void ScanThread::visitListing(const quint32 index, DirectoryEnumerator::Listing &listing, ScanStatistics::Worker &counters)
+{
+  const auto node = this->node(index);
+
+  // a directory reached again through a bind mount, a symbolic link or a loop is left empty. The
+  // traversal order decides which path lists it first, settle() gives it to the first one in
+  // depth-first order and also the hard linked files.
+  if(!visit(listing.device, listing.inode))
+  {
+    listing.directories.clear();
+    listing.bytes = 0;
+    node->files   = 0;
+    node->shared  = 0;
+    node->alias   = true;
+    counters.aliases.add();
+  }
+  else if(!listing.links.isEmpty())
+  {
+    for(const auto &link: listing.links)
+    {
+      if(!visit(listing.device, link.inode)) node->shared += link.size;
+    }
+
+    std::lock_guard<std::mutex> lock(m_linksMutex);
+    m_links.insert(index, listing.links);
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::worker(const int index)
+{
+  auto &queue = m_queues[index];
+  auto &counters = m_statistics.worker(index);
+
+  auto workers = m_groups.cbegin();
+  while(index >= workers->first + workers->workers) ++workers;
+
+  auto enumerator = createEnumerator(counters.enumeration);
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // the scan thread keeps its priority after the traversal.
+  int generation = -1;
+  auto &priority = index == 0 ? m_generation : generation;
+
+  while(!m_cancelled)
+  {
+    m_throttle.prioritize(priority);
+
+    if(m_paused || m_holding)
+    {
+      m_statistics.setBusy(index, false);
+      park();
+      continue;
+    }
+
+    if(index == 0 && !m_options.checkpointFile.isEmpty() && m_options.checkpointInterval > 0 && timer.elapsed() >= m_options.checkpointInterval * 1000LL)
+    {
+      checkpoint();
+      timer.restart();
+    }
+
+    auto node = queue.pop();
+
+    // work is only stolen inside the group, the other devices keep their own number of requests.
+    for(int i = 1; !node && i < workers->workers; ++i)
+    {
+      node = m_queues[workers->first + (index - workers->first + i) % workers->workers].steal();
+    }
+
+    m_statistics.setBusy(index, node != 0);
+
+    if(node)
+    {
+      processDirectory(node, queue, *enumerator, counters);
+
+      if(--m_remaining == 0)
+      {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idle.notify_all();
+      }
+
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    if(m_remaining == 0) break;
+
+    ++m_sleeping;
+    m_idle.wait_for(lock, std::chrono::milliseconds(5));
+    --m_sleeping;
+  }
+
+  m_statistics.setBusy(index, false);
+
+  std::lock_guard<std::mutex> lock(m_idleMutex);
+  ++m_exited;
+  m_idle.notify_all();
+}
+
+//--------------------------------------------------------------------
+void ScanThread::park()
+{
+  std::unique_lock<std::mutex> lock(m_idleMutex);
+
+  ++m_parked;
+  m_idle.notify_all();
+  m_idle.wait(lock, [this] { return (!m_paused && !m_holding) || m_cancelled; });
+  --m_parked;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::checkpoint()
+{
+  // the other workers are held between directories, so every node is either listed or queued.
+  {
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+
+    m_holding = true;
+    m_idle.notify_all();
+    m_idle.wait(lock, [this] { return m_parked + m_exited == m_threads - 1 || m_cancelled; });
+  }
+
+  if(!m_cancelled && !writeIndex(m_options.checkpointFile))
+  {
+    qWarning() << "Unable to write the checkpoint" << m_options.checkpointFile;
+  }
+
+  std::lock_guard<std::mutex> lock(m_idleMutex);
+  m_holding = false;
+  m_idle.notify_all();
+}
+
+//--------------------------------------------------------------------
+void ScanThread::setPaused(const bool paused)
+{
+  std::lock_guard<std::mutex> lock(m_idleMutex);
+  m_paused = paused;
+  m_idle.notify_all();
+}
+
+//--------------------------------------------------------------------
+void ScanThread::processDirectory(const quint32 index, WorkQueue &queue, DirectoryEnumerator &enumerator, ScanStatistics::Worker &counters)
+{
+  const auto node = this->node(index);
+  DirectoryEnumerator::Listing listing(m_options.signatures());
+  const auto nodePath = path(node);
+
+  // an entry is only taken if the directory hasn't changed since, wasn't changing while listed
+  // and still has the number of subdirectories of its link count then, if the file system counts them.
+  auto unchanged = [&enumerator, &nodePath, &listing](const ScanIndex &index) -> const ScanIndex::Entry *
+  {
+    qint64 modified = 0;
+    int subdirectories = -1;
+    const auto entry = index.find(nodePath);
+    if(!entry || entry->modified > index.started() - RACY_WINDOW || !enumerator.modified(nodePath, modified, subdirectories) || modified != entry->modified) return nullptr;
+
+    if(subdirectories >= 0 && entry->subdirectories >= 0 && subdirectories != entry->subdirectories) return nullptr;
+    if(!index.directories(*entry, listing.directories) || !index.links(*entry, listing.links)) return nullptr;
+
+    listing.subdirectories = subdirectories;
+
+    return entry;
+  };
+
+  // directories listed before a scan was interrupted are taken as they were then.
+  const ScanIndex::Entry *entry = m_checkpoint ? unchanged(*m_checkpoint) : nullptr;
+  if(entry)
+  {
+    ++m_resumed;
+  }
+  else if(m_previous)
+  {
+    entry = unchanged(*m_previous);
+    if(entry) ++m_reused;
+  }
+
+  if(entry)
+  {
+    listing.bytes       = entry->bytes;
+    listing.modified    = entry->modified;
+    listing.device      = entry->device;
+    listing.inode       = entry->inode;
+    node->files         = entry->files;
+    counters.reused.add();
+  }
+  else
+  {
+    // a directory that can't be read to the end is left empty and out of the search.
+    if(!list(enumerator, nodePath, listing))
+    {
+      listing = DirectoryEnumerator::Listing(m_options.signatures());
+      node->failed = true;
+    }
+
+    prune(node, listing);
+    if(m_options.signatures()) node->files = filesSignature(listing);
+
+    counters.files.add(listing.files);
+  }
+
+  visitListing(index, listing, counters);
+
+  counters.directories.add();
+
+  // the subdirectories and their run of the children arena take consecutive indexes.
+  const auto count = static_cast<quint32>(listing.directories.size());
+  if(count > 0)
+  {
+    const auto first = m_nodes.reserve(count);
+    node->children   = m_children.reserve(count);
+    node->count      = count;
+
+    for(quint32 i = 0; i < count; ++i)
+    {
+      m_nodes.construct(first + i, intern(listing.directories.at(i)), index, node->root);
+      m_children.construct(node->children + i, first + i);
+    }
+  }
+
+  node->bytes    = listing.bytes;
+  node->modified = listing.modified;
+  node->device   = listing.device;
+  node->inode    = listing.inode;
+  node->subdirectories = subdirectories(listing);
+  node->listed   = true;
+
+  m_bytes += listing.bytes;
+
+  if(count == 0)
+  {
+    rollUp(node);
+    return;
+  }
+
+  node->pending = static_cast<int>(count);
+  m_remaining += static_cast<int>(count);
+
+  // pushed in reverse so the owner continues with the first child, like the serial scan.
+  for(auto i = count; i > 0; --i)
+  {
+    queue.push(child(node, i - 1));
+  }
+
+  if(m_sleeping > 0) m_idle.notify_all();
+}
+
+//--------------------------------------------------------------------
+void ScanThread::estimate(DirectoryEnumerator &enumerator)
+{
+  qint64 directories = 0, bytes = 0;
+
+  if(m_previous && m_previous->size() > 0)
+  {
+    // trees change little between scans, the previous one is the best guess.
+    directories = m_previous->size();
+    bytes       = m_previous->bytes();
+  }
+  else
+  {
+    // Knuth's estimator: along a random path down the tree the product of the number of
+    // subdirectories of the directories above each level is an unbiased estimate of the
+    // directories of that level. The estimate is the average of several paths.
+    const auto &rules = m_options.rules;
+    std::mt19937 random{static_cast<std::mt19937::result_type>(m_roots.size())};
+
+    QElapsedTimer timer;
+    timer.start();
+
+    double sumDirectories = 0., sumBytes = 0.;
+    int samples = 0;
+    while(samples < SAMPLES && timer.elapsed() < SAMPLING_TIME && !m_cancelled)
+    {
+      auto nodePath = path(node(m_roots.at(random() % m_roots.size())));
+      double width  = m_roots.size();
+
+      for(int level = 1; level <= SAMPLE_DEPTH; ++level)
+      {
+        DirectoryEnumerator::Listing listing;
+        if(!list(enumerator, nodePath, listing)) break;
+
+        sumDirectories += width;
+        sumBytes       += width * listing.bytes;
+
+        auto &names = listing.directories;
+        if(rules.hasSkips())
+        {
+          names.erase(std::remove_if(names.begin(), names.end(), [&rules](const QString &name) { return rules.skips(name); }), names.end());
+        }
+
+        if(names.isEmpty() || (rules.maxDepth() > 0 && level >= rules.maxDepth())) break;
+
+        width    *= names.size();
+        nodePath += "/" + names.at(random() % names.size());
+      }
+
+      ++samples;
+    }
+
+    if(samples > 0)
+    {
+      directories = static_cast<qint64>(sumDirectories / samples);
+      bytes       = static_cast<qint64>(sumBytes / samples);
+    }
+
+    // a deep path can give a huge estimate, but there can't be more directories or bytes than
+    // the file systems have in use.
+    qint64 inodes = 0, used = 0;
+    QSet<quint64> devices;
+    for(int i = 0; i < m_directories.size(); ++i)
+    {
+      qint64 deviceInodes = 0, deviceBytes = 0;
+      if(devices.contains(m_devices[i]) || !DirectoryEnumerator::usage(m_directories.at(i), deviceInodes, deviceBytes)) continue;
+
+      devices.insert(m_devices[i]);
+      inodes += deviceInodes;
+      used   += deviceBytes;
+    }
+
+    if(inodes > 0) directories = std::min(directories, inodes);
+    if(used > 0)   bytes       = std::min(bytes, used);
+  }
+
+  m_estimated      = std::max<qint64>(directories, m_roots.size());
+  m_estimatedBytes = bytes;
+}
+
+//--------------------------------------------------------------------
+double ScanThread::completion() const
+{
+  if(m_percent.load() >= 100) return 1.;
+
+  // the directories found so far are a lower bound of the total.
+  const double done        = m_inspected.load();
+  const double directories = std::max(static_cast<double>(m_estimated.load()), done + m_remaining.load());
+  const auto byDirectories = directories > 0. ? done / directories : 0.;
+
+  const double estimated = m_estimatedBytes.load();
+  const double bytes     = m_bytes.load();
+  const auto byBytes     = estimated > 0. ? bytes / std::max(estimated, bytes) : byDirectories;
+
+  return std::min(1., (byDirectories + byBytes) / 2.);
+}
+
+//--------------------------------------------------------------------
+qint64 ScanThread::remainingTime() const
+{
+  const auto done = completion();
+  if(done >= 1.) return 0;
+  if(done <= 0.) return -1;
+
+  const auto elapsed = m_statistics.snapshot().phases[static_cast<int>(ScanStatistics::Phase::TRAVERSAL)] / 1000000;
+
+  return static_cast<qint64>(elapsed * (1. - done) / done);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::updateProgress()
+{
+  // the percentage only grows, and only up to 99 until the traversal ends.
+  const auto percent = std::min(99, static_cast<int>(100. * completion()));
+
+  auto last = m_percent.load();
+  while(percent > last)
+  {
+    if(m_percent.compare_exchange_weak(last, percent))
+    {
+      emit progress(percent);
+      break;
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+quint64 ScanThread::filesSignature(const DirectoryEnumerator::Listing &listing)
+{
+  quint64 signature = 0;
+  for(int i = 0; i < listing.fileNames.size(); ++i)
+  {
+    const auto &name = listing.fileNames.at(i);
+    const auto element = Hasher::hash(name.constData(), name.size(), FILE_SEED) ^ Hasher::mix(listing.fileSizes.at(i));
+
+    signature += Hasher::mix(element);
+  }
+
+  return signature;
+}
+
+//--------------------------------------------------------------------
+MinHash ScanThread::entriesSketch(const DirectoryEnumerator::Listing &listing)
+{
+  // files are the same element only with the same name and size, like in the signatures.
+  MinHash sketch;
+  for(int i = 0; i < listing.fileNames.size(); ++i)
+  {
+    const auto &name = listing.fileNames.at(i);
+    sketch.add(Hasher::mix(Hasher::hash(name.constData(), name.size(), FILE_SEED) ^ Hasher::mix(listing.fileSizes.at(i))));
+  }
+
+  for(const auto &directory: listing.directories)
+  {
+    const auto name = QFile::encodeName(directory);
+    sketch.add(Hasher::hash(name.constData(), name.size(), DIRECTORY_SEED));
+  }
+
+  return sketch;
+}
+
+//--------------------------------------------------------------------
+float ScanThread::reclaimable(const DirectoryNode *duplicate, const MinHash &sketch, const MinHash &original)
+{
+  // the sketches only have the direct entries, the subdirectories are compared on their own.
+  const auto bytes = static_cast<float>(duplicate->bytes - duplicate->shared) / MEGABYTE;
+
+  return static_cast<float>(sketch.containment(original)) * bytes;
+}
+
+//--------------------------------------------------------------------
+QHash<const ScanThread::DirectoryNode *, MinHash> ScanThread::sketches(const QList<QVector<DirectoryNode *>> &groups)
+{
+  auto enumerator = createEnumerator(m_statistics.worker(0).enumeration);
+
+  QHash<const DirectoryNode *, MinHash> result;
+  for(const auto &members: groups)
+  {
+    for(const auto node: members)
+    {
+      if(m_cancelled) return result;
+      if(result.contains(node)) continue;
+
+      m_throttle.prioritize(m_generation);
+
+      DirectoryEnumerator::Listing listing(true);
+      if(list(*enumerator, path(node), listing))
+      {
+        prune(node, listing);
+        result.insert(node, entriesSketch(listing));
+      }
+      else
+      {
+        result.insert(node, MinHash());
+      }
+    }
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::prune(const DirectoryNode *node, DirectoryEnumerator::Listing &listing) const
+{
+  const auto &rules = m_options.rules;
+  if(!rules.prunes()) return;
+
+  // a mount point is kept empty, so it's in the same place in the tree of every scan.
+  const auto device = node ? m_devices[node->root] : 0;
+  if(node && rules.sameDevice() && listing.device != 0 && device != 0 && listing.device != device)
+  {
+    listing.directories.clear();
+    listing.fileNames.clear();
+    listing.fileSizes.clear();
+    listing.bytes = 0;
+    listing.files = 0;
+    return;
+  }
+
+  if(rules.maxDepth() > 0 && depth(node) >= rules.maxDepth())
+  {
+    listing.directories.clear();
+    return;
+  }
+
+  if(rules.hasSkips())
+  {
+    auto &names = listing.directories;
+    names.erase(std::remove_if(names.begin(), names.end(), [&rules](const QString &name) { return rules.skips(name); }), names.end());
+  }
+}
+
+//--------------------------------------------------------------------
+int ScanThread::depth(const DirectoryNode *node) const
+{
+  int result = 0;
+  for(; node; node = this->node(node->parent)) ++result;
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+bool ScanThread::subtreeFiles(const DirectoryNode *node, DirectoryEnumerator &enumerator, QStringList &paths, QVector<qint64> &sizes) const
+{
+  QList<const DirectoryNode *> stack;
+  stack << node;
+
+  while(!stack.isEmpty())
+  {
+    auto directory = stack.takeLast();
+
+    const auto directoryPath = path(directory);
+
+    DirectoryEnumerator::Listing listing(true);
+    if(!list(enumerator, directoryPath, listing)) return false;
+    prune(directory, listing);
+
+    QVector<int> indexes(listing.fileNames.size());
+    for(int i = 0; i < indexes.size(); ++i) indexes[i] = i;
+
+    std::sort(indexes.begin(), indexes.end(), [&listing](const int lhs, const int rhs)
+    { return listing.fileNames.at(lhs) < listing.fileNames.at(rhs); });
+
+    const auto separator = directoryPath.endsWith('/') ? QString() : QString("/");
+    for(const auto i: indexes)
+    {
+      paths << directoryPath + separator + QFile::decodeName(listing.fileNames.at(i));
+      sizes << listing.fileSizes.at(i);
+    }
+
+    for(auto i = directory->count; i > 0; --i)
+    {
+      stack << this->node(child(directory, i - 1));
+    }
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::verifyContents(QList<QVector<DirectoryNode *>> &groups, QHash<const DirectoryNode *, quint64> &keys)
+{
+  m_statistics.begin(ScanStatistics::Phase::VERIFICATION);
+
+  FileHasher hasher(m_threads, m_options.mapFiles);
+  hasher.setThrottle(&m_throttle);
+  auto enumerator = createEnumerator(m_statistics.worker(0).enumeration);
+
+  // hashes are cached by path, the files of nested groups are compared again.
+  QHash<QString, quint64> partials, fulls;
+
+  QList<QVector<DirectoryNode *>> verified;
+  for(const auto &members: groups)
+  {
+    if(m_cancelled) break;
+
+    m_throttle.prioritize(m_generation);
+
+    // the tree could have changed since it was traversed.
+    QVector<QStringList> files;
+    QVector<qint64> sizes;
+    bool consistent = true;
+    for(const auto node: members)
+    {
+      QStringList paths;
+      sizes.clear();
+      consistent &= subtreeFiles(node, *enumerator, paths, sizes);
+      files << paths;
+    }
+
+    for(const auto &list: files) consistent &= (list.size() == sizes.size());
+    if(!consistent) continue;
+
+    QList<QVector<int>> classes;
+    QVector<int> all;
+    for(int i = 0; i < members.size(); ++i) all << i;
+    classes << all;
+
+    auto split = [&](QHash<QString, quint64> &cache, const bool full)
+    {
+      auto compared = [&sizes, full](const int file)
+      { return !full || !FileHasher::partialIsFull(sizes.at(file)); };
+
+      QStringList pending;
+      for(const auto &members: classes)
+      {
+        for(const auto member: members)
+        {
+          for(int file = 0; file < sizes.size(); ++file)
+          {
+            const auto &path = files.at(member).at(file);
+            if(compared(file) && !cache.contains(path)) pending << path;
+          }
+        }
+      }
+      pending.removeDuplicates();
+
+      const auto hashed = hasher.bytesHashed();
+      const auto hashes = full ? hasher.fullHashes(pending) : hasher.partialHashes(pending);
+      for(int i = 0; i < pending.size(); ++i)
+      {
+        cache.insert(pending.at(i), hashes.at(i));
+      }
+
+      m_statistics.addHashed(pending.size(), hasher.bytesHashed() - hashed);
+
+      QList<QVector<int>> result;
+      for(const auto &members: classes)
+      {
+        QHash<quint64, QVector<int>> parts;
+        for(const auto member: members)
+        {
+          Hasher key;
+          for(int file = 0; file < sizes.size(); ++file)
+          {
+            if(!compared(file)) continue;
+
+            const auto value = cache.value(files.at(member).at(file));
+            key.update(&value, sizeof(value));
+          }
+
+          parts[key.digest()] << member;
+        }
+
+        for(const auto &part: parts)
+        {
+          if(part.size() > 1) result << part;
+        }
+      }
+
+      classes = result;
+    };
+
+    split(partials, false);
+    if(!classes.isEmpty()) split(fulls, true);
+
+    for(const auto &indexes: classes)
+    {
+      QVector<DirectoryNode *> group;
+      for(const auto i: indexes) group << members.at(i);
+
+      verified << group;
+    }
+  }
+
+  // members of the verified groups share a new key, so the nesting of the groups is checked on
+  // the contents. The structure signatures are kept, they are needed to update the tree.
+  for(const auto &members: verified)
+  {
+    const auto key = Hasher::mix(CONTENT_SEED + m_verified++);
+    for(const auto node: members)
+    {
+      keys.insert(node, key);
+    }
+  }
+
+  groups = verified;
+
+  m_statistics.end(ScanStatistics::Phase::VERIFICATION);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::rollUp(DirectoryNode *node)
+{
+  while(node)
+  {
+    summarize(node);
+    index(node);
+
+    ++m_inspected;
+
+    updateProgress();
+
+    auto parent = this->node(node->parent);
+    if(!parent)
+    {
+      m_statistics.sample();
+      break;
+    }
+
+    if(--parent->pending != 0) break;
+
+    node = parent;
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::settle()
+{
+  // without aliases or hard linked files the results don't depend on the traversal order.
+  if(m_statistics.snapshot().aliases == 0 && m_links.isEmpty()) return;
+
+  typedef QPair<quint64, quint64> Identity;
+
+  QSet<Identity> aliased;
+  QVector<quint32> nodes = m_roots;
+  while(!nodes.isEmpty())
+  {
+    const auto node = this->node(nodes.takeLast());
+    nodes << children(node);
+
+    if(node->alias) aliased.insert(qMakePair(node->device, node->inode));
+  }
+
+  QHash<Identity, quint32> holders;
+  nodes = m_roots;
+  while(!nodes.isEmpty() && !aliased.isEmpty())
+  {
+    const auto index = nodes.takeLast();
+    const auto node  = this->node(index);
+    nodes << children(node);
+
+    const auto identity = qMakePair(node->device, node->inode);
+    if(!node->alias && aliased.contains(identity)) holders.insert(identity, index);
+  }
+
+  // the directories are visited again in the order of the serial scan, the first path of a
+  // directory takes its subtree from the one that listed it and the first directory of a hard
+  // linked file counts its size.
+  QSet<Identity> directories, files;
+  QVector<quint32> order;
+  bool changed = false;
+
+  for(auto it = m_roots.crbegin(); it != m_roots.crend(); ++it) nodes << *it;
+
+  while(!nodes.isEmpty())
+  {
+    const auto index = nodes.takeLast();
+    const auto node  = this->node(index);
+    order << index;
+
+    const auto identity = qMakePair(node->device, node->inode);
+    if(node->inode != 0 && !directories.contains(identity))
+    {
+      directories.insert(identity);
+
+      // a directory of a starting folder keeps the alias, the folders are listed first.
+      const auto holder = holders.value(identity, 0);
+      if(node->alias && holder != 0)
+      {
+        move(holder, index);
+        changed = true;
+      }
+    }
+
+    if(!node->alias)
+    {
+      qint64 shared = 0;
+      for(const auto &link: m_links.value(index))
+      {
+        const auto file = qMakePair(node->device, link.inode);
+        if(files.contains(file)) shared += link.size;
+        else                     files.insert(file);
+      }
+
+      changed |= shared != node->shared;
+      node->shared = shared;
+    }
+
+    for(auto i = node->count; i > 0; --i)
+    {
+      nodes << child(node, i - 1);
+    }
+  }
+
+  if(!changed) return;
+
+  // subdirectories come after their parents, so the tree is summarized backwards.
+  for(auto it = order.crbegin(); it != order.crend(); ++it)
+  {
+    summarize(node(*it));
+  }
+
+  for(auto &shard: m_shards)
+  {
+    shard.directories.clear();
+    shard.signatures.clear();
+  }
+
+  for(const auto index: order)
+  {
+    this->index(node(index));
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::move(const quint32 from, const quint32 to)
+{
+  const auto source = node(from);
+  const auto target = node(to);
+
+  target->bytes          = source->bytes;
+  target->files          = source->files;
+  target->shared         = source->shared;
+  target->modified       = source->modified;
+  target->subdirectories = source->subdirectories;
+  target->children       = source->children;
+  target->count          = source->count;
+  target->failed         = source->failed;
+  target->alias          = false;
+
+  source->bytes    = 0;
+  source->files    = 0;
+  source->shared   = 0;
+  source->children = 0;
+  source->count    = 0;
+  source->alias    = true;
+
+  if(m_links.contains(from)) m_links.insert(to, m_links.take(from));
+
+  for(quint32 i = 0; i < target->count; ++i)
+  {
+    node(child(target, i))->parent = to;
+  }
+
+  // the paths of the subtree start at the starting folder of its new parent.
+  if(target->root == source->root) return;
+
+  auto nodes = children(target);
+  while(!nodes.isEmpty())
+  {
+    const auto node = this->node(nodes.takeLast());
+    nodes << children(node);
+
+    node->root = target->root;
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::summarize(DirectoryNode *node)
+{
+  // subdirectories are added in listing order, so the result doesn't depend on the workers. The
+  // files are added as a single byte count, so the sizes may differ from a per file float sum.
+  float size = 0.f;
+  for(quint32 i = 0; i < node->count; ++i)
+  {
+    size += this->node(child(node, i))->size;
+  }
+
+  size += static_cast<float>(node->bytes - node->shared)/MEGABYTE;
+
+  if(m_options.signatures())
+  {
+    // the entries are combined with a commutative sum so the listing order doesn't matter.
+    auto signature = node->files;
+    node->total = node->bytes;
+    for(quint32 i = 0; i < node->count; ++i)
+    {
+      const auto subdirectory = this->node(child(node, i));
+      const auto childName    = QFile::encodeName(subdirectory->name);
+      signature   += Hasher::mix(Hasher::hash(childName.constData(), childName.size(), DIRECTORY_SEED) ^ subdirectory->signature);
+      node->total += subdirectory->total;
+    }
+
+    node->signature = Hasher::mix(signature ^ Hasher::mix(node->total));
+  }
+
+  node->excluded = node->alias || node->failed || m_options.rules.ignores(node->name, static_cast<double>(size) * MEGABYTE);
+
+  node->size = node->excluded ? 0.f : size;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::index(DirectoryNode *node)
+{
+  if(node->excluded) return;
+
+  if(!m_options.signatures())
+  {
+    const auto name = groupName(node);
+    const auto hashValue = NameIndex<DirectoryNode *>::hash(name);
+    auto &shard = m_shards[(hashValue >> 32) % SHARDS];
+
+    QMutexLocker lock(&shard.mutex);
+    shard.directories.insert(name, hashValue, node);
+  }
+  else
+  {
+    auto &shard = m_shards[(node->signature >> 32) % SHARDS];
+
+    QMutexLocker lock(&shard.mutex);
+    shard.signatures.insert(node->signature, node->signature, node);
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::unindex(DirectoryNode *node, QHash<quint64, QString> &keys)
+{
+  // the node may be deleted and its memory reused by a new one.
+  m_contentKeys.remove(node);
+
+  if(node->excluded) return;
+
+  if(!m_options.signatures())
+  {
+    const auto name = groupName(node);
+    const auto hashValue = NameIndex<DirectoryNode *>::hash(name);
+    auto &shard = m_shards[(hashValue >> 32) % SHARDS];
+
+    QMutexLocker lock(&shard.mutex);
+    shard.directories.remove(name, hashValue, node);
+    keys.insert(hashValue, name);
+  }
+  else
+  {
+    auto &shard = m_shards[(node->signature >> 32) % SHARDS];
+
+    QMutexLocker lock(&shard.mutex);
+    shard.signatures.remove(node->signature, node->signature, node);
+    keys.insert(node->signature, QString());
+  }
+}
+
+//--------------------------------------------------------------------
+QString ScanThread::groupName(const DirectoryNode *node) const
+{
+  return m_options.mode == ScanOptions::Mode::SIMILAR ? m_fuzzy.normalize(node->name) : node->name.toLower();
+}
+
+//--------------------------------------------------------------------
+quint64 ScanThread::groupKey(const DirectoryNode *node) const
+{
+  return m_options.signatures() ? node->signature : NameIndex<DirectoryNode *>::hash(groupName(node));
+}
+
+//--------------------------------------------------------------------
+void ScanThread::addKey(const DirectoryNode *node, QHash<quint64, QString> &keys) const
+{
+  if(m_options.signatures()) keys.insert(node->signature, QString());
+  else
+  {
+    const auto name = groupName(node);
+    keys.insert(NameIndex<DirectoryNode *>::hash(name), name);
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::indexStatistics()
+{
+  double loadFactor = 0.;
+  qint64 lookups = 0, probes = 0;
+  for(const auto &shard: m_shards)
+  {
+    if(!m_options.signatures())
+    {
+      loadFactor += shard.directories.loadFactor();
+      lookups    += shard.directories.lookups();
+      probes     += shard.directories.probes();
+    }
+    else
+    {
+      loadFactor += shard.signatures.loadFactor();
+      lookups    += shard.signatures.lookups();
+      probes     += shard.signatures.probes();
+    }
+  }
+
+  m_statistics.setIndex(loadFactor / SHARDS, lookups > 0 ? static_cast<double>(probes) / lookups : 0.);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::treeStatistics()
+{
+  qint64 nodes = 0, parents = 0, links = 0;
+
+  auto pending = m_roots;
+  while(!pending.isEmpty())
+  {
+    const auto node = this->node(pending.takeLast());
+    pending << children(node);
+
+    ++nodes;
+    if(node->count > 0) ++parents;
+    links += node->count;
+  }
+
+  const qint64 bytes = m_nodes.size() * sizeof(DirectoryNode) + m_children.size() * sizeof(quint32);
+
+  // the same tree linked by pointers: a parent pointer and a list of child pointers per node,
+  // instead of the three indexes, and a list block per parent with a 16 bytes header.
+  const qint64 pointerNode = (sizeof(DirectoryNode) - 3 * sizeof(quint32) + 2 * sizeof(void *) + alignof(DirectoryNode) - 1) / alignof(DirectoryNode) * alignof(DirectoryNode);
+  const qint64 pointerBytes = nodes * pointerNode + parents * 16 + links * sizeof(void *);
+
+  m_statistics.setTree(nodes, bytes, pointerBytes);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::setChildren(DirectoryNode *node, const QVector<quint32> &children)
+{
+  const auto count = static_cast<quint32>(children.size());
+
+  // a longer list takes a new run, the old one stays unused until the tree is freed.
+  if(count > node->count) node->children = m_children.reserve(count);
+  node->count = count;
+
+  for(quint32 i = 0; i < count; ++i)
+  {
+    m_children.construct(node->children + i, children.at(i));
+  }
+}
+
+//--------------------------------------------------------------------
+QVector<quint32> ScanThread::children(const DirectoryNode *node) const
+{
+  QVector<quint32> result;
+  result.reserve(node->count);
+
+  for(quint32 i = 0; i < node->count; ++i)
+  {
+    result << child(node, i);
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::similarNames(QList<QVector<DirectoryNode *>> &candidates) const
+{
+  // the directories are already grouped by normalized name, only the groups are compared.
+  QStringList names;
+  QVector<QVector<DirectoryNode *>> members;
+  for(const auto &shard: m_shards)
+  {
+    for(int i = 0; i < shard.directories.groups(); ++i)
+    {
+      // the groups emptied by a refresh keep their names.
+      if(shard.directories.count(i) == 0) continue;
+
+      names   << shard.directories.key(i);
+      members << shard.directories.values(i);
+    }
+  }
+
+  const auto clusters = m_fuzzy.cluster(names);
+
+  QHash<int, QVector<DirectoryNode *>> merged;
+  for(int i = 0; i < clusters.size(); ++i)
+  {
+    merged[clusters.at(i)] << members.at(i);
+  }
+
+  for(const auto &group: merged)
+  {
+    if(group.size() > 1) candidates << group;
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::numberDirectories()
+{
+  int order = 0;
+  for(auto root: m_roots)
+  {
+    QList<QPair<DirectoryNode *, quint32>> stack;
+    stack << qMakePair(node(root), 0u);
+
+    while(!stack.isEmpty())
+    {
+      auto &top = stack.last();
+      if(top.second < top.first->count)
+      {
+        auto subdirectory = node(child(top.first, top.second++));
+        stack << qMakePair(subdirectory, 0u);
+      }
+      else
+      {
+        top.first->order = order++;
+        stack.removeLast();
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::match()
+{
+  m_statistics.begin(ScanStatistics::Phase::MATCH);
+
+  numberDirectories();
+
+  m_contentKeys.clear();
+  m_reported.clear();
+
+  QList<QVector<DirectoryNode *>> candidates;
+  if(m_options.mode == ScanOptions::Mode::SIMILAR)
+  {
+    similarNames(candidates);
+  }
+  else
+  {
+    for(auto &shard: m_shards)
+    {
+      if(m_options.mode == ScanOptions::Mode::NAMES)
+      {
+        for(int i = 0; i < shard.directories.groups(); ++i)
+        {
+          if(shard.directories.count(i) > 1) candidates << shard.directories.values(i);
+        }
+      }
+      else
+      {
+        for(int i = 0; i < shard.signatures.groups(); ++i)
+        {
+          if(shard.signatures.count(i) > 1) candidates << shard.signatures.values(i);
+        }
+      }
+    }
+  }
+
+  if(report(candidates, nullptr)) m_complete = true;
+
+  m_statistics.end(ScanStatistics::Phase::MATCH);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::rematch(const QHash<quint64, QString> &keys)
+{
+  m_statistics.begin(ScanStatistics::Phase::MATCH);
+
+  numberDirectories();
+
+  // the groups reported with any of the keys are replaced by the ones matched again.
+  QSet<quint64> removed;
+  for(auto it = keys.constBegin(); it != keys.constEnd(); ++it)
+  {
+    const auto reported = m_reported.constFind(it.key());
+    if(reported != m_reported.constEnd()) removed.insert(reported.value());
+  }
+
+  QList<QVector<DirectoryNode *>> candidates;
+  if(m_options.mode == ScanOptions::Mode::SIMILAR)
+  {
+    // the names are clustered again, a cluster with a name of a replaced group may have taken
+    // names of other groups, so those are replaced too until no cluster joins the replaced ones.
+    QList<QVector<DirectoryNode *>> clusters;
+    similarNames(clusters);
+
+    QVector<bool> selected(clusters.size(), false);
+    auto changed = true;
+    while(changed)
+    {
+      changed = false;
+      for(int i = 0; i < clusters.size(); ++i)
+      {
+        if(selected.at(i)) continue;
+
+        QVector<quint64> memberKeys;
+        auto affected = false;
+        for(const auto node: clusters.at(i))
+        {
+          const auto memberKey = groupKey(node);
+          const auto reported  = m_reported.constFind(memberKey);
+          affected |= keys.contains(memberKey) || (reported != m_reported.constEnd() && removed.contains(reported.value()));
+          memberKeys << memberKey;
+        }
+
+        if(!affected) continue;
+
+        for(const auto memberKey: memberKeys)
+        {
+          const auto reported = m_reported.constFind(memberKey);
+          if(reported != m_reported.constEnd()) removed.insert(reported.value());
+        }
+
+        selected[i] = true;
+        changed = true;
+      }
+    }
+
+    for(int i = 0; i < clusters.size(); ++i)
+    {
+      if(selected.at(i)) candidates << clusters.at(i);
+    }
+  }
+  else
+  {
+    for(auto it = keys.constBegin(); it != keys.constEnd(); ++it)
+    {
+      auto &shard = m_shards[(it.key() >> 32) % SHARDS];
+
+      QVector<DirectoryNode *> members;
+      if(m_options.mode == ScanOptions::Mode::NAMES)
+      {
+        const auto group = shard.directories.find(it.value(), it.key());
+        if(group != -1) members = shard.directories.values(group);
+      }
+      else
+      {
+        const auto group = shard.signatures.find(it.key(), it.key());
+        if(group != -1) members = shard.signatures.values(group);
+      }
+
+      // the directories of the group are verified again.
+      for(const auto node: members)
+      {
+        m_contentKeys.remove(node);
+      }
+
+      if(members.size() > 1) candidates << members;
+    }
+  }
+
+  for(auto it = m_reported.begin(); it != m_reported.end();)
+  {
+    if(removed.contains(it.value())) it = m_reported.erase(it);
+    else                             ++it;
+  }
+
+  for(const auto key: removed)
+  {
+    emit groupRemoved(key);
+  }
+
+  report(candidates, &removed);
+
+  m_statistics.end(ScanStatistics::Phase::MATCH);
+}
+
+//--------------------------------------------------------------------
+bool ScanThread::report(QList<QVector<DirectoryNode *>> &candidates, const QSet<quint64> *replaced)
+{
+  auto byOrder = [](const DirectoryNode *lhs, const DirectoryNode *rhs)
+  { return lhs->order < rhs->order; };
+
+  // directories that aren't in a verified content group get an unique key.
+  auto key = [this](const DirectoryNode *node)
+  {
+    if(m_options.mode != ScanOptions::Mode::CONTENT) return node->signature;
+
+    const auto it = m_contentKeys.constFind(node);
+    return it != m_contentKeys.constEnd() ? it.value() : Hasher::mix(reinterpret_cast<quintptr>(node));
+  };
+
+  // a group is nested if its directories are the children of the directories of another
+  // signature group, the parents are reported instead.
+  auto isNested = [this, &key](const QVector<DirectoryNode *> &members)
+  {
+    QSet<DirectoryNode *> parents;
+    for(const auto member: members)
+    {
+      const auto parent = node(member->parent);
+      if(!parent || parent->excluded || key(parent) != key(node(members.first()->parent))) return false;
+
+      parents.insert(parent);
+    }
+
+    return parents.size() == members.size();
+  };
+
+  if(m_options.mode == ScanOptions::Mode::CONTENT) verifyContents(candidates, m_contentKeys);
+
+  if(m_cancelled) return false;
+
+  QList<QVector<DirectoryNode *>> groups;
+  QList<QPair<DirectoryNode *, DirectoryNode *>> duplicates;
+  for(auto &members: candidates)
+  {
+    if(m_options.signatures() && isNested(members)) continue;
+
+    std::sort(members.begin(), members.end(), byOrder);
+
+    // each directory is reported along the first one found in its group.
+    for(int j = 1; j < members.size(); ++j)
+    {
+      duplicates << qMakePair(members.first(), members.at(j));
+    }
+
+    groups << members;
+  }
+
+  std::sort(duplicates.begin(), duplicates.end(), [&byOrder](const QPair<DirectoryNode *, DirectoryNode *> &lhs, const QPair<DirectoryNode *, DirectoryNode *> &rhs)
+  { return byOrder(lhs.second, rhs.second); });
+
+  // the sketches are only needed for the reported directories, so they're taken from new listings.
+  const auto sketchOf = sketches(groups);
+  if(m_cancelled) return false;
+
+  DuplicateBatch batch;
+  QElapsedTimer timer;
+  timer.start();
+
+  for(const auto &pair: duplicates)
+  {
+    const auto entry = pair.first;
+    const auto info  = pair.second;
+    const auto similarity  = static_cast<float>(sketchOf.value(entry).similarity(sketchOf.value(info)));
+    const auto reclaimable = ScanThread::reclaimable(info, sketchOf.value(info), sketchOf.value(entry));
+    const Duplicate duplicate{entry->name, parentPath(entry), entry->size, info->name, parentPath(info), info->size, similarity, reclaimable, groupKey(entry)};
+
+    emit found(duplicate.name1, duplicate.parent1, duplicate.size1, duplicate.name2, duplicate.parent2, duplicate.size2);
+
+    batch << duplicate;
+    if(batch.size() >= BATCH_SIZE || timer.elapsed() >= BATCH_INTERVAL)
+    {
+      m_statistics.addBatch();
+      emit foundBatch(batch);
+      batch.clear();
+      timer.restart();
+    }
+  }
+
+  if(!batch.isEmpty())
+  {
+    m_statistics.addBatch();
+    emit foundBatch(batch);
+  }
+
+  // groups are reported in the order they got their first duplicate.
+  std::sort(groups.begin(), groups.end(), [&byOrder](const QVector<DirectoryNode *> &lhs, const QVector<DirectoryNode *> &rhs)
+  { return byOrder(lhs.at(1), rhs.at(1)); });
+
+  // the results file is written as the groups are reported, and replaced on every match. The
+  // groups that weren't matched again are copied from the current one first.
+  ResultFile results, current;
+  auto saving = !m_options.resultsFile.isEmpty();
+  if(saving && replaced && !current.open(m_options.resultsFile)) saving = false;
+  if(saving && !results.create(m_options.resultsFile, QDir::toNativeSeparators(m_directories.join(';')), m_options.mode)) saving = false;
+  if(!saving && !m_options.resultsFile.isEmpty())
+  {
+    qWarning() << "Unable to write the results file" << m_options.resultsFile;
+  }
+
+  if(saving && replaced)
+  {
+    for(qint64 i = 0; i < current.groups(); ++i)
+    {
+      const auto group = current.group(i);
+      if(!replaced->contains(group.key)) results.append(group);
+    }
+  }
+  current.close();
+
+  for(const auto &members: groups)
+  {
+    // the key is the one the group was matched by, the verified content groups keep the
+    // key of their structure.
+    const auto first = members.first();
+    DuplicateGroup group;
+    group.key = groupKey(first);
+
+    for(const auto node: members)
+    {
+      group.names        << node->name;
+      group.parents      << parentPath(node);
+      group.sizes        << node->size;
+      group.similarities << (node == first ? 1.f : static_cast<float>(sketchOf.value(first).similarity(sketchOf.value(node))));
+      group.reclaimables << (node == first ? 0.f : reclaimable(node, sketchOf.value(node), sketchOf.value(first)));
+
+      m_reported.insert(groupKey(node), group.key);
+    }
+
+    if(saving) results.append(group);
+
+    emit foundGroup(group);
+  }
+
+  if(saving && !results.commit())
+  {
+    qWarning() << "Unable to write the results file" << m_options.resultsFile;
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+QString ScanThread::parentPath(const DirectoryNode* node) const
+{
+  auto result = node->parent ? path(this->node(node->parent)) : m_directories.at(node->root);
+  if(!result.endsWith('/')) result += '/';
+
+  return QDir::toNativeSeparators(result);
+}
+
+//--------------------------------------------------------------------
+QString ScanThread::path(const DirectoryNode* node) const
+{
+  const auto &root = node ? m_directories.at(node->root) : m_directories.first();
+
+  QVector<const DirectoryNode *> chain;
+  int length = root.size();
+  for(; node; node = this->node(node->parent))
+  {
+    chain << node;
+    length += node->name.size() + 1;
+  }
+
+  QString result;
+  result.reserve(length);
+  result = root;
+
+  for(auto it = chain.crbegin(); it != chain.crend(); ++it)
+  {
+    if(!result.endsWith('/')) result += '/';
+    result += (*it)->name;
+  }
+
+  return result;
+}
+
+//--------------------------------------------------------------------
+QString ScanThread::intern(const QString& name)
+{
+  auto &shard = m_shards[qHash(name) % SHARDS];
+
+  QMutexLocker lock(&shard.mutex);
+  const auto it = shard.names.constFind(name);
+  if(it != shard.names.constEnd()) return *it;
+
+  shard.names.insert(name);
+
+  return name;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_idleMutex);
+    m_cancelled = true;
+    m_idle.notify_all();
+  }
+
+  m_throttle.cancel();
+
+  exit();
+}
+
+//--------------------------------------------------------------------
+void ScanThread::watch()
+{
+  auto enumerator = createEnumerator(m_statistics.worker(0).enumeration);
+  DirectoryWatcher watcher;
+
+  QStringList paths;
+  paths << m_directories;
+
+  auto nodes = m_roots;
+  while(!nodes.isEmpty())
+  {
+    const auto index = nodes.takeLast();
+    const auto node  = this->node(index);
+    nodes << children(node);
+
+    const auto nodePath = path(node);
+    m_paths.insert(nodePath, index);
+    paths << nodePath;
+  }
+
+  watcher.watch(paths);
+  updateUnwatched(watcher);
+
+  // the watcher lives in this thread, so the changes are processed here and not in the GUI.
+  connect(&watcher, &DirectoryWatcher::changed, &watcher, [&](const QStringList &changed)
+  { refresh(changed, *enumerator, watcher); });
+
+  emit watching();
+
+  exec();
+
+  m_paths.clear();
+}
+
+//--------------------------------------------------------------------
+void ScanThread::refresh(const QStringList& paths, DirectoryEnumerator &enumerator, DirectoryWatcher &watcher)
+{
+  m_statistics.begin(ScanStatistics::Phase::REFRESH);
+
+  m_throttle.prioritize(m_generation);
+
+  // the changed directories and their ancestors leave the directories table before they
+  // change, the deleted ones before they are freed and the new ones enter it once scanned.
+  // The groups of all their keys are matched again.
+  QHash<quint64, QString> keys;
+  QList<DirectoryNode *> changed, updated;
+  QSet<const DirectoryNode *> detached;
+  for(const auto &changedPath: paths)
+  {
+    DirectoryEnumerator::Listing listing(m_options.signatures());
+
+    const auto root = m_directories.indexOf(changedPath);
+    if(root != -1)
+    {
+      if(list(enumerator, changedPath, listing))
+      {
+        prune(nullptr, listing);
+
+        QVector<quint32> children;
+        for(const auto index: m_roots)
+        {
+          if(node(index)->root == root) children << index;
+        }
+
+        reconcile(children, 0, root, listing.directories, enumerator, watcher, keys);
+
+        // the top-level directories are kept grouped by starting directory, in their order.
+        QVector<quint32> roots;
+        for(int i = 0; i < m_directories.size(); ++i)
+        {
+          if(i == root)
+          {
+            roots << children;
+            continue;
+          }
+
+          for(const auto index: m_roots)
+          {
+            if(node(index)->root == i) roots << index;
+          }
+        }
+
+        m_roots = roots;
+      }
+      continue;
+    }
+
+    // removed directories are deleted when their parent is listed again.
+    const auto index = m_paths.value(changedPath, 0);
+    auto node = this->node(index);
+    if(!node || node->alias || !list(enumerator, changedPath, listing)) continue;
+
+    for(auto ancestor = node; ancestor && !detached.contains(ancestor); ancestor = this->node(ancestor->parent))
+    {
+      unindex(ancestor, keys);
+      detached.insert(ancestor);
+      updated << ancestor;
+    }
+
+    prune(node, listing);
+    assign(node, listing);
+
+    // the hard linked files already seen can't be told from the ones seen in this directory before,
+    // so the shared bytes stay and only the new files are marked as seen.
+    for(const auto &link: listing.links)
+    {
+      visit(listing.device, link.inode);
+    }
+
+    if(listing.links.isEmpty()) m_links.remove(index);
+    else                        m_links.insert(index, listing.links);
+
+    auto subdirectories = children(node);
+    reconcile(subdirectories, index, node->root, listing.directories, enumerator, watcher, keys);
+    setChildren(node, subdirectories);
+
+    changed << node;
+  }
+
+  // paths come sorted, so the changed directories are still in the tree.
+  for(auto node: changed)
+  {
+    for(; node; node = this->node(node->parent))
+    {
+      summarize(node);
+    }
+  }
+
+  for(const auto node: updated)
+  {
+    index(node);
+    addKey(node, keys);
+
+    // the groups of the subdirectories may be nested in the groups of their parents.
+    for(quint32 i = 0; i < node->count; ++i)
+    {
+      addKey(this->node(child(node, i)), keys);
+    }
+  }
+
+  indexStatistics();
+  treeStatistics();
+
+  updateUnwatched(watcher);
+
+  rematch(keys);
+
+  m_statistics.end(ScanStatistics::Phase::REFRESH);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::updateUnwatched(const DirectoryWatcher &watcher)
+{
+  const auto count = watcher.unwatched();
+  if(m_unwatched.exchange(count) != count) emit unwatchedChanged(count);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::reconcile(QVector<quint32> &children, const quint32 parent, const int root, const QStringList &names, DirectoryEnumerator &enumerator, DirectoryWatcher &watcher, QHash<quint64, QString> &keys)
+{
+  QSet<QString> current;
+  for(const auto &name: names)
+  {
+    current.insert(name);
+  }
+
+  QHash<QString, quint32> existing;
+  QVector<quint32> nodes;
+  for(const auto index: children)
+  {
+    const auto &name = node(index)->name;
+    if(current.contains(name)) existing.insert(name, index);
+    else                       nodes << index;
+  }
+
+  // the missing ones were removed or renamed, their paths are needed before deleting the parents.
+  QStringList removed;
+  QVector<quint32> removedNodes;
+  while(!nodes.isEmpty())
+  {
+    const auto index = nodes.takeLast();
+    const auto node  = this->node(index);
+    nodes << this->children(node);
+
+    removed << path(node);
+    removedNodes << index;
+  }
+
+  // forgotten before scanning the new ones, a renamed directory isn't an alias of itself. The
+  // runs of their children stay in the children arena until the tree is freed.
+  for(const auto index: removedNodes)
+  {
+    const auto node = this->node(index);
+    if(!node->alias) unvisit(node->device, node->inode);
+    unindex(node, keys);
+    m_links.remove(index);
+    m_nodes.destroy(index);
+  }
+
+  m_inspected -= removedNodes.size();
+
+  QVector<quint32> updated;
+  for(const auto &name: names)
+  {
+    auto index = existing.take(name);
+    if(index == 0)
+    {
+      index = m_nodes.create(intern(name), parent, static_cast<quint16>(root));
+      scanSubtree(index, enumerator, watcher, keys);
+    }
+
+    updated << index;
+  }
+
+  for(const auto &removedPath: removed)
+  {
+    m_paths.remove(removedPath);
+  }
+
+  watcher.unwatch(removed);
+
+  children = updated;
+}
+
+//--------------------------------------------------------------------
+void ScanThread::scanSubtree(const quint32 index, DirectoryEnumerator &enumerator, DirectoryWatcher &watcher, QHash<quint64, QString> &keys)
+{
+  QStringList paths;
+  QList<DirectoryNode *> listed;
+
+  QVector<quint32> stack;
+  stack << index;
+
+  while(!stack.isEmpty())
+  {
+    const auto currentIndex = stack.takeLast();
+    const auto current      = node(currentIndex);
+
+    const auto currentPath = path(current);
+
+    DirectoryEnumerator::Listing listing(m_options.signatures());
+    const auto complete = list(enumerator, currentPath, listing);
+    if(!complete) listing = DirectoryEnumerator::Listing(m_options.signatures());
+
+    prune(current, listing);
+    visitListing(currentIndex, listing, m_statistics.worker(0));
+    assign(current, listing);
+    current->failed = !complete;
+
+    QVector<quint32> subdirectories;
+    for(const auto &name: listing.directories)
+    {
+      subdirectories << m_nodes.create(intern(name), currentIndex, current->root);
+    }
+
+    setChildren(current, subdirectories);
+    stack << subdirectories;
+
+    m_paths.insert(currentPath, currentIndex);
+    paths << currentPath;
+    listed << current;
+  }
+
+  watcher.watch(paths);
+
+  // parents are listed before their children, so they are summarized backwards.
+  for(auto it = listed.crbegin(); it != listed.crend(); ++it)
+  {
+    summarize(*it);
+    this->index(*it);
+    addKey(*it, keys);
+  }
+
+  m_inspected += listed.size();
+}
+
+//--------------------------------------------------------------------
+void ScanThread::assign(DirectoryNode *node, const DirectoryEnumerator::Listing &listing) const
+{
+  node->bytes    = listing.bytes;
+  node->modified = listing.modified;
+  node->device   = listing.device;
+  node->inode    = listing.inode;
+  node->subdirectories = subdirectories(listing);
+  node->listed   = true;
+  node->failed   = false;
+
+  // an alias keeps the contents it was emptied to.
+  if(node->alias) return;
+
+  if(m_options.signatures()) node->files = filesSignature(listing);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::loadIndex()
+{
+  if(!m_options.indexFile.isEmpty())
+  {
+    m_previous.reset(new ScanIndex(m_directories, m_options.signatures(), m_options.rules.fingerprint()));
+    if(!m_previous->load(m_options.indexFile)) m_previous.reset();
+  }
+
+  if(!m_options.checkpointFile.isEmpty())
+  {
+    m_checkpoint.reset(new ScanIndex(m_directories, m_options.signatures(), m_options.rules.fingerprint()));
+    if(!m_checkpoint->load(m_options.checkpointFile)) m_checkpoint.reset();
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanThread::saveIndex()
+{
+  if(m_options.indexFile.isEmpty()) return;
+
+  m_previous.reset();
+
+  if(!writeIndex(m_options.indexFile))
+  {
+    qWarning() << "Unable to save the scan index" << m_options.indexFile;
+  }
+}
+
+//--------------------------------------------------------------------
+bool ScanThread::writeIndex(const QString &fileName) const
+{
+  ScanIndex index(m_directories, m_options.signatures(), m_options.rules.fingerprint());
+  index.setStarted(m_started);
+
+  // breadth-first, so the subdirectories of a directory are added one after another.
+  std::lock_guard<std::mutex> lock(m_linksMutex);
+
+  QVector<QPair<quint32, quint32>> nodes;
+  for(const auto root: m_roots) nodes << qMakePair(root, 0u);
+
+  for(int i = 0; i < nodes.size(); ++i)
+  {
+    const auto node = this->node(nodes.at(i).first);
+
+    // directories still queued are listed again when the scan is resumed, and the ones already
+    // seen by another path in the next scan, which could reach them first by this one. Only
+    // their names are kept, in the listing of their parent.
+    ScanIndex::Entry entry;
+    if(node->listed && !node->alias && !node->failed)
+    {
+      entry.modified = node->modified;
+      entry.bytes    = node->bytes;
+      entry.files    = node->files;
+      entry.device   = node->device;
+      entry.inode    = node->inode;
+      entry.subdirectories = node->subdirectories == UNKNOWN_SUBDIRECTORIES ? -1 : node->subdirectories;
+      entry.listed   = 1;
+    }
+
+    const auto links  = entry.listed ? m_links.value(nodes.at(i).first) : QVector<DirectoryEnumerator::Link>();
+    const auto number = index.add(path(node), nodes.at(i).second, entry, links);
+    if(!entry.listed) continue;
+
+    for(quint32 j = 0; j < node->count; ++j)
+    {
+      nodes << qMakePair(child(node, j), number);
+    }
+  }
+
+  return index.save(fileName);
+}
+
+//--------------------------------------------------------------------
+void ScanThread::clear()
+{
+  auto nodes = m_roots;
+  while(!nodes.isEmpty())
+  {
+    const auto node = this->node(nodes.takeLast());
+    nodes << children(node);
+    node->~DirectoryNode();
+  }
+
+  m_roots.clear();
+  m_nodes.clear();
+  m_children.clear();
+  m_links.clear();
+  m_contentKeys.clear();
+  m_reported.clear();
+
+  for(auto &shard: m_shards)
+  {
+    shard.directories.clear();
+    shard.signatures.clear();
+    shard.names.clear();
+    shard.inodes.clear();
+  }
+
+  m_previous.reset();
+}
@@ -0,0 +1,813 @@
+/*
+ File: ScanThread.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANTHREAD_H_
+#define SCANTHREAD_H_
+
+// Project
+#include "DirectoryEnumerator.h"
+#include "NameIndex.h"
+#include "MinHash.h"
+#include "Throttle.h"
+#include "ScanIndex.h"
+#include "ScanStatistics.h"
+#include "ExclusionRules.h"
+#include "FuzzyMatcher.h"
+#include "Arena.h"
+
+// Qt
+#include <QThread>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QDir>
+#include <QStringList>
+#include <QMetaType>
+#include <QHash>
+#include <QSet>
+
+// C++
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class DirectoryWatcher;
+
+/** \struct ScanOptions
+ * \brief Scan configuration.
+ *
+ */
+struct ScanOptions
+{
+  /** \brief Duplicate matching modes.
+   *
+   */
+  enum class Mode: char
+  {
+    NAMES     = 0, /** directories with the same name.                                          */
+    STRUCTURE = 1, /** directories with the same subdirectory names, file names and file sizes. */
+    CONTENT   = 2, /** like STRUCTURE but also with the same file contents.                     */
+    SIMILAR   = 3  /** directories with similar names, see FuzzyMatcher.                        */
+  };
+
+  int                          threads;  /** traversal workers of each solid state or unknown device, 0 to use the number of cores. */
+  int                          rotationalThreads; /** traversal workers of each rotational disk.      */
+  DirectoryEnumerator::Backend backend;  /** directory enumeration backend.                             */
+  Mode                         mode;     /** duplicate matching mode.                                   */
+  bool                         mapFiles; /** true to hash memory maps of the files in CONTENT mode.     */
+  QString                      indexFile;/** scan index file, empty to list every directory. Directories with the same modification time are reused. */
+  bool                         watch;    /** true to keep watching the tree for changes after the scan. */
+  QString                      traceFile;/** Chrome trace file written at the end, empty for none.      */
+  ExclusionRules               rules;    /** directories left out of the scan or of the results.        */
+  FuzzyOptions                 fuzzy;    /** similar names configuration, only in SIMILAR mode.        */
+  QString                      checkpointFile;     /** checkpoint to resume interrupted scans, empty for none. */
+  int                          checkpointInterval; /** seconds between checkpoints during the traversal, 0 for none. */
+  ThrottleOptions              background;         /** background mode, changed while running with ScanThread::setBackground(). */
+  QString                      resultsFile;        /** results file written with the groups of every match, empty for none. */
+
+  ScanOptions(): threads{0}, rotationalThreads{2}, backend{DirectoryEnumerator::Backend::NATIVE}, mode{Mode::NAMES}, mapFiles{false}, watch{false}, rules{ExclusionRules::defaultRules()}, checkpointInterval{300} {};
+
+  /** \brief Returns true if the directories are matched by their signatures instead of their names.
+   *
+   */
+  bool signatures() const
+  { return mode == Mode::STRUCTURE || mode == Mode::CONTENT; }
+};
+
+/** \struct DuplicateGroup
+ * \brief Duplicated directories. The first one is the original, the one found first in
+ *        depth-first order, and the rest are its duplicates.
+ *
+ */
+struct DuplicateGroup
+{
+  quint64        key;     /** matching key, the same for the group in other scans of the mode. */
+  QStringList    names;   /** directory names, original first.                         */
+  QStringList    parents; /** parent paths with native separators, original first.     */
+  QVector<float> sizes;   /** sizes in megabytes, original first.                      */
+  QVector<float> similarities; /** estimated similarities with the original, 1 for the original. */
+  QVector<float> reclaimables; /** megabytes of the direct files estimated to be also in the original, 0 for the original. */
+
+  DuplicateGroup(): key{0} {};
+};
+
+Q_DECLARE_METATYPE(DuplicateGroup)
+
+/** \struct Duplicate
+ * \brief A duplicated directory along the original one of its group. The similarity and the
+ *        reclaimable size are estimated from the sketches of the entries of both directories.
+ *
+ */
+struct Duplicate
+{
+  QString name1;       /** original directory name.                     */
+  QString parent1;     /** original parent path with native separators. */
+  float   size1;       /** original size in megabytes.                  */
+  QString name2;       /** duplicate directory name.                    */
+  QString parent2;     /** duplicate parent path with native separators.*/
+  float   size2;       /** duplicate size in megabytes.                 */
+  float   similarity;  /** estimated Jaccard similarity of the entries, from 0 to 1. */
+  float   reclaimable; /** megabytes of the files directly in the duplicate estimated to be also in the original. */
+  quint64 key;         /** matching key of the group of both directories. */
+};
+
+typedef QVector<Duplicate> DuplicateBatch;
+
+Q_DECLARE_METATYPE(DuplicateBatch)
+
+/** \class ScanThread
+ * \brief Thread for scanning paths for duplicated directories.
+ *
+ */
+class ScanThread
+: public QThread
+{
+    Q_OBJECT
+  public:
+    /** \brief ScanThread class constructor.
+     * \param[in] directory Starting directory.
+     * \param[in] options Scan configuration.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit ScanThread(const QDir &directory, const ScanOptions &options = ScanOptions(), QObject *parent = nullptr);
+
+    /** \brief ScanThread class constructor.
+     * \param[in] directories Starting directories, nested ones are scanned only once.
+     * \param[in] options Scan configuration.
+     * \param[in] parent Raw pointer of the object parent of this one.
+     *
+     */
+    explicit ScanThread(const QStringList &directories, const ScanOptions &options = ScanOptions(), QObject *parent = nullptr);
+
+    /** \brief ScanThread class virtual destructor.
+     *
+     */
+    virtual ~ScanThread();
+
+    /** \brief Returns the number of inspected directories.
+     *
+     */
+    int inspected() const
+    { return m_inspected.load(); }
+
+    /** \brief Returns the number of traversal workers of all the devices.
+     *
+     */
+    int threads() const
+    { return m_threads; }
+
+    /** \brief Returns the number of devices scanned in parallel, each with its own workers.
+     *
+     */
+    int devices() const
+    { return static_cast<int>(m_groups.size()); }
+
+    /** \brief Returns the number of directories reused from the scan index.
+     *
+     */
+    int reused() const
+    { return m_reused.load(); }
+
+    /** \brief Returns the number of directories taken from the checkpoint of an interrupted scan.
+     *
+     */
+    int resumed() const
+    { return m_resumed.load(); }
+
+    /** \brief Returns the number of directories shown but not watched for changes, usually because
+     *        the system watch limit was reached.
+     *
+     */
+    int unwatched() const
+    { return m_unwatched.load(); }
+
+    /** \brief Returns the estimated fraction of the traversal done, from 0 to 1. Can be called
+     *        from any thread.
+     *
+     */
+    double completion() const;
+
+    /** \brief Returns the estimated time left of the traversal in milliseconds, from its throughput
+     *        so far, or -1 if it can't be estimated yet. Can be called from any thread.
+     *
+     */
+    qint64 remainingTime() const;
+
+    /** \brief Holds or releases the traversal workers. Pausing takes effect after the directories
+     *        being listed, and doesn't hold the matching phase.
+     * \param[in] paused True to pause, false to resume.
+     *
+     */
+    void setPaused(const bool paused);
+
+    /** \brief Returns true if the traversal is paused.
+     *
+     */
+    bool isPaused() const
+    { return m_paused.load(); }
+
+    /** \brief Returns true if the scan was stopped before reporting all the results.
+     *
+     */
+    bool isCancelled() const
+    { return m_cancelled.load() && !m_complete.load(); }
+
+    /** \brief Changes the background mode while the scan runs. Can be called from any thread.
+     * \param[in] options Background mode configuration.
+     *
+     */
+    void setBackground(const ThrottleOptions &options)
+    { m_throttle.setOptions(options); }
+
+    /** \brief Returns the current background mode configuration.
+     *
+     */
+    ThrottleOptions background() const
+    { return m_throttle.options(); }
+
+    /** \brief Returns the current performance statistics of the scan. Can be called from any thread.
+     *
+     */
+    ScanStatistics::Snapshot statistics() const
+    {
+      auto result = m_statistics.snapshot();
+      result.throttled = m_throttle.waited();
+
+      return result;
+    }
+
+    /** \brief Stops the scan, writing a checkpoint of the traversal if it's unfinished, or stops
+     *        watching for changes. The thread finishes after the directories being listed or the
+     *        current update.
+     *
+     */
+    void stop();
+
+  signals:
+    void progress(int);
+    void found(const QString &name1, const QString &parent1, const float size1, const QString &name2, const QString &parent2, const float size2);
+    void foundGroup(const DuplicateGroup &group);
+    void foundBatch(const DuplicateBatch &batch);
+    void watching();
+    void groupRemoved(quint64 key);
+    void unwatchedChanged(int count);
+
+  protected:
+    virtual void run() override;
+
+  private:
+    /** \struct DirectoryNode
+     * \brief Holds directory information in the scanned tree. Nodes are allocated from the
+     *        nodes arena and linked by their 32-bit indexes, the children of a node are a run
+     *        of the children arena. Nodes only keep their interned name and the full path is
+     *        rebuilt from the parents when needed.
+     *
+     */
+    struct DirectoryNode
+    {
+      QString               name;     /** directory basename, shared by equal names.         */
+      qint64                bytes;    /** size of the directory files in bytes.              */
+      qint64                shared;   /** bytes of its hard linked files counted elsewhere.  */
+      qint64                total;    /** size of the subtree in bytes, excluded or not.     */
+      quint64               signature;/** subtree signature, only in structure/content modes. */
+      quint64               files;    /** signature of the directory files.                  */
+      qint64                modified; /** directory modification time when it was listed.    */
+      quint64               device;   /** file system of the directory, 0 if unknown.        */
+      quint64               inode;    /** inode of the directory, 0 if unknown.              */
+      quint32               parent;   /** index of the parent directory, 0 for top-level entries. */
+      quint32               children; /** first position of its subdirectories in the children arena. */
+      quint32               count;    /** number of subdirectories, in listing order.        */
+      std::atomic<int>      pending;  /** number of children not yet rolled up.              */
+      float                 size;     /** size in megabytes, 0 if excluded.                  */
+      int                   order;    /** position in the serial depth-first traversal.      */
+      bool                  excluded; /** true if the directory doesn't take part in search. */
+      bool                  listed;   /** true once its contents are known.                  */
+      bool                  alias;    /** true if already listed by another path, left empty. */
+      bool                  failed;   /** true if it couldn't be listed completely, left empty. */
+      quint16               root;     /** index of its starting directory.                   */
+      quint16               subdirectories; /** subdirectories from its link count when listed, 0xFFFF if unknown. */
+
+      DirectoryNode(const QString &n, const quint32 p, const quint16 r)
+      : name{n}, bytes{0}, shared{0}, total{0}, signature{0}, files{0}, modified{0}, device{0}, inode{0}, parent{p}, children{0}, count{0}, pending{0}, size{0.f}, order{-1}, excluded{false}, listed{false}, alias{false}, failed{false}, root{r}, subdirectories{0xFFFF}
+      {};
+    };
+
+    /** \class WorkQueue
+     * \brief Work-stealing queue of directories. The owner worker pushes and pops from
+     *        the back, idle workers steal from the front.
+     *
+     */
+    class WorkQueue
+    {
+      public:
+        /** \brief Adds the given directory to the back of the queue.
+         * \param[in] node Directory node index.
+         *
+         */
+        void push(const quint32 node);
+
+        /** \brief Removes and returns the last directory of the queue or 0 if empty.
+         *
+         */
+        quint32 pop();
+
+        /** \brief Removes and returns the first directory of the queue or 0 if empty.
+         *
+         */
+        quint32 steal();
+
+      private:
+        std::mutex          m_mutex; /** protects the queue.                  */
+        std::deque<quint32> m_nodes; /** indexes of the queued directories.   */
+    };
+
+    /** \struct DeviceGroup
+     * \brief Traversal workers of the starting directories of a device, they only steal work
+     *        from each other.
+     *
+     */
+    struct DeviceGroup
+    {
+      quint64 device;     /** file system of the starting directories, 0 if unknown. */
+      bool    rotational; /** true if the device is a rotational disk.               */
+      int     first;      /** index of the first worker of the group.                */
+      int     workers;    /** number of workers of the group.                        */
+    };
+
+    /** \struct Shard
+     * \brief Part of the directories table. Directories are distributed between the
+     *        shards by name hash so the workers seldom contend for the same lock.
+     *
+     */
+    struct Shard
+    {
+      QMutex                             mutex;       /** protects the indexes.                  */
+      NameIndex<DirectoryNode*>          directories; /** directories grouped by lowercase name. */
+      NameIndex<DirectoryNode*, quint64> signatures;  /** directories grouped by signature.      */
+      QSet<QString>                      names;       /** interned directory names.              */
+      QSet<QPair<quint64, quint64>>      inodes;      /** (device, inode) of the listed directories and hard linked files. */
+    };
+
+    /** \brief Returns the given directories as absolute paths, without repeated or nested ones.
+     * \param[in] directories Starting directories.
+     *
+     */
+    static QStringList normalize(const QStringList &directories);
+
+    /** \brief Returns the file systems of the given directories.
+     * \param[in] directories Absolute paths.
+     *
+     */
+    static std::vector<quint64> devices(const QStringList &directories);
+
+    /** \brief Returns the worker groups of the given devices, one per distinct device in the
+     *        order they appear, with the number of workers the options give to its kind.
+     * \param[in] devices File systems of the starting directories.
+     * \param[in] options Scan configuration.
+     *
+     */
+    static std::vector<DeviceGroup> schedule(const std::vector<quint64> &devices, const ScanOptions &options);
+
+    /** \brief Returns the index of the worker group of the given starting directory.
+     * \param[in] root Index of the starting directory.
+     *
+     */
+    int group(const int root) const;
+
+    /** \brief Returns a new enumerator of the scan backend that counts its operations in the given
+     *        counters and follows symbolic links if the rules allow it.
+     * \param[in] counters Operation counters.
+     *
+     */
+    std::unique_ptr<DirectoryEnumerator> createEnumerator(DirectoryEnumerator::Counters &counters) const;
+
+    /** \brief Lists the given directory with the enumerator, accounting the operations in the
+     *        background mode limits, and returns true on success.
+     * \param[in] enumerator Directory enumerator.
+     * \param[in] path Directory absolute path.
+     * \param[out] listing Directory contents.
+     *
+     */
+    bool list(DirectoryEnumerator &enumerator, const QString &path, DirectoryEnumerator::Listing &listing) const;
+
+    /** \brief Marks the given file or directory as seen and returns true if it wasn't already.
+     *        Unknown identities are always new.
+     * \param[in] device File system.
+     * \param[in] inode Inode in the file system.
+     *
+     */
+    bool visit(const quint64 device, const quint64 inode);
+
+    /** \brief Forgets the given directory so it can be visited again, once removed from the tree.
+     * \param[in] device File system.
+     * \param[in] inode Inode in the file system.
+     *
+     */
+    void unvisit(const quint64 device, const quint64 inode);
+
+    /** \brief Marks the directory of the given listing as seen, or empties the listing and makes
+     *        the node an alias if it already was, adds the sizes of its hard linked files seen
+     *        elsewhere to the shared bytes of the node and keeps the files for settle().
+     * \param[in] index Directory node index.
+     * \param[inout] listing Directory listing.
+     * \param[in] counters Statistics of the worker processing the directory.
+     *
+     */
+    void visitListing(const quint32 index, DirectoryEnumerator::Listing &listing, ScanStatistics::Worker &counters);
+
+    /** \brief Traversal worker loop. Pops directories from the back of its own queue and, when it's
+     *        empty, steals from the front of the queues of the workers of the same device group.
+     * \param[in] index Worker index, also the index of its queue.
+     *
+     */
+    void worker(const int index);
+
+    /** \brief Holds the calling worker while the traversal is paused or a checkpoint is written.
+     *
+     */
+    void park();
+
+    /** \brief Holds the other workers and writes a checkpoint of the traversal. Called by the first worker.
+     *
+     */
+    void checkpoint();
+
+    /** \brief Lists the given directory, or takes its listing from the scan index if it hasn't
+     *        changed, queues its subdirectories in the worker queue and rolls up the directory
+     *        if it doesn't have subdirectories.
+     * \param[in] index Directory node index.
+     * \param[in] queue Queue of the worker processing the directory.
+     * \param[in] enumerator Directory enumerator of the worker processing the directory.
+     * \param[in] counters Statistics of the worker processing the directory.
+     *
+     */
+    void processDirectory(const quint32 index, WorkQueue &queue, DirectoryEnumerator &enumerator, ScanStatistics::Worker &counters);
+
+    /** \brief Estimates the number of directories of the tree and the size of their files,
+     *        before the traversal.
+     * \param[in] enumerator Directory enumerator.
+     *
+     */
+    void estimate(DirectoryEnumerator &enumerator);
+
+    /** \brief Emits the progress signal if the completion percentage has grown.
+     *
+     */
+    void updateProgress();
+
+    /** \brief Returns the signature of the files of a directory.
+     * \param[in] listing Directory contents with details.
+     *
+     */
+    static quint64 filesSignature(const DirectoryEnumerator::Listing &listing);
+
+    /** \brief Returns the sketch of the files and subdirectories of a directory.
+     * \param[in] listing Directory contents with details.
+     *
+     */
+    static MinHash entriesSketch(const DirectoryEnumerator::Listing &listing);
+
+    /** \brief Returns the estimated megabytes of the files directly in the duplicated directory that
+     *        are also in the original, the same scope as the sketches.
+     * \param[in] duplicate Duplicated directory node.
+     * \param[in] sketch Sketch of the duplicated directory.
+     * \param[in] original Sketch of the original directory.
+     *
+     */
+    static float reclaimable(const DirectoryNode *duplicate, const MinHash &sketch, const MinHash &original);
+
+    /** \brief Returns the sketches of the directories of the given groups, listed again since only the
+     *        reported ones need them. A directory that can't be listed gets the sketch of an empty set.
+     * \param[in] groups Groups of duplicated directories.
+     *
+     */
+    QHash<const DirectoryNode *, MinHash> sketches(const QList<QVector<DirectoryNode *>> &groups);
+
+    /** \brief Removes from the given listing the subdirectories the exclusion rules leave out of the
+     *        scan, so they are never listed, and empties it if the directory is in another file system.
+     * \param[in] node Listed directory node, nullptr for the starting directory.
+     * \param[inout] listing Directory contents.
+     *
+     */
+    void prune(const DirectoryNode *node, DirectoryEnumerator::Listing &listing) const;
+
+    /** \brief Returns the depth of the given directory, 1 for the top-level ones and 0 for nullptr.
+     * \param[in] node Directory node.
+     *
+     */
+    int depth(const DirectoryNode *node) const;
+
+    /** \brief Splits the given groups of directories with the same structure by the contents
+     *        of their files. Files are compared in stages: the sizes are already the same, then
+     *        the partial hashes of all the files are compared and then the full hashes, only of
+     *        the directories that still match. Groups left with less than two directories are removed.
+     * \param[inout] groups Groups of directories with the same signature.
+     * \param[inout] keys Content signatures of the directories, the same only for the directories
+     *                    of a verified group. The verified ones are added with new signatures.
+     *
+     */
+    void verifyContents(QList<QVector<DirectoryNode *>> &groups, QHash<const DirectoryNode *, quint64> &keys);
+
+    /** \brief Gets the paths of the files in the subtree of the given directory, in the same
+     *        order for all the directories with the same structure, and returns false if a
+     *        directory of the subtree couldn't be listed.
+     * \param[in] node Directory node.
+     * \param[in] enumerator Directory enumerator.
+     * \param[out] paths Paths of the files.
+     * \param[out] sizes Sizes of the files.
+     *
+     */
+    bool subtreeFiles(const DirectoryNode *node, DirectoryEnumerator &enumerator, QStringList &paths, QVector<qint64> &sizes) const;
+
+    /** \brief Computes the size of the given directory, whose children have finished, and
+     *        rolls it up into its parent, continuing with the parent if it was the last child.
+     * \param[in] node Directory node.
+     *
+     */
+    void rollUp(DirectoryNode *node);
+
+    /** \brief Gives the directories reached by several paths to the first path in serial
+     *        depth-first order, and the size of each hard linked file to the first directory in
+     *        that order that has it, instead of the first ones the workers listed. The changed
+     *        directories are summarized and indexed again.
+     *
+     */
+    void settle();
+
+    /** \brief Moves the listing and the subtree of a directory to an alias of it, which takes its
+     *        place, and makes it the alias.
+     * \param[in] from Index of the listed directory.
+     * \param[in] to Index of the alias.
+     *
+     */
+    void move(const quint32 from, const quint32 to);
+
+    /** \brief Computes the size, signature and exclusion of the given directory from its files
+     *        and its children.
+     * \param[in] node Directory node.
+     *
+     */
+    void summarize(DirectoryNode *node);
+
+    /** \brief Adds the given directory to the directories table, unless it's excluded.
+     * \param[in] node Directory node.
+     *
+     */
+    void index(DirectoryNode *node);
+
+    /** \brief Removes the given directory from the directories table, unless it's excluded, and
+     *        adds its matching key to the given ones.
+     * \param[in] node Directory node.
+     * \param[inout] keys Matching keys with their normalized names, empty in the signature modes.
+     *
+     */
+    void unindex(DirectoryNode *node, QHash<quint64, QString> &keys);
+
+    /** \brief Returns the normalized name the given directory is matched by in the name modes.
+     * \param[in] node Directory node.
+     *
+     */
+    QString groupName(const DirectoryNode *node) const;
+
+    /** \brief Returns the key the given directory is matched by, its signature or the hash of its
+     *        normalized name.
+     * \param[in] node Directory node.
+     *
+     */
+    quint64 groupKey(const DirectoryNode *node) const;
+
+    /** \brief Adds the matching key of the given directory to the given ones.
+     * \param[in] node Directory node.
+     * \param[inout] keys Matching keys with their normalized names, empty in the signature modes.
+     *
+     */
+    void addKey(const DirectoryNode *node, QHash<quint64, QString> &keys) const;
+
+    /** \brief Updates the statistics of the directories table from its shards.
+     *
+     */
+    void indexStatistics();
+
+    /** \brief Watches the scanned tree and updates it on changes until stopped. The changed
+     *        directories are listed again, the sizes updated up to the top-level directories and
+     *        the groups of the updated directories reported again.
+     *
+     */
+    void watch();
+
+    /** \brief Lists again the given changed directories, updates the tree and the entries of the
+     *        directories table of the changed directories and their ancestors, and replaces the
+     *        reported groups of their matching keys.
+     * \param[in] paths Changed directories, parents before subdirectories.
+     * \param[in] enumerator Directory enumerator.
+     * \param[in] watcher Directory watcher of the tree.
+     *
+     */
+    void refresh(const QStringList &paths, DirectoryEnumerator &enumerator, DirectoryWatcher &watcher);
+
+    /** \brief Updates the number of unwatched directories and reports it if it changed.
+     * \param[in] watcher Directory watcher of the tree.
+     *
+     */
+    void updateUnwatched(const DirectoryWatcher &watcher);
+
+    /** \brief Updates the given list of subdirectories to the given names, keeping the existing
+     *        subtrees, scanning the new ones and deleting the missing ones.
+     * \param[inout] children Subdirectory node indexes.
+     * \param[in] parent Index of the parent of the subdirectories, 0 for the top-level directories.
+     * \param[in] root Index of the starting directory of the subdirectories.
+     * \param[in] names Current subdirectory names in listing order.
+     * \param[in] enumerator Directory enumerator.
+     * \param[in] watcher Directory watcher of the tree.
+     * \param[inout] keys Matching keys of the deleted and new directories.
+     *
+     */
+    void reconcile(QVector<quint32> &children, const quint32 parent, const int root, const QStringList &names, DirectoryEnumerator &enumerator, DirectoryWatcher &watcher, QHash<quint64, QString> &keys);
+
+    /** \brief Lists the subtree of the given new directory, summarizes it and indexes it.
+     * \param[in] index Directory node index.
+     * \param[in] enumerator Directory enumerator.
+     * \param[in] watcher Directory watcher of the tree.
+     * \param[inout] keys Matching keys of the directories of the subtree.
+     *
+     */
+    void scanSubtree(const quint32 index, DirectoryEnumerator &enumerator, DirectoryWatcher &watcher, QHash<quint64, QString> &keys);
+
+    /** \brief Sets the contents of the given directory from its listing, except its shared bytes.
+     * \param[in] node Directory node.
+     * \param[in] listing Directory listing.
+     *
+     */
+    void assign(DirectoryNode *node, const DirectoryEnumerator::Listing &listing) const;
+
+    /** \brief Adds to the given candidates the groups of directories with similar names.
+     * \param[inout] candidates Groups of duplicated directories.
+     *
+     */
+    void similarNames(QList<QVector<DirectoryNode *>> &candidates) const;
+
+    /** \brief Numbers the directories in the order the serial depth-first traversal finishes them.
+     *
+     */
+    void numberDirectories();
+
+    /** \brief Reports the duplicated directories in serial depth-first traversal order.
+     *
+     */
+    void match();
+
+    /** \brief Matches again the groups of the given keys, reporting the removal of their
+     *        previous groups and the new ones.
+     * \param[in] keys Matching keys with their normalized names, empty in the signature modes.
+     *
+     */
+    void rematch(const QHash<quint64, QString> &keys);
+
+    /** \brief Reports the duplicated directories of the given candidate groups and writes the
+     *        results file. Returns false if the scan was stopped.
+     * \param[inout] candidates Groups of directories with the same matching key.
+     * \param[in] replaced Keys of the groups of the results file replaced by the new ones, or
+     *                     nullptr to write only the new groups.
+     *
+     */
+    bool report(QList<QVector<DirectoryNode *>> &candidates, const QSet<quint64> *replaced);
+
+    /** \brief Loads the scan index of the previous scan and the checkpoint of an interrupted one, if any.
+     *
+     */
+    void loadIndex();
+
+    /** \brief Writes the listed directories of the tree to the given index file and returns true on success.
+     * \param[in] fileName Index file name.
+     *
+     */
+    bool writeIndex(const QString &fileName) const;
+
+    /** \brief Writes the scanned tree to the index file.
+     *
+     */
+    void saveIndex();
+
+    /** \brief Frees the scanned tree.
+     *
+     */
+    void clear();
+
+    /** \brief Returns the parent path of the given directory with native separators.
+     * \param[in] node Directory node.
+     *
+     */
+    QString parentPath(const DirectoryNode *node) const;
+
+    /** \brief Returns the full path of the given directory.
+     * \param[in] node Directory node.
+     *
+     */
+    QString path(const DirectoryNode *node) const;
+
+    /** \brief Returns the directory node of the given index, nullptr for 0.
+     * \param[in] index Directory node index.
+     *
+     */
+    DirectoryNode *node(const quint32 index) const
+    { return index ? m_nodes.at(index) : nullptr; }
+
+    /** \brief Returns the index of the given subdirectory of a directory.
+     * \param[in] node Directory node.
+     * \param[in] position Position of the subdirectory in listing order.
+     *
+     */
+    quint32 child(const DirectoryNode *node, const quint32 position) const
+    { return *m_children.at(node->children + position); }
+
+    /** \brief Stores the given subdirectories of a directory in the children arena, reusing its
+     *        current run if they fit in it.
+     * \param[in] node Directory node.
+     * \param[in] children Subdirectory node indexes in listing order.
+     *
+     */
+    void setChildren(DirectoryNode *node, const QVector<quint32> &children);
+
+    /** \brief Returns the subdirectories of the given directory.
+     * \param[in] node Directory node.
+     *
+     */
+    QVector<quint32> children(const DirectoryNode *node) const;
+
+    /** \brief Updates the tree size statistics from the arenas.
+     *
+     */
+    void treeStatistics();
+
+    /** \brief Returns the given name sharing its data with the equal names seen before.
+     * \param[in] name Directory name.
+     *
+     */
+    QString intern(const QString &name);
+
+    static const int SHARDS = 64; /** number of directories table shards. */
+
+    const QStringList                  m_directories; /** starting directories absolute paths.          */
+    const ScanOptions                  m_options;   /** scan configuration.                             */
+    const std::vector<quint64>         m_devices;   /** file systems of the starting directories.       */
+    const std::vector<DeviceGroup>     m_groups;    /** worker groups by device.                        */
+    const int                          m_threads;   /** number of traversal workers of all the groups.  */
+    QVector<quint32>                   m_roots;     /** indexes of the top-level directories.           */
+    std::vector<WorkQueue>             m_queues;    /** worker queues.                                  */
+    Arena<DirectoryNode>               m_nodes;     /** directory nodes, shared by the workers.         */
+    Arena<quint32>                     m_children;  /** runs of subdirectory indexes of the nodes.      */
+    Shard                              m_shards[SHARDS]; /** directories table.                         */
+    std::atomic<int>                   m_remaining; /** queued directories not yet processed.           */
+    std::atomic<int>                   m_inspected; /** directories rolled up.                          */
+    std::atomic<int>                   m_sleeping;  /** idle workers waiting for work.                  */
+    std::atomic<int>                   m_reused;    /** directories reused from the scan index.         */
+    std::atomic<qint64>                m_estimated; /** estimated number of directories of the tree.    */
+    std::atomic<qint64>                m_estimatedBytes; /** estimated size of the files of the tree.   */
+    std::atomic<qint64>                m_bytes;     /** size of the files of the processed directories. */
+    std::atomic<int>                   m_percent;   /** last completion percentage reported.            */
+    mutable Throttle                   m_throttle;  /** background mode limits.                         */
+    int                                m_generation;/** background options applied to the scan thread. */
+    std::unique_ptr<ScanIndex>         m_previous;  /** index of the previous scan, read only.          */
+    std::unique_ptr<ScanIndex>         m_checkpoint;/** checkpoint of the interrupted scan, read only.  */
+    std::atomic<int>                   m_resumed;   /** directories taken from the checkpoint.          */
+    std::atomic<int>                   m_unwatched; /** directories not watched for changes.            */
+    std::atomic<bool>                  m_cancelled; /** true once the scan is stopped.                  */
+    std::atomic<bool>                  m_paused;    /** true while the traversal is paused.             */
+    std::atomic<bool>                  m_holding;   /** true while a checkpoint is being written.       */
+    std::atomic<int>                   m_parked;    /** workers held by a pause or a checkpoint.        */
+    std::atomic<int>                   m_exited;    /** workers that finished the traversal.            */
+    std::atomic<bool>                  m_complete;  /** true once all the results have been reported.   */
+    qint64                             m_started;   /** scan start time in nanoseconds since the epoch. */
+    const FuzzyMatcher                 m_fuzzy;     /** names normalization in SIMILAR mode.            */
+    QHash<QString, quint32>            m_paths;     /** directory indexes by path, only while watching. */
+    QHash<const DirectoryNode *, quint64> m_contentKeys; /** content signatures of the directories of the verified groups. */
+    quint64                            m_verified;  /** number of verified groups, numbers their content signatures. */
+    QHash<quint64, quint64>            m_reported;  /** keys of the reported groups by the matching keys of their directories. */
+    QHash<quint32, QVector<DirectoryEnumerator::Link>> m_links; /** hard linked files of the listed directories by index. */
+    mutable std::mutex                 m_linksMutex;/** protects the hard linked files during the traversal. */
+    ScanStatistics                     m_statistics;/** performance statistics.                        */
+    std::mutex                         m_idleMutex; /** protects the idle condition.                    */
+    std::condition_variable            m_idle;      /** signals idle workers there is work or finished. */
+};
+
+#endif /* SCANTHREAD_H_ */
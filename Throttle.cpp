@@ -0,0 +1,272 @@
+/*
+ File: Throttle.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "Throttle.h"
+
+// Qt
+#include <QStringList>
+
+// C++
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+// Linux
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  const double LATENCY_FACTOR{2.};      /** average over the usual latency that starts the backoff. */
+  const double LATENCY_WEIGHT{0.05};    /** weight of each operation in the moving average.        */
+  const double BASELINE_DRIFT{0.001};   /** rate the usual latency follows a higher average.       */
+  const double MIN_BACKOFF{0.25};       /** first backoff, time slept per time spent.              */
+  const double MAX_BACKOFF{16.};        /** largest backoff.                                       */
+  const double BACKOFF_DECAY{0.9};      /** backoff reduction while the latency is normal.         */
+  const qint64 SLEEP_SLICE{50000000LL}; /** longest uninterrupted sleep, in nanoseconds.           */
+
+#ifdef Q_OS_LINUX
+  const int IOPRIO_WHO_PROCESS{1};  /** ioprio_set() target of a single thread. */
+  const int IOPRIO_CLASS_SHIFT{13}; /** position of the class in the priority.  */
+  const int IOPRIO_CLASS_IDLE{3};   /** only served when the disk is idle.      */
+  const int LOWEST_NICE{19};        /** lowest CPU priority.                    */
+#endif
+}
+
+//--------------------------------------------------------------------
+bool ThrottleOptions::parse(const QString &text, QString &error)
+{
+  ThrottleOptions options;
+
+  const auto lines = text.split('\n');
+  for(int i = 0; i < lines.size(); ++i)
+  {
+    const auto line = lines.at(i).trimmed();
+    if(line.isEmpty() || line.startsWith('#')) continue;
+
+    const auto separator = line.indexOf(' ');
+    const auto keyword   = line.left(separator).toLower();
+    const auto argument  = separator < 0 ? QString() : line.mid(separator + 1).trimmed().toLower();
+
+    bool ok = true;
+    if(keyword == "priority")
+    {
+      ok = argument == "low" || argument == "normal";
+      options.lowPriority = argument == "low";
+    }
+    else if(keyword == "operations")
+    {
+      options.operations = argument.toInt(&ok);
+      ok &= options.operations >= 0;
+    }
+    else if(keyword == "read")
+    {
+      const auto megabytes = argument.toDouble(&ok);
+      ok &= megabytes >= 0.;
+      options.bytes = static_cast<qint64>(megabytes * 1024 * 1024);
+    }
+    else if(keyword == "backoff")
+    {
+      ok = argument == "on" || argument == "off";
+      options.backoff = argument == "on";
+    }
+    else
+    {
+      ok = false;
+    }
+
+    if(!ok)
+    {
+      error = QString("Invalid setting in line %1: %2").arg(i + 1).arg(line);
+      return false;
+    }
+  }
+
+  *this = options;
+
+  return true;
+}
+
+//--------------------------------------------------------------------
+Throttle::Throttle(const ThrottleOptions &options)
+: m_options   (options)
+, m_operations{static_cast<double>(options.operations), 0., 0}
+, m_bytes     {static_cast<double>(options.bytes), 0., 0}
+, m_latency   {0.}
+, m_baseline  {0.}
+, m_backoff   {0.}
+, m_generation{0}
+, m_cancelled {false}
+, m_waited    {0}
+{
+  m_clock.start();
+
+  // a full bucket allows a second worth of operations at once.
+  m_operations.tokens = m_operations.rate;
+  m_bytes.tokens      = m_bytes.rate;
+}
+
+//--------------------------------------------------------------------
+void Throttle::setOptions(const ThrottleOptions &options)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_options = options;
+
+    m_operations.rate   = options.operations;
+    m_operations.tokens = std::min(m_operations.tokens, m_operations.rate);
+    m_bytes.rate        = static_cast<double>(options.bytes);
+    m_bytes.tokens      = std::min(m_bytes.tokens, m_bytes.rate);
+
+    if(!options.backoff) m_backoff = 0.;
+  }
+
+  ++m_generation;
+}
+
+//--------------------------------------------------------------------
+ThrottleOptions Throttle::options() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  return m_options;
+}
+
+//--------------------------------------------------------------------
+void Throttle::prioritize(int &generation)
+{
+  const auto current = m_generation.load();
+  if(generation == current) return;
+
+  // a thread that never lowered its priority doesn't need to restore it.
+  const auto low = options().lowPriority && !m_cancelled;
+  if(low || generation != -1) setPriority(low);
+
+  generation = current;
+}
+
+//--------------------------------------------------------------------
+void Throttle::operations(const qint64 count, const qint64 nanoseconds)
+{
+  if(m_cancelled || count <= 0) return;
+
+  qint64 wait = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(m_options.backoff)
+    {
+      const auto latency = static_cast<double>(nanoseconds) / count;
+      m_latency = m_latency == 0. ? latency : m_latency + LATENCY_WEIGHT * (latency - m_latency);
+
+      // the usual latency is the lowest average, slowly following the average up.
+      if(m_baseline == 0. || m_latency < m_baseline) m_baseline = m_latency;
+      else                                           m_baseline += BASELINE_DRIFT * (m_latency - m_baseline);
+
+      if(m_latency > LATENCY_FACTOR * m_baseline)
+      {
+        m_backoff = std::min(MAX_BACKOFF, std::max(MIN_BACKOFF, 2. * m_backoff));
+      }
+      else
+      {
+        m_backoff *= BACKOFF_DECAY;
+        if(m_backoff < MIN_BACKOFF / 2.) m_backoff = 0.;
+      }
+
+      wait += static_cast<qint64>(m_backoff * nanoseconds);
+    }
+
+    wait += take(m_operations, count);
+  }
+
+  sleep(wait);
+}
+
+//--------------------------------------------------------------------
+void Throttle::read(const qint64 bytes)
+{
+  if(m_cancelled || bytes <= 0) return;
+
+  qint64 wait = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    wait = take(m_bytes, bytes);
+  }
+
+  sleep(wait);
+}
+
+//--------------------------------------------------------------------
+void Throttle::cancel()
+{
+  m_cancelled = true;
+  ++m_generation;
+}
+
+//--------------------------------------------------------------------
+qint64 Throttle::take(Bucket &bucket, const double amount)
+{
+  if(bucket.rate <= 0.) return 0;
+
+  const auto now = m_clock.nsecsElapsed();
+  bucket.tokens = std::min(bucket.rate, bucket.tokens + bucket.rate * (now - bucket.last) / 1e9);
+  bucket.last   = now;
+  bucket.tokens -= amount;
+
+  return bucket.tokens < 0. ? static_cast<qint64>(-bucket.tokens / bucket.rate * 1e9) : 0;
+}
+
+//--------------------------------------------------------------------
+void Throttle::sleep(const qint64 nanoseconds)
+{
+  if(nanoseconds <= 0) return;
+
+  m_waited += nanoseconds;
+
+  const auto generation = m_generation.load();
+  for(qint64 left = nanoseconds; left > 0 && !m_cancelled && generation == m_generation; left -= SLEEP_SLICE)
+  {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(std::min(left, SLEEP_SLICE)));
+  }
+}
+
+//--------------------------------------------------------------------
+bool Throttle::setPriority(const bool low)
+{
+#ifdef Q_OS_LINUX
+  // both only change the calling thread, the kernel keeps them per thread. Raising the CPU
+  // priority back may not be allowed, it's kept low then.
+  const auto thread = static_cast<id_t>(syscall(SYS_gettid));
+  const auto ioPriority = low ? (IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) : 0;
+
+  const auto io  = syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, ioPriority) == 0;
+  const auto cpu = setpriority(PRIO_PROCESS, thread, low ? LOWEST_NICE : 0) == 0;
+
+  return io && cpu;
+#else
+  Q_UNUSED(low);
+
+  return false;
+#endif
+}
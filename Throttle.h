@@ -0,0 +1,170 @@
+/*
+ File: Throttle.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THROTTLE_H_
+#define THROTTLE_H_
+
+// Qt
+#include <QString>
+#include <QElapsedTimer>
+
+// C++
+#include <atomic>
+#include <mutex>
+
+/** \struct ThrottleOptions
+ * \brief Background mode configuration.
+ *
+ */
+struct ThrottleOptions
+{
+  bool   lowPriority; /** true to run the scan threads in the idle I/O class and at the lowest CPU priority. */
+  int    operations;  /** metadata operations per second, 0 for no limit.                  */
+  qint64 bytes;       /** bytes of file contents read per second, 0 for no limit.          */
+  bool   backoff;     /** true to slow down while the latency of the listings is high.     */
+
+  ThrottleOptions(): lowPriority{false}, operations{0}, bytes{0}, backoff{false} {};
+
+  /** \brief Returns true if any of the controls is enabled.
+   *
+   */
+  bool isEnabled() const
+  { return lowPriority || operations > 0 || bytes > 0 || backoff; }
+
+  /** \brief Replaces the options with the ones of the given text and returns true on success. On
+   *        error the options are left unchanged. The text has one setting per line:
+   *        - priority <low|normal>
+   *        - operations <per second, 0 for no limit>
+   *        - read <megabytes per second, 0 for no limit>
+   *        - backoff <on|off>
+   *        Empty lines and lines starting with '#' are ignored.
+   * \param[in] text Settings, one per line.
+   * \param[out] error Description of the first invalid line.
+   *
+   */
+  bool parse(const QString &text, QString &error);
+};
+
+/** \class Throttle
+ * \brief Keeps a scan from competing with the other users of the storage. Metadata operations
+ *        and bytes read are limited with token buckets, the callers sleep for the tokens they
+ *        take beyond the rate. With backoff the callers also sleep a multiple of the time their
+ *        operations took, doubled while the average latency is well over its usual value and
+ *        reduced while it's back. The options can be changed at any time from any thread, the
+ *        threads pick the new priority at their next call to prioritize().
+ *
+ */
+class Throttle
+{
+  public:
+    /** \brief Throttle class constructor.
+     * \param[in] options Background mode configuration.
+     *
+     */
+    explicit Throttle(const ThrottleOptions &options = ThrottleOptions());
+
+    /** \brief Replaces the options. Can be called from any thread.
+     * \param[in] options Background mode configuration.
+     *
+     */
+    void setOptions(const ThrottleOptions &options);
+
+    /** \brief Returns the current options.
+     *
+     */
+    ThrottleOptions options() const;
+
+    /** \brief Sets the priority of the calling thread if the options changed since the given
+     *        generation, which is updated. Start with -1 in each thread.
+     * \param[inout] generation Options generation applied to the thread.
+     *
+     */
+    void prioritize(int &generation);
+
+    /** \brief Accounts the given metadata operations, done in the given time, and sleeps as
+     *        long as the limits require.
+     * \param[in] count Number of operations.
+     * \param[in] nanoseconds Time spent in them.
+     *
+     */
+    void operations(const qint64 count, const qint64 nanoseconds);
+
+    /** \brief Accounts the given bytes read and sleeps as long as the limit requires.
+     * \param[in] bytes Bytes read.
+     *
+     */
+    void read(const qint64 bytes);
+
+    /** \brief Wakes the sleeping threads and stops throttling, for a scan being stopped.
+     *
+     */
+    void cancel();
+
+    /** \brief Returns the total time the threads have slept, in nanoseconds.
+     *
+     */
+    qint64 waited() const
+    { return m_waited.load(); }
+
+  private:
+    /** \struct Bucket
+     * \brief Token bucket. Tokens can go negative, the debt is the time to wait.
+     *
+     */
+    struct Bucket
+    {
+      double rate;   /** tokens per second, 0 for no limit.   */
+      double tokens; /** tokens available.                    */
+      qint64 last;   /** time of the last refill, in nanoseconds. */
+    };
+
+    /** \brief Takes the given tokens from the bucket and returns the nanoseconds to wait for them.
+     *        Must be called with the mutex held.
+     * \param[in] bucket Token bucket.
+     * \param[in] amount Number of tokens.
+     *
+     */
+    qint64 take(Bucket &bucket, const double amount);
+
+    /** \brief Sleeps the given time, waking early if the options change or throttling is cancelled.
+     * \param[in] nanoseconds Time to sleep.
+     *
+     */
+    void sleep(const qint64 nanoseconds);
+
+    /** \brief Sets the I/O class and CPU priority of the calling thread, returns false if not allowed.
+     * \param[in] low True for the idle class and lowest priority, false for the default ones.
+     *
+     */
+    static bool setPriority(const bool low);
+
+    mutable std::mutex  m_mutex;      /** protects the options, buckets and latencies. */
+    ThrottleOptions     m_options;    /** background mode configuration.               */
+    Bucket              m_operations; /** metadata operations bucket.                  */
+    Bucket              m_bytes;      /** bytes read bucket.                           */
+    double              m_latency;    /** moving average of the time of an operation, in nanoseconds. */
+    double              m_baseline;   /** usual time of an operation, in nanoseconds.  */
+    double              m_backoff;    /** time slept per time spent in operations.     */
+    QElapsedTimer       m_clock;      /** time since the construction.                 */
+    std::atomic<int>    m_generation; /** incremented when the options change.         */
+    std::atomic<bool>   m_cancelled;  /** true once throttling is cancelled.           */
+    std::atomic<qint64> m_waited;     /** total time slept, in nanoseconds.            */
+};
+
+#endif /* THROTTLE_H_ */
@@ -0,0 +1,482 @@
+/*
+ File: Benchmark.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "TreeGenerator.h"
+#include "DirectoryEnumerator.h"
+#include "DuplicatesModel.h"
+#include "Hasher.h"
+#include "NameIndex.h"
+#include "ScanThread.h"
+#include "FuzzyMatcher.h"
+#include "ResultFile.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTemporaryDir>
+
+// C++
+#include <iostream>
+#include <memory>
+
+namespace
+{
+  /** \brief Returns a benchmark result.
+   * \param[in] name Benchmark name.
+   * \param[in] operations Number of operations measured.
+   * \param[in] nanoseconds Elapsed time.
+   *
+   */
+  QJsonObject result(const QString &name, const qint64 operations, const qint64 nanoseconds)
+  {
+    QJsonObject object;
+    object.insert("name",           name);
+    object.insert("operations",     static_cast<double>(operations));
+    object.insert("milliseconds",   nanoseconds / 1e6);
+    object.insert("nsPerOperation", operations > 0 ? static_cast<double>(nanoseconds) / operations : 0.);
+
+    std::cerr << name.toStdString() << ": " << nanoseconds / 1e6 << " ms" << std::endl;
+
+    return object;
+  }
+
+  /** \brief Lists every directory of the tree with the given backend and returns the listed paths.
+   * \param[in] root Tree root.
+   * \param[in] backend Enumeration backend.
+   * \param[in] details True to get the names and sizes of the files.
+   *
+   */
+  qint64 listTree(const QString &root, const DirectoryEnumerator::Backend backend, const bool details)
+  {
+    std::unique_ptr<DirectoryEnumerator> enumerator(DirectoryEnumerator::create(backend));
+
+    qint64 listed = 0;
+    QStringList pending{root};
+    while(!pending.isEmpty())
+    {
+      const auto path = pending.takeLast();
+
+      DirectoryEnumerator::Listing listing(details);
+      enumerator->list(path, listing);
+      ++listed;
+
+      for(const auto &name: listing.directories) pending << path + "/" + name;
+    }
+
+    return listed;
+  }
+
+  /** \brief Returns the names of all the directories of the tree.
+   * \param[in] root Tree root.
+   *
+   */
+  QStringList treeNames(const QString &root)
+  {
+    std::unique_ptr<DirectoryEnumerator> enumerator(DirectoryEnumerator::create(DirectoryEnumerator::Backend::NATIVE));
+
+    QStringList names;
+    QStringList pending{root};
+    while(!pending.isEmpty())
+    {
+      const auto path = pending.takeLast();
+
+      DirectoryEnumerator::Listing listing;
+      enumerator->list(path, listing);
+
+      for(const auto &name: listing.directories)
+      {
+        names << name;
+        pending << path + "/" + name;
+      }
+    }
+
+    return names;
+  }
+
+  /** \brief Measures the enumeration backends.
+   * \param[in] root Tree root.
+   * \param[out] results Benchmark results.
+   *
+   */
+  void enumeration(const QString &root, QJsonArray &results)
+  {
+    QElapsedTimer timer;
+
+    QList<QPair<QString, DirectoryEnumerator::Backend>> backends;
+    backends << qMakePair(QString("qt"), DirectoryEnumerator::Backend::QT);
+    if(DirectoryEnumerator::isNativeAvailable()) backends << qMakePair(QString("native"), DirectoryEnumerator::Backend::NATIVE);
+    if(DirectoryEnumerator::isUringAvailable())  backends << qMakePair(QString("uring"), DirectoryEnumerator::Backend::URING);
+
+    for(const auto &backend: backends)
+    {
+      for(const auto details: {false, true})
+      {
+        timer.start();
+        const auto listed = listTree(root, backend.second, details);
+        results.append(result(QString("enumeration/%1%2").arg(backend.first).arg(details ? "/details" : ""), listed, timer.nsecsElapsed()));
+      }
+    }
+  }
+
+  /** \brief Measures the name normalization and hashing and the duplicates index.
+   * \param[in] names Directory names.
+   * \param[out] results Benchmark results.
+   *
+   */
+  void nameIndex(const QStringList &names, QJsonArray &results)
+  {
+    QElapsedTimer timer;
+
+    timer.start();
+    QStringList normalized;
+    normalized.reserve(names.size());
+    for(const auto &name: names) normalized << name.toLower();
+    results.append(result("names/normalize", names.size(), timer.nsecsElapsed()));
+
+    timer.start();
+    QVector<quint64> hashes;
+    hashes.reserve(names.size());
+    for(const auto &name: normalized) hashes << NameIndex<int>::hash(name);
+    results.append(result("names/hash", names.size(), timer.nsecsElapsed()));
+
+    NameIndex<int> index;
+    timer.start();
+    for(int i = 0; i < normalized.size(); ++i) index.insert(normalized.at(i), hashes.at(i), i);
+    results.append(result("index/insert", names.size(), timer.nsecsElapsed()));
+
+    qint64 found = 0;
+    timer.start();
+    for(int i = 0; i < normalized.size(); ++i) found += (index.find(normalized.at(i), hashes.at(i)) >= 0);
+    auto lookup = result("index/lookup", names.size(), timer.nsecsElapsed());
+    lookup.insert("groups", index.groups());
+    lookup.insert("found",  static_cast<double>(found));
+    results.append(lookup);
+
+    const FuzzyMatcher matcher;
+    timer.start();
+    QSet<QString> similar;
+    for(const auto &name: names) similar.insert(matcher.normalize(name));
+    results.append(result("names/fuzzy-normalize", names.size(), timer.nsecsElapsed()));
+
+    QStringList distinct;
+    for(const auto &name: similar) distinct << name;
+
+    timer.start();
+    const auto clusters = matcher.cluster(distinct);
+    auto clustering = result("names/fuzzy-cluster", distinct.size(), timer.nsecsElapsed());
+
+    int count = 0;
+    for(int i = 0; i < clusters.size(); ++i) count += (clusters.at(i) == i);
+    clustering.insert("clusters", count);
+    results.append(clustering);
+  }
+
+  /** \brief Measures the content hash throughput.
+   * \param[out] results Benchmark results.
+   *
+   */
+  void hashing(QJsonArray &results)
+  {
+    const int SIZE = 64*1024*1024;
+    QByteArray data(SIZE, Qt::Uninitialized);
+    auto bytes = data.data();
+    for(int i = 0; i < SIZE; ++i) bytes[i] = static_cast<char>(i * 31 + (i >> 8));
+
+    QElapsedTimer timer;
+    timer.start();
+    const auto hash = Hasher::hash(data.constData(), data.size());
+    auto object = result("hash/xxh64/64MiB", SIZE, timer.nsecsElapsed());
+    object.insert("hash", QString::number(hash, 16));
+    results.append(object);
+
+    quint64 value = 0;
+    timer.start();
+    for(int i = 0; i < 1000000; ++i) value += Hasher::mix(static_cast<quint64>(i));
+    object = result("hash/mix", 1000000, timer.nsecsElapsed());
+    object.insert("hash", QString::number(value, 16));
+    results.append(object);
+  }
+
+  /** \brief Measures the delivery of results to the table model, one by one and in batches.
+   * \param[out] results Benchmark results.
+   *
+   */
+  void delivery(QJsonArray &results)
+  {
+    const int COUNT = 1000000;
+    const int BATCH = 4096;
+
+    DuplicateBatch duplicates;
+    duplicates.reserve(COUNT);
+    for(int i = 0; i < COUNT; ++i)
+    {
+      duplicates << Duplicate{QString("folder %1").arg(i % 1000), "/original/parent/", 1.f, QString("folder %1").arg(i % 1000), "/duplicate/parent/", 1.f, 1.f, 1.f, static_cast<quint64>(i % 1000)};
+    }
+
+    QElapsedTimer timer;
+    {
+      DuplicatesModel model;
+      timer.start();
+      for(const auto &duplicate: duplicates) model.append(DuplicateBatch{duplicate});
+      results.append(result("delivery/single", COUNT, timer.nsecsElapsed()));
+    }
+
+    {
+      DuplicatesModel model;
+      timer.start();
+      for(int i = 0; i < COUNT; i += BATCH) model.append(duplicates.mid(i, BATCH));
+      results.append(result("delivery/batched", COUNT, timer.nsecsElapsed()));
+    }
+  }
+
+  /** \brief Measures the writing, reading and comparison of the results of two scans, with
+   *        some of the groups of the first one resolved, grown or new in the second.
+   * \param[out] results Benchmark results.
+   *
+   */
+  void comparison(QJsonArray &results)
+  {
+    const int COUNT = 1000000;
+
+    auto group = [](const int i, const int members)
+    {
+      DuplicateGroup result;
+      result.key = Hasher::mix(static_cast<quint64>(i));
+      for(int j = 0; j < members; ++j)
+      {
+        result.names   << QString("folder %1").arg(i);
+        result.parents << QString("/share/copy %1/").arg(j);
+        result.sizes   << 1.f;
+      }
+
+      return result;
+    };
+
+    QTemporaryDir directory;
+    const auto beforeFile = directory.path() + "/before.results";
+    const auto afterFile  = directory.path() + "/after.results";
+
+    // every tenth group is resolved, grown or new in the later scan.
+    QElapsedTimer timer;
+    timer.start();
+    ResultFile before;
+    before.create(beforeFile, "/share", ScanOptions::Mode::NAMES);
+    for(int i = 0; i < COUNT; ++i)
+    {
+      if(i % 10 != 1) before.append(group(i, 2));
+    }
+    before.commit();
+    results.append(result("results/write", before.groups(), timer.nsecsElapsed()));
+
+    ResultFile after;
+    after.create(afterFile, "/share", ScanOptions::Mode::NAMES);
+    for(int i = 0; i < COUNT; ++i)
+    {
+      if(i % 10 != 2) after.append(group(i, i % 10 == 3 ? 3 : 2));
+    }
+    after.commit();
+
+    // the rows are read from the map in a random order, as a scrolled table would.
+    qint64 characters = 0;
+    timer.start();
+    after.open(afterFile);
+    const auto rows = after.rows();
+    for(qint64 i = 0; i < rows; ++i)
+    {
+      characters += after.duplicate(Hasher::mix(static_cast<quint64>(i)) % rows).name2.size();
+    }
+    auto object = result("results/rows", rows, timer.nsecsElapsed());
+    object.insert("characters", static_cast<double>(characters));
+    results.append(object);
+    after.close();
+
+    qint64 changes = 0;
+    timer.start();
+    const auto ok = ResultFile::diff(beforeFile, afterFile, [&changes](const ResultFile::Change change, const DuplicateGroup &, const DuplicateGroup &)
+    { if(change != ResultFile::Change::UNCHANGED) ++changes; });
+
+    object = result("results/diff", 2 * COUNT, timer.nsecsElapsed());
+    object.insert("changes", static_cast<double>(changes));
+    object.insert("valid",   ok);
+    results.append(object);
+  }
+
+  /** \brief Measures complete scans of the tree.
+   * \param[in] root Tree root.
+   * \param[in] threads Traversal threads.
+   * \param[out] results Benchmark results.
+   *
+   */
+  void scan(const QString &root, const int threads, QJsonArray &results)
+  {
+    QList<QPair<QString, ScanOptions::Mode>> modes;
+    modes << qMakePair(QString("names"),     ScanOptions::Mode::NAMES)
+          << qMakePair(QString("structure"), ScanOptions::Mode::STRUCTURE)
+          << qMakePair(QString("content"),   ScanOptions::Mode::CONTENT)
+          << qMakePair(QString("similar"),   ScanOptions::Mode::SIMILAR);
+
+    for(const auto &mode: modes)
+    {
+      ScanOptions options;
+      options.threads = threads;
+      options.mode    = mode.second;
+
+      int groups = 0;
+      ScanThread thread(QDir(root), options);
+      QObject::connect(&thread, &ScanThread::foundGroup, [&groups](const DuplicateGroup &) { ++groups; });
+
+      QElapsedTimer timer;
+      timer.start();
+      thread.start();
+      thread.wait();
+
+      auto object = result(QString("scan/%1").arg(mode.first), thread.inspected(), timer.nsecsElapsed());
+      // memory of the tree per directory, and of the same tree linked by pointers for comparison.
+      const auto statistics = thread.statistics();
+      object.insert("threads", thread.threads());
+      object.insert("groups",  groups);
+      object.insert("bytesPerNode",        statistics.bytesPerNode());
+      object.insert("pointerBytesPerNode", statistics.bytesPerNode(true));
+      object.insert("statistics", statistics.toJson());
+      results.append(object);
+    }
+  }
+}
+
+//-----------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Generates a synthetic directory tree and measures the scan components on it.");
+  parser.addHelpOption();
+
+  TreeGenerator::Parameters parameters;
+
+  const QCommandLineOption rootOption      ("root",        "Directory where the tree is generated and kept, a temporary one by default.", "path");
+  const QCommandLineOption keepOption      ("keep",        "Keep the temporary tree.");
+  const QCommandLineOption seedOption      ("seed",        "Random seed.", "value", QString::number(parameters.seed));
+  const QCommandLineOption fanoutOption    ("fanout",      "Subdirectories per directory.", "count", QString::number(parameters.fanout));
+  const QCommandLineOption depthOption     ("depth",       "Levels of directories.", "count", QString::number(parameters.depth));
+  const QCommandLineOption collisionOption ("collisions",  "Probability of a shared directory name.", "rate", QString::number(parameters.collisions));
+  const QCommandLineOption copiesOption    ("copies",      "Probability of a directory being a copy of another.", "rate", QString::number(parameters.copies));
+  const QCommandLineOption filesOption     ("files",       "Files per directory.", "count", QString::number(parameters.files));
+  const QCommandLineOption minSizeOption   ("min-size",    "Minimum file size in bytes.", "bytes", QString::number(parameters.minSize));
+  const QCommandLineOption maxSizeOption   ("max-size",    "Maximum file size in bytes.", "bytes", QString::number(parameters.maxSize));
+  const QCommandLineOption contentsOption  ("contents",    "Write random contents at the start of the files.");
+  const QCommandLineOption threadsOption   ("threads",     "Traversal threads of the scans, 0 to use the number of cores.", "count", "0");
+  const QCommandLineOption outputOption    ("output",      "File of the JSON results, the standard output by default.", "file");
+
+  parser.addOptions({rootOption, keepOption, seedOption, fanoutOption, depthOption, collisionOption, copiesOption, filesOption,
+                     minSizeOption, maxSizeOption, contentsOption, threadsOption, outputOption});
+  parser.process(app);
+
+  parameters.seed       = parser.value(seedOption).toULongLong();
+  parameters.fanout     = parser.value(fanoutOption).toInt();
+  parameters.depth      = parser.value(depthOption).toInt();
+  parameters.collisions = parser.value(collisionOption).toDouble();
+  parameters.copies     = parser.value(copiesOption).toDouble();
+  parameters.files      = parser.value(filesOption).toInt();
+  parameters.minSize    = parser.value(minSizeOption).toLongLong();
+  parameters.maxSize    = parser.value(maxSizeOption).toLongLong();
+  parameters.contents   = parser.isSet(contentsOption);
+
+  // tmpfs keeps the tree in memory, so the scans measure the code and not the disk.
+  std::unique_ptr<QTemporaryDir> temporary;
+  if(!parser.isSet(rootOption))
+  {
+    const auto base = QDir("/dev/shm").exists() ? QString("/dev/shm") : QDir::tempPath();
+    temporary.reset(new QTemporaryDir(base + "/duplicates-benchmark-XXXXXX"));
+    temporary->setAutoRemove(!parser.isSet(keepOption));
+  }
+
+  const auto root = temporary ? temporary->path() : QDir(parser.value(rootOption)).absolutePath();
+  if(root.isEmpty() || !QDir().mkpath(root))
+  {
+    std::cerr << "Unable to create the tree root: " << root.toStdString() << std::endl;
+    return 1;
+  }
+
+  TreeGenerator generator{parameters};
+
+  QElapsedTimer timer;
+  timer.start();
+  if(!generator.generate(root))
+  {
+    std::cerr << "Unable to generate the tree in " << root.toStdString() << std::endl;
+    return 1;
+  }
+
+  QJsonObject tree;
+  tree.insert("root",        root);
+  tree.insert("seed",        QString::number(parameters.seed));
+  tree.insert("fanout",      parameters.fanout);
+  tree.insert("depth",       parameters.depth);
+  tree.insert("collisions",  parameters.collisions);
+  tree.insert("copies",      parameters.copies);
+  tree.insert("files",       parameters.files);
+  tree.insert("minSize",     static_cast<double>(parameters.minSize));
+  tree.insert("maxSize",     static_cast<double>(parameters.maxSize));
+  tree.insert("contents",    parameters.contents);
+  tree.insert("directories", static_cast<double>(generator.directories()));
+  tree.insert("fileCount",   static_cast<double>(generator.files()));
+  tree.insert("bytes",       static_cast<double>(generator.bytes()));
+  tree.insert("milliseconds", timer.nsecsElapsed() / 1e6);
+
+  QJsonArray results;
+  enumeration(root, results);
+  nameIndex(treeNames(root), results);
+  hashing(results);
+  delivery(results);
+  comparison(results);
+  scan(root, parser.value(threadsOption).toInt(), results);
+
+  QJsonObject report;
+  report.insert("qt",         QString(qVersion()));
+  report.insert("cores",      QThread::idealThreadCount());
+  report.insert("tree",       tree);
+  report.insert("benchmarks", results);
+
+  const auto data = QJsonDocument(report).toJson();
+  if(parser.isSet(outputOption))
+  {
+    QFile file{parser.value(outputOption)};
+    if(!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+    {
+      std::cerr << "Unable to write the results to " << parser.value(outputOption).toStdString() << std::endl;
+      return 1;
+    }
+  }
+  else
+  {
+    std::cout << data.constData();
+  }
+
+  return 0;
+}
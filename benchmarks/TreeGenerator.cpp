@@ -0,0 +1,141 @@
+/*
+ File: TreeGenerator.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "TreeGenerator.h"
+
+// Qt
+#include <QDir>
+#include <QFile>
+#include <QSet>
+
+// C++
+#include <cmath>
+
+const int TreeGenerator::POOL_SIZE;
+
+namespace
+{
+  const qint64 CONTENTS_SIZE{4096}; /** bytes written at the start of the files with contents. */
+}
+
+//--------------------------------------------------------------------
+quint64 TreeGenerator::Random::next()
+{
+  auto value = (m_state += 0x9E3779B97F4A7C15ULL);
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+
+  return value ^ (value >> 31);
+}
+
+//--------------------------------------------------------------------
+double TreeGenerator::Random::uniform()
+{
+  return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+//--------------------------------------------------------------------
+TreeGenerator::TreeGenerator(const Parameters& parameters)
+: m_parameters (parameters)
+, m_directories{0}
+, m_files      {0}
+, m_bytes      {0}
+{
+}
+
+//--------------------------------------------------------------------
+bool TreeGenerator::generate(const QString& root)
+{
+  m_seeds.clear();
+  m_directories = m_files = m_bytes = 0;
+
+  return generate(root, m_parameters.depth, m_parameters.seed);
+}
+
+//--------------------------------------------------------------------
+bool TreeGenerator::generate(const QString& path, const int level, const quint64 seed)
+{
+  Random random{seed};
+
+  const auto logMin = std::log(static_cast<double>(std::max<qint64>(1, m_parameters.minSize)));
+  const auto logMax = std::log(static_cast<double>(std::max(m_parameters.minSize, m_parameters.maxSize)));
+
+  for(int i = 0; i < m_parameters.files; ++i)
+  {
+    const auto size = static_cast<qint64>(std::exp(logMin + random.uniform() * (logMax - logMin)));
+
+    QFile file{path + QString("/file-%1.dat").arg(i)};
+    if(!file.open(QIODevice::WriteOnly)) return false;
+
+    if(m_parameters.contents)
+    {
+      QByteArray data(static_cast<int>(std::min(size, CONTENTS_SIZE)), Qt::Uninitialized);
+      for(int j = 0; j < data.size(); j += 8)
+      {
+        const auto value = random.next();
+        for(int k = 0; k < 8 && j + k < data.size(); ++k) data.data()[j + k] = static_cast<char>(value >> (8*k));
+      }
+
+      file.write(data);
+    }
+
+    if(!file.resize(size)) return false;
+
+    ++m_files;
+    m_bytes += size;
+  }
+
+  if(level == 0) return true;
+
+  auto &seeds = m_seeds[level - 1];
+
+  QSet<QString> names;
+  for(int i = 0; i < m_parameters.fanout; ++i)
+  {
+    QString name;
+    if(random.uniform() < m_parameters.collisions)
+    {
+      name = QString("shared-%1").arg(random.next() % POOL_SIZE, 2, 10, QChar('0'));
+    }
+
+    if(name.isEmpty() || names.contains(name))
+    {
+      name = QString("d%1").arg(random.next(), 16, 16, QChar('0'));
+    }
+    names.insert(name);
+
+    auto childSeed = random.next();
+    if(!seeds.isEmpty() && random.uniform() < m_parameters.copies)
+    {
+      childSeed = seeds.at(random.next() % seeds.size());
+    }
+    else if(seeds.size() < POOL_SIZE)
+    {
+      seeds << childSeed;
+    }
+
+    const auto childPath = path + "/" + name;
+    if(!QDir().mkdir(childPath) || !generate(childPath, level - 1, childSeed)) return false;
+
+    ++m_directories;
+  }
+
+  return true;
+}
@@ -0,0 +1,129 @@
+/*
+ File: TreeGenerator.h
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TREEGENERATOR_H_
+#define TREEGENERATOR_H_
+
+// Qt
+#include <QString>
+#include <QMap>
+#include <QVector>
+
+/** \class TreeGenerator
+ * \brief Creates synthetic directory trees for benchmarking. The same parameters always give
+ *        the same tree: every directory is generated from its own seed, so a directory that
+ *        reuses the seed of another one of the same depth is an exact copy of it, with the
+ *        same subdirectories, files, sizes and contents. Files are created sparse, only their
+ *        first bytes are written when contents are requested.
+ *
+ */
+class TreeGenerator
+{
+  public:
+    /** \struct Parameters
+     * \brief Shape of the generated tree.
+     *
+     */
+    struct Parameters
+    {
+      quint64 seed;       /** random seed.                                                   */
+      int     fanout;     /** subdirectories of every directory above the leaves.            */
+      int     depth;      /** levels of directories below the root.                          */
+      double  collisions; /** probability of a directory taking a name of the shared pool.   */
+      double  copies;     /** probability of a directory being a copy of a previous one.     */
+      int     files;      /** files of every directory.                                      */
+      qint64  minSize;    /** minimum file size in bytes.                                    */
+      qint64  maxSize;    /** maximum file size in bytes, sizes are log-uniform distributed. */
+      bool    contents;   /** true to write random contents at the start of the files.       */
+
+      Parameters(): seed{1}, fanout{8}, depth{4}, collisions{0.2}, copies{0.05}, files{4}, minSize{1024}, maxSize{1024*1024}, contents{false} {};
+    };
+
+    /** \brief TreeGenerator class constructor.
+     * \param[in] parameters Tree shape.
+     *
+     */
+    explicit TreeGenerator(const Parameters &parameters);
+
+    /** \brief Creates the tree in the given directory, that must exist, and returns true on success.
+     * \param[in] root Directory absolute path.
+     *
+     */
+    bool generate(const QString &root);
+
+    /** \brief Returns the number of directories created.
+     *
+     */
+    qint64 directories() const
+    { return m_directories; }
+
+    /** \brief Returns the number of files created.
+     *
+     */
+    qint64 files() const
+    { return m_files; }
+
+    /** \brief Returns the sum of the sizes of the files created.
+     *
+     */
+    qint64 bytes() const
+    { return m_bytes; }
+
+  private:
+    /** \class Random
+     * \brief SplitMix64 generator, the same results in every platform and compiler.
+     *
+     */
+    class Random
+    {
+      public:
+        explicit Random(const quint64 seed): m_state{seed} {};
+
+        /** \brief Returns the next 64 bits random value.
+         *
+         */
+        quint64 next();
+
+        /** \brief Returns a random value in [0, 1).
+         *
+         */
+        double uniform();
+
+      private:
+        quint64 m_state; /** generator state. */
+    };
+
+    /** \brief Creates the contents of the given directory.
+     * \param[in] path Directory absolute path.
+     * \param[in] level Levels of directories left below this one.
+     * \param[in] seed Directory seed.
+     *
+     */
+    bool generate(const QString &path, const int level, const quint64 seed);
+
+    static const int POOL_SIZE = 64; /** number of shared names and of reusable seeds per level. */
+
+    const Parameters              m_parameters;  /** tree shape.                               */
+    QMap<int, QVector<quint64>>   m_seeds;       /** seeds of the generated directories by level. */
+    qint64                        m_directories; /** number of directories created.            */
+    qint64                        m_files;       /** number of files created.                  */
+    qint64                        m_bytes;       /** total size of the files created.          */
+};
+
+#endif // TREEGENERATOR_H_
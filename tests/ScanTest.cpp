@@ -0,0 +1,534 @@
+/*
+ File: ScanTest.cpp
+ Created on: 17/10/2026
+ Author: Felix de las Pozas Alvarez
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include "ScanThread.h"
+#include "ResultFile.h"
+#include "Deduplicator.h"
+#include "benchmarks/TreeGenerator.h"
+
+// Qt
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QTemporaryDir>
+#include <QtTest>
+
+// C++
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#endif
+
+Q_DECLARE_METATYPE(ScanOptions::Mode)
+
+namespace
+{
+  /** \struct Directory
+   * \brief Directory of the serial reference matcher.
+   *
+   */
+  struct Directory
+  {
+    QString    path; /** absolute path.                                */
+    QByteArray key;  /** digest of the structure, and of the contents. */
+  };
+
+  //-----------------------------------------------------------------
+  QByteArray describe(const QString &path, const bool contents, QVector<Directory> &directories)
+  {
+    // the entries are hashed by name, the directories with the same key have the same tree.
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const auto filters = QDir::AllEntries|QDir::Hidden|QDir::System|QDir::NoDotAndDotDot;
+    for(const auto &entry: QDir(path).entryInfoList(filters, QDir::Name))
+    {
+      const auto name = entry.fileName().toUtf8();
+      if(entry.isDir())
+      {
+        const auto key = describe(entry.absoluteFilePath(), contents, directories);
+        directories << Directory{entry.absoluteFilePath(), key};
+
+        hash.addData("d" + name + '\0' + key);
+        continue;
+      }
+
+      hash.addData("f" + name + '\0' + QByteArray::number(entry.size()));
+
+      QFile file(entry.absoluteFilePath());
+      if(contents && file.open(QIODevice::ReadOnly))
+      {
+        QCryptographicHash data(QCryptographicHash::Sha1);
+        data.addData(&file);
+        hash.addData(data.result());
+      }
+    }
+
+    return hash.result();
+  }
+
+  //-----------------------------------------------------------------
+  QStringList paths(const QList<DuplicateGroup> &groups)
+  {
+    // one line per group with its sorted paths, the order of the groups doesn't matter.
+    QStringList result;
+    for(const auto &group: groups)
+    {
+      QStringList members;
+      for(int i = 0; i < group.names.size(); ++i)
+      {
+        members << QDir(QDir::fromNativeSeparators(group.parents.at(i))).filePath(group.names.at(i));
+      }
+
+      members.sort();
+      result << members.join(" | ");
+    }
+
+    result.sort();
+
+    return result;
+  }
+
+  //-----------------------------------------------------------------
+  QStringList lines(const QList<DuplicateGroup> &groups)
+  {
+    // everything reported and in the order it was reported.
+    QStringList result;
+    for(const auto &group: groups)
+    {
+      QStringList members;
+      for(int i = 0; i < group.names.size(); ++i)
+      {
+        members << QString("%1%2:%3:%4:%5").arg(group.parents.at(i)).arg(group.names.at(i)).arg(group.sizes.at(i)).arg(group.similarities.at(i)).arg(group.reclaimables.at(i));
+      }
+
+      result << QString::number(group.key) + " " + members.join(" | ");
+    }
+
+    return result;
+  }
+
+  //-----------------------------------------------------------------
+  bool writeFile(const QString &path, const QByteArray &data, const QDateTime &modified)
+  {
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly|QIODevice::Truncate) && file.write(data) == data.size() &&
+           file.setFileTime(modified, QFileDevice::FileModificationTime);
+  }
+
+  //-----------------------------------------------------------------
+  QByteArray readFile(const QString &path)
+  {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+  }
+
+  //-----------------------------------------------------------------
+  quint64 inode(const QString &path)
+  {
+#ifdef Q_OS_LINUX
+    struct stat information;
+    if(::stat(QFile::encodeName(path).constData(), &information) == 0) return information.st_ino;
+#endif
+    return 0;
+  }
+}
+
+/** \class ScanTest
+ * \brief Tests of the scan core on a generated tree: the groups of the matching modes against
+ *        a serial reference matcher and across thread counts, the results files and the
+ *        deduplication of a copied folder.
+ *
+ */
+class ScanTest
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    /** \brief Generates the tree of the tests.
+     *
+     */
+    void initTestCase();
+
+    void matchesReference_data();
+
+    /** \brief Compares the groups of a scan with the ones of a serial matcher that hashes the
+     *        whole tree of every directory.
+     *
+     */
+    void matchesReference();
+
+    void sameAcrossThreads_data();
+
+    /** \brief Compares the groups reported by scans with different numbers of threads.
+     *
+     */
+    void sameAcrossThreads();
+
+    /** \brief Writes the results of a scan, reads them back and compares them with a later scan.
+     *
+     */
+    void resultFileRoundTrip();
+
+    /** \brief Deduplicates a copy of a folder with hard links, first as a dry run.
+     *
+     */
+    void deduplicatorDryRunAndApply();
+
+  private:
+    /** \brief Scans the tree and returns the reported groups in the order they were reported.
+     * \param[in] mode Matching mode.
+     * \param[in] threads Number of traversal threads.
+     * \param[in] resultsFile Results file to write, if not empty.
+     *
+     */
+    QList<DuplicateGroup> scan(const ScanOptions::Mode mode, const int threads, const QString &resultsFile = QString()) const;
+
+    /** \brief Returns the groups of the given mode found by the serial reference matcher, as paths.
+     * \param[in] mode Matching mode, NAMES, STRUCTURE or CONTENT.
+     *
+     */
+    QStringList reference(const ScanOptions::Mode mode) const;
+
+    QTemporaryDir m_directory; /** temporary directory of the test files. */
+    QString       m_root;      /** root of the generated tree.            */
+};
+
+//--------------------------------------------------------------------
+void ScanTest::initTestCase()
+{
+  QVERIFY(m_directory.isValid());
+
+  m_root = QDir(m_directory.path()).canonicalPath() + "/tree";
+  QVERIFY(QDir().mkpath(m_root));
+
+  // small enough to hash every file, with name collisions and copied subtrees in every level.
+  TreeGenerator::Parameters parameters;
+  parameters.seed     = 7;
+  parameters.depth    = 3;
+  parameters.fanout   = 6;
+  parameters.copies   = 0.2;
+  parameters.contents = true;
+  parameters.maxSize  = 16 * 1024;
+
+  TreeGenerator generator(parameters);
+  QVERIFY(generator.generate(m_root));
+  QVERIFY(generator.directories() > 100);
+}
+
+//--------------------------------------------------------------------
+void ScanTest::matchesReference_data()
+{
+  QTest::addColumn<ScanOptions::Mode>("mode");
+  QTest::addColumn<int>("threads");
+
+  QTest::newRow("names serial")      << ScanOptions::Mode::NAMES     << 1;
+  QTest::newRow("names parallel")    << ScanOptions::Mode::NAMES     << 4;
+  QTest::newRow("structure serial")  << ScanOptions::Mode::STRUCTURE << 1;
+  QTest::newRow("structure parallel")<< ScanOptions::Mode::STRUCTURE << 4;
+  QTest::newRow("content serial")    << ScanOptions::Mode::CONTENT   << 1;
+  QTest::newRow("content parallel")  << ScanOptions::Mode::CONTENT   << 4;
+}
+
+//--------------------------------------------------------------------
+void ScanTest::matchesReference()
+{
+  QFETCH(ScanOptions::Mode, mode);
+  QFETCH(int, threads);
+
+  const auto expected = reference(mode);
+  QVERIFY(!expected.isEmpty());
+
+  QCOMPARE(paths(scan(mode, threads)), expected);
+}
+
+//--------------------------------------------------------------------
+void ScanTest::sameAcrossThreads_data()
+{
+  QTest::addColumn<ScanOptions::Mode>("mode");
+
+  QTest::newRow("names")     << ScanOptions::Mode::NAMES;
+  QTest::newRow("structure") << ScanOptions::Mode::STRUCTURE;
+  QTest::newRow("content")   << ScanOptions::Mode::CONTENT;
+  QTest::newRow("similar")   << ScanOptions::Mode::SIMILAR;
+}
+
+//--------------------------------------------------------------------
+void ScanTest::sameAcrossThreads()
+{
+  QFETCH(ScanOptions::Mode, mode);
+
+  const auto serial = lines(scan(mode, 1));
+  QVERIFY(!serial.isEmpty());
+
+  for(const auto threads: {2, 3, 8})
+  {
+    QCOMPARE(lines(scan(mode, threads)), serial);
+  }
+}
+
+//--------------------------------------------------------------------
+void ScanTest::resultFileRoundTrip()
+{
+  const auto fileName = m_directory.filePath("earlier.results");
+  const auto groups   = scan(ScanOptions::Mode::STRUCTURE, 4, fileName);
+  QVERIFY(groups.size() > 2);
+
+  ResultFile file;
+  QVERIFY(file.open(fileName));
+  QVERIFY(file.mode() == ScanOptions::Mode::STRUCTURE);
+  QCOMPARE(file.root(), QDir::toNativeSeparators(m_root));
+  QCOMPARE(file.groups(), static_cast<qint64>(groups.size()));
+
+  // the groups are read back in the order they were reported, with a row per duplicate.
+  qint64 row = 0;
+  for(int i = 0; i < groups.size(); ++i)
+  {
+    const auto &expected = groups.at(i);
+    const auto group     = file.group(i);
+    QCOMPARE(group.key, expected.key);
+    QCOMPARE(group.names, expected.names);
+    QCOMPARE(group.parents, expected.parents);
+    QCOMPARE(group.sizes, expected.sizes);
+    QCOMPARE(group.similarities, expected.similarities);
+    QCOMPARE(group.reclaimables, expected.reclaimables);
+
+    for(int j = 1; j < expected.names.size(); ++j, ++row)
+    {
+      const auto duplicate = file.duplicate(row);
+      QCOMPARE(duplicate.name1, expected.names.first());
+      QCOMPARE(duplicate.parent1, expected.parents.first());
+      QCOMPARE(duplicate.name2, expected.names.at(j));
+      QCOMPARE(duplicate.parent2, expected.parents.at(j));
+      QCOMPARE(duplicate.key, expected.key);
+    }
+  }
+  QCOMPARE(file.rows(), row);
+
+  // a later scan without the first group, with a directory more in the second one and a new group.
+  QSet<quint64> keys;
+  for(const auto &group: groups) keys.insert(group.key);
+
+  DuplicateGroup added;
+  added.key = groups.first().key;
+  while(keys.contains(added.key)) ++added.key;
+  for(const auto &name: {"new 1", "new 2"})
+  {
+    added.names        << name;
+    added.parents      << QDir::toNativeSeparators(m_root + "/");
+    added.sizes        << 1.f;
+    added.similarities << 1.f;
+    added.reclaimables << 0.f;
+  }
+
+  const auto laterName = m_directory.filePath("later.results");
+  ResultFile later;
+  QVERIFY(later.create(laterName, file.root(), file.mode()));
+  for(int i = 1; i < groups.size(); ++i)
+  {
+    auto group = groups.at(i);
+    if(i == 1)
+    {
+      group.names        << "grown";
+      group.parents      << QDir::toNativeSeparators(m_root + "/");
+      group.sizes        << group.sizes.first();
+      group.similarities << 1.f;
+      group.reclaimables << 0.f;
+    }
+
+    later.append(group);
+  }
+  later.append(added);
+  QVERIFY(later.commit());
+  file.close();
+
+  QMap<ResultFile::Change, int> changes;
+  QVERIFY(ResultFile::diff(fileName, laterName, [&changes](const ResultFile::Change change, const DuplicateGroup &, const DuplicateGroup &)
+  { ++changes[change]; }));
+
+  QCOMPARE(changes.value(ResultFile::Change::RESOLVED), 1);
+  QCOMPARE(changes.value(ResultFile::Change::NEW), 1);
+  QCOMPARE(changes.value(ResultFile::Change::GROWN), 1);
+  QCOMPARE(changes.value(ResultFile::Change::UNCHANGED), groups.size() - 2);
+  QCOMPARE(changes.size(), 4);
+}
+
+//--------------------------------------------------------------------
+void ScanTest::deduplicatorDryRunAndApply()
+{
+  if(!Deduplicator::isAvailable()) QSKIP("Deduplication isn't available in this system.");
+
+  // a copy with the same metadata, but for a file that differs in its last byte.
+  const auto original  = m_directory.filePath("original");
+  const auto duplicate = m_directory.filePath("duplicate");
+  QVERIFY(QDir().mkpath(original + "/sub") && QDir().mkpath(duplicate + "/sub"));
+
+  const auto modified = QDateTime::currentDateTime().addDays(-10);
+  const QStringList names{"a.dat", "b.dat", "sub/c.dat", "different.dat"};
+  for(int i = 0; i < names.size(); ++i)
+  {
+    const QByteArray data(4096 * (i + 1), static_cast<char>('a' + i));
+    auto copy = data;
+    if(names.at(i) == "different.dat") copy[copy.size() - 1] = 'z';
+
+    QVERIFY(writeFile(original + "/" + names.at(i), data, modified));
+    QVERIFY(writeFile(duplicate + "/" + names.at(i), copy, modified));
+  }
+
+  QMap<QString, QByteArray> contents;
+  QMap<QString, quint64> inodes;
+  QMap<QString, QFile::Permissions> permissions;
+  for(const auto &name: names)
+  {
+    const auto path = duplicate + "/" + name;
+    contents.insert(name, readFile(path));
+    inodes.insert(name, inode(path));
+    permissions.insert(name, QFileInfo(path).permissions());
+  }
+
+  DeduplicationOptions options;
+  options.method = DeduplicationOptions::Method::HARDLINK;
+  options.dryRun = true;
+
+  {
+    Deduplicator deduplicator(options);
+    deduplicator.add(original, duplicate);
+    deduplicator.start();
+    QVERIFY(deduplicator.wait());
+
+    const auto report = deduplicator.report();
+    QCOMPARE(report.files, static_cast<qint64>(names.size()));
+    QCOMPARE(report.identical, static_cast<qint64>(names.size() - 1));
+    QCOMPARE(report.replaced, static_cast<qint64>(names.size() - 1));
+    QCOMPARE(report.bytes, static_cast<qint64>(4096 * (1 + 2 + 3)));
+    QCOMPARE(report.skipped, static_cast<qint64>(1));
+    QCOMPARE(report.failed, static_cast<qint64>(0));
+  }
+
+  // the dry run leaves the files as they were.
+  for(const auto &name: names)
+  {
+    const auto path = duplicate + "/" + name;
+    QCOMPARE(inode(path), inodes.value(name));
+    QCOMPARE(readFile(path), contents.value(name));
+  }
+
+  options.dryRun = false;
+  {
+    Deduplicator deduplicator(options);
+    deduplicator.add(original, duplicate);
+    deduplicator.start();
+    QVERIFY(deduplicator.wait());
+
+    const auto report = deduplicator.report();
+    QCOMPARE(report.replaced, static_cast<qint64>(names.size() - 1));
+    QCOMPARE(report.skipped, static_cast<qint64>(1));
+    QCOMPARE(report.failed, static_cast<qint64>(0));
+    QVERIFY(report.errors.isEmpty());
+  }
+
+  // the identical files are now the originals, with the same contents and metadata.
+  for(const auto &name: names)
+  {
+    const auto path = duplicate + "/" + name;
+    const QFileInfo info(path);
+    QCOMPARE(readFile(path), contents.value(name));
+    QCOMPARE(info.permissions(), permissions.value(name));
+    QCOMPARE(info.lastModified(), modified);
+
+    if(name == "different.dat") QCOMPARE(inode(path), inodes.value(name));
+    else                        QCOMPARE(inode(path), inode(original + "/" + name));
+  }
+
+  QCOMPARE(QDir(duplicate).entryList(QDir::Files|QDir::Hidden).size(), 3);
+}
+
+//--------------------------------------------------------------------
+QList<DuplicateGroup> ScanTest::scan(const ScanOptions::Mode mode, const int threads, const QString &resultsFile) const
+{
+  ScanOptions options;
+  options.mode        = mode;
+  options.threads     = threads;
+  options.resultsFile = resultsFile;
+  // the reference matcher has no exclusions.
+  options.rules       = ExclusionRules();
+
+  ScanThread thread(QStringList{m_root}, options);
+
+  // the groups are reported from the scan thread, they are taken there as they come.
+  QList<DuplicateGroup> groups;
+  connect(&thread, &ScanThread::foundGroup, [&groups](const DuplicateGroup &group) { groups << group; });
+
+  thread.start();
+  thread.wait();
+
+  return groups;
+}
+
+//--------------------------------------------------------------------
+QStringList ScanTest::reference(const ScanOptions::Mode mode) const
+{
+  QVector<Directory> directories;
+  describe(m_root, mode == ScanOptions::Mode::CONTENT, directories);
+
+  QHash<QString, QByteArray> keys;
+  QMap<QByteArray, QStringList> groups;
+  for(const auto &directory: directories)
+  {
+    keys.insert(directory.path, directory.key);
+
+    const auto key = mode == ScanOptions::Mode::NAMES ? QFileInfo(directory.path).fileName().toLower().toUtf8() : directory.key;
+    groups[key] << directory.path;
+  }
+
+  QStringList result;
+  for(auto members: groups)
+  {
+    if(members.size() < 2) continue;
+
+    // the groups of the subdirectories of the directories of another group are reported by
+    // their parents, the top-level directories have no parent group.
+    if(mode != ScanOptions::Mode::NAMES)
+    {
+      QSet<QString> parents;
+      auto nested = true;
+      for(const auto &member: members)
+      {
+        const auto parent = QFileInfo(member).absolutePath();
+        nested &= parent != m_root && keys.value(parent) == keys.value(QFileInfo(members.first()).absolutePath());
+        parents.insert(parent);
+      }
+
+      if(nested && parents.size() == members.size()) continue;
+    }
+
+    members.sort();
+    result << members.join(" | ");
+  }
+
+  result.sort();
+
+  return result;
+}
+
+QTEST_GUILESS_MAIN(ScanTest)
+
+#include "ScanTest.moc"